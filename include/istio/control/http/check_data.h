@@ -20,6 +20,7 @@
 #include <string>
 
 #include "google/protobuf/struct.pb.h"
+#include "include/istio/utils/deferred_string_map.h"
 
 namespace istio {
 namespace control {
@@ -44,6 +45,19 @@ class CheckData {
   // Get request HTTP headers
   virtual std::map<std::string, std::string> GetRequestHeaders() const = 0;
 
+  // Get request HTTP headers and queries as string maps which are only built
+  // if they are needed, e.g. not for a check answered by the check cache.
+  // They read the request, which must outlive the request handler. Returns
+  // nullptr to use GetRequestHeaders() and GetRequestQueryParams() instead.
+  virtual ::istio::utils::DeferredStringMapPtr GetDeferredRequestHeaders()
+      const {
+    return nullptr;
+  }
+  virtual ::istio::utils::DeferredStringMapPtr GetDeferredRequestQueryParams()
+      const {
+    return nullptr;
+  }
+
   // Returns true if connection is mutual TLS enabled.
   virtual bool IsMutualTLS() const = 0;
 
@@ -105,6 +119,17 @@ class HeaderUpdate {
 
   // Base64 encode data, and add it as "x-istio-attributes" HTTP header.
   virtual void AddIstioAttributes(const std::string &data) = 0;
+
+  // Base64 encode data into the value of "x-istio-attributes" HTTP header,
+  // so a static value is only encoded once. Returns false if not supported.
+  virtual bool EncodeIstioAttributes(const std::string &data,
+                                     std::string *value) const {
+    return false;
+  }
+
+  // Add a value from EncodeIstioAttributes() as "x-istio-attributes" HTTP
+  // header.
+  virtual void AddEncodedIstioAttributes(const std::string &value) {}
 };
 
 }  // namespace http
@@ -57,6 +57,14 @@ class Controller {
     // If it is empty, destination_service is used to lookup
     // service_configs map in the HttpClientConfig.
     std::string service_config_id;
+
+    // The per route service config and its ID, both computed once when the
+    // route config is loaded. If service_config is set, it is used instead
+    // of service_config_id. The service context is then found by the
+    // integer ID, or created from the config if it is new, without calling
+    // LookupServiceConfig() and AddServiceConfig().
+    const ::istio::mixer::v1::config::client::ServiceConfig* service_config{};
+    uint64_t service_config_hash{};
   };
 
   // Creates a HTTP request handler.
@@ -20,6 +20,7 @@
 #include <map>
 
 #include "google/protobuf/struct.pb.h"
+#include "mixer/v1/attributes.pb.h"
 
 namespace istio {
 namespace control {
@@ -34,10 +35,24 @@ class ReportData {
   // Get response HTTP headers.
   virtual std::map<std::string, std::string> GetResponseHeaders() const = 0;
 
+  // Add response HTTP headers directly to the attribute, without the
+  // std::map copy. Returns false to use GetResponseHeaders() instead.
+  virtual bool ExtractResponseHeaders(
+      ::istio::mixer::v1::Attributes_StringMap *) const {
+    return false;
+  }
+
   // Get tracing headers from HTTP request headers.
   virtual void GetTracingHeaders(
       std::map<std::string, std::string> &) const = 0;
 
+  // Add tracing headers directly to the attribute. Returns false to use
+  // GetTracingHeaders() instead.
+  virtual bool ExtractTracingHeaders(
+      ::istio::mixer::v1::Attributes_StringMap *) const {
+    return false;
+  }
+
   // Get additional report info.
   struct ReportInfo {
     uint64_t response_total_size;
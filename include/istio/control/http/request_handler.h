@@ -43,6 +43,12 @@ class RequestHandler {
 
   virtual void CancelCheck() = 0;
 
+  // Called when the Check call is still pending after Check() returns.
+  // Returns true if the service config lets the request body stream
+  // upstream until the call is done, in which case the caller must reset
+  // the request if the call denies it.
+  virtual bool StartOptimisticStreaming() { return false; }
+
   // Make a Report call. It will:
   // * check service config to see if Report is required
   // * extract check attributes if not done yet.
@@ -16,12 +16,49 @@
 #ifndef ISTIO_MIXERCLIENT_CHECK_RESPONSE_H
 #define ISTIO_MIXERCLIENT_CHECK_RESPONSE_H
 
+#include <memory>
+
 #include "google/protobuf/stubs/status.h"
 #include "mixer/v1/mixer.pb.h"
 
 namespace istio {
 namespace mixerclient {
 
+// The data a proxy compiles from a route directive, such as its header
+// operations.
+class CompiledRouteDirective {
+ public:
+  virtual ~CompiledRouteDirective() {}
+};
+
+// A non-empty route directive, shared by a check cache entry and all its
+// cache hits. The directive is compiled by the proxy once, and then cached
+// with the entry. It is not thread-safe, a check cache is used by one
+// worker thread.
+class SharedRouteDirective {
+ public:
+  SharedRouteDirective(const ::istio::mixer::v1::RouteDirective& directive)
+      : directive_(directive) {}
+
+  const ::istio::mixer::v1::RouteDirective& directive() const {
+    return directive_;
+  }
+
+  // The compiled directive, or nullptr if it is not compiled yet.
+  const CompiledRouteDirective* compiled() const { return compiled_.get(); }
+
+  void set_compiled(std::unique_ptr<const CompiledRouteDirective> compiled)
+      const {
+    compiled_ = std::move(compiled);
+  }
+
+ private:
+  const ::istio::mixer::v1::RouteDirective directive_;
+  mutable std::unique_ptr<const CompiledRouteDirective> compiled_;
+};
+
+typedef std::shared_ptr<const SharedRouteDirective> SharedRouteDirectivePtr;
+
 // The CheckResponseInfo exposes policy and quota check details to the check
 // callbacks.
 class CheckResponseInfo {
@@ -31,6 +68,9 @@ class CheckResponseInfo {
   virtual const ::google::protobuf::util::Status& status() const = 0;
 
   virtual const ::istio::mixer::v1::RouteDirective& routeDirective() const = 0;
+
+  // The route directive, or nullptr if it is empty.
+  virtual SharedRouteDirectivePtr sharedRouteDirective() const = 0;
 };
 
 }  // namespace mixerclient
@@ -125,6 +125,26 @@ struct Statistics {
   uint64_t total_remote_report_send_errors_{0};  // 1.1
   // Remote report calls that fail do to some other error
   uint64_t total_remote_report_other_errors_{0};  // 1.1
+
+  //
+  // Attribute size counters
+  //
+
+  // Bytes of request and response headers dropped by the header projections
+  // of the service configs.
+  uint64_t total_header_bytes_saved_{0};
+
+  //
+  // Optimistic streaming counters
+  //
+
+  // Requests whose body streamed upstream while their Check call was
+  // pending.
+  uint64_t total_optimistic_streams_{0};
+  // Those of them reset since the Check call denied them.
+  uint64_t total_optimistic_stream_resets_{0};
+  // Milliseconds their bodies would have waited for the Check calls.
+  uint64_t total_optimistic_streaming_saved_ms_{0};
 };
 
 class MixerClient {
@@ -0,0 +1,53 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ISTIO_UTILS_DEFERRED_STRING_MAP_H
+#define ISTIO_UTILS_DEFERRED_STRING_MAP_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mixer/v1/attributes.pb.h"
+
+namespace istio {
+namespace utils {
+
+// A string map attribute which is only built when it is needed, such as
+// request.headers of a request whose check is answered by the check cache.
+// Find() must agree with Build(), the attribute is absent if Build() adds no
+// entries.
+class DeferredStringMap {
+ public:
+  virtual ~DeferredStringMap() {}
+
+  // Finds one entry without building the map.
+  virtual bool Find(const std::string &key, std::string *value) const = 0;
+
+  // Adds all entries to the map.
+  virtual void Build(::istio::mixer::v1::Attributes_StringMap *map) const = 0;
+};
+
+typedef std::unique_ptr<DeferredStringMap> DeferredStringMapPtr;
+
+// Deferred string maps by attribute name.
+typedef std::vector<std::pair<std::string, DeferredStringMapPtr>>
+    DeferredStringMaps;
+
+}  // namespace utils
+}  // namespace istio
+
+#endif  // ISTIO_UTILS_DEFERRED_STRING_MAP_H
@@ -18,6 +18,7 @@
 #include "common/common/assert.h"
 #include "common/config/metadata.h"
 #include "src/envoy/http/authn/authn_utils.h"
+#include "src/envoy/utils/connection_identity.h"
 #include "src/envoy/utils/filter_names.h"
 #include "src/envoy/utils/utils.h"
 
@@ -50,8 +51,9 @@ AuthenticatorBase::~AuthenticatorBase() {}
 
 bool AuthenticatorBase::validateTrustDomain(
     const Network::Connection* connection) const {
+  const auto& identity = Utils::ConnectionIdentity::get(*connection);
   std::string peer_trust_domain;
-  if (!Utils::GetTrustDomain(connection, true, &peer_trust_domain)) {
+  if (!identity.trustDomain(true, &peer_trust_domain)) {
     ENVOY_CONN_LOG(
         error, "trust domain validation failed: cannot get peer trust domain",
         *connection);
@@ -59,7 +61,7 @@ bool AuthenticatorBase::validateTrustDomain(
   }
 
   std::string local_trust_domain;
-  if (!Utils::GetTrustDomain(connection, false, &local_trust_domain)) {
+  if (!identity.trustDomain(false, &local_trust_domain)) {
     ENVOY_CONN_LOG(
         error, "trust domain validation failed: cannot get local trust domain",
         *connection);
@@ -87,11 +89,10 @@ bool AuthenticatorBase::validateX509(const iaapi::MutualTls& mtls,
     return false;
   }
   // Always try to get principal and set to output if available.
+  const auto& identity = Utils::ConnectionIdentity::get(*connection);
   const bool has_user =
-      connection->ssl() != nullptr &&
-      connection->ssl()->peerCertificatePresented() &&
-      Utils::GetPrincipal(connection, true,
-                          payload->mutable_x509()->mutable_user());
+      identity.mutualTLS() &&
+      identity.principal(true, payload->mutable_x509()->mutable_user());
 
   ENVOY_CONN_LOG(debug, "validateX509 mode {}: ssl={}, has_user={}",
                  *connection, iaapi::MutualTls::Mode_Name(mtls.mode()),
@@ -122,6 +123,13 @@ bool AuthenticatorBase::validateX509(const iaapi::MutualTls& mtls,
 }
 
 bool AuthenticatorBase::validateJwt(const iaapi::Jwt& jwt, Payload* payload) {
+  if (!FindHeaderOfExchangedToken(jwt)) {
+    // Use the claims the Istio jwt filter parsed while verifying the token.
+    auto claims = filter_context()->getJwtClaims(jwt.issuer());
+    if (claims != nullptr) {
+      return AuthnUtils::ProcessJwtClaims(*claims, payload->mutable_jwt());
+    }
+  }
   std::string jwt_payload;
   if (filter_context()->getJwtPayload(jwt.issuer(), &jwt_payload)) {
     std::string payload_to_process = jwt_payload;
@@ -24,12 +24,14 @@
 #include "src/envoy/utils/filter_names.h"
 #include "test/mocks/network/mocks.h"
 #include "test/mocks/ssl/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
 
 using google::protobuf::util::MessageDifferencer;
 using istio::authn::Payload;
 using istio::envoy::config::filter::http::authn::v2alpha1::FilterConfig;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnRef;
 using testing::StrictMock;
 
 namespace iaapi = istio::authentication::v1alpha1;
@@ -86,8 +88,12 @@ class MockAuthenticatorBase : public AuthenticatorBase {
 class ValidateX509Test : public testing::TestWithParam<iaapi::MutualTls::Mode>,
                          public Logger::Loggable<Logger::Id::filter> {
  public:
+  ValidateX509Test() {
+    ON_CALL(connection_, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  }
   virtual ~ValidateX509Test() {}
 
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_{};
   NiceMock<Envoy::Network::MockConnection> connection_{};
   Envoy::Http::HeaderMapImpl header_{};
   FilterConfig filter_config_{};
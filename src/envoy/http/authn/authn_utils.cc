@@ -40,56 +40,53 @@ static const std::string kExchangedTokenOriginalPayload = "original_claims";
 // A string claim is extracted as a string list of 1 item.
 // A string claim with whitespace is extracted as a string list with each
 // sub-string delimited with the whitespace.
-void ExtractStringList(const std::string& key, const Envoy::Json::Object& obj,
-                       std::vector<std::string>* list) {
-  // First, try as string
-  try {
-    // Try as string, will throw execption if object type is not string.
-    const std::vector<std::string> keys =
-        absl::StrSplit(obj.getString(key), ' ', absl::SkipEmpty());
-    for (auto key : keys) {
+void ExtractStringList(const JwtAuth::JwtClaims& jwt_claims,
+                       const JwtAuth::JwtClaims::Claim& claim,
+                       std::vector<absl::string_view>* list) {
+  if (claim.type == JwtAuth::JwtClaims::Type::STRING) {
+    for (absl::string_view key : absl::StrSplit(
+             jwt_claims.Strings(claim)[0], ' ', absl::SkipEmpty())) {
       list->push_back(key);
     }
-  } catch (Json::Exception& e) {
-    // Not convertable to string
-  }
-  // Next, try as string array
-  try {
-    std::vector<std::string> vector = obj.getStringArray(key);
-    for (const std::string v : vector) {
+  } else if (claim.type == JwtAuth::JwtClaims::Type::STRING_ARRAY) {
+    for (absl::string_view v : jwt_claims.Strings(claim)) {
       list->push_back(v);
     }
-  } catch (Json::Exception& e) {
-    // Not convertable to string array
   }
 }
 };  // namespace
 
 bool AuthnUtils::ProcessJwtPayload(const std::string& payload_str,
                                    istio::authn::JwtPayload* payload) {
-  Envoy::Json::ObjectSharedPtr json_obj;
-  try {
-    json_obj = Json::Factory::loadFromString(payload_str);
-    ENVOY_LOG(debug, "{}: json object is {}", __FUNCTION__,
-              json_obj->asJsonString());
-  } catch (...) {
+  JwtAuth::JwtClaims jwt_claims;
+  if (!jwt_claims.Parse(payload_str)) {
     return false;
   }
+  ENVOY_LOG(debug, "{}: json object is {}", __FUNCTION__, payload_str);
+  return ProcessJwtClaims(jwt_claims, payload);
+}
 
-  *payload->mutable_raw_claims() = payload_str;
+bool AuthnUtils::ProcessJwtClaims(const JwtAuth::JwtClaims& jwt_claims,
+                                  istio::authn::JwtPayload* payload) {
+  *payload->mutable_raw_claims() = jwt_claims.json();
 
   auto claims = payload->mutable_claims()->mutable_fields();
   // Extract claims as string lists
-  json_obj->iterate([json_obj, claims](const std::string& key,
-                                       const Json::Object&) -> bool {
+  std::vector<absl::string_view> list;
+  for (const auto& claim : jwt_claims.claims()) {
     // In current implementation, only string/string list objects are extracted
-    std::vector<std::string> list;
-    ExtractStringList(key, *json_obj, &list);
-    for (auto s : list) {
-      (*claims)[key].mutable_list_value()->add_values()->set_string_value(s);
+    list.clear();
+    ExtractStringList(jwt_claims, claim, &list);
+    if (list.empty()) {
+      continue;
     }
-    return true;
-  });
+    auto* values = (*claims)[std::string(claim.name)]
+                       .mutable_list_value()
+                       ->mutable_values();
+    for (absl::string_view s : list) {
+      values->Add()->set_string_value(s.data(), s.size());
+    }
+  }
   // Copy audience to the audience in context.proto
   if (claims->find(kJwtAudienceKey) != claims->end()) {
     for (const auto& v : (*claims)[kJwtAudienceKey].list_value().values()) {
@@ -20,6 +20,7 @@
 #include "common/common/utility.h"
 #include "envoy/http/header_map.h"
 #include "envoy/json/json_object.h"
+#include "src/envoy/http/jwt_auth/jwt_claims.h"
 #include "src/istio/authn/context.pb.h"
 
 namespace iaapi = istio::authentication::v1alpha1;
@@ -38,6 +39,10 @@ class AuthnUtils : public Logger::Loggable<Logger::Id::filter> {
   static bool ProcessJwtPayload(const std::string& jwt_payload_str,
                                 istio::authn::JwtPayload* payload);
 
+  // Populates JwtPayload object from the claims of a JWT payload.
+  static bool ProcessJwtClaims(const JwtAuth::JwtClaims& jwt_claims,
+                               istio::authn::JwtPayload* payload);
+
   // Parses the original_payload in an exchanged JWT.
   // Returns true if original_payload can be
   // parsed successfully. Otherwise, returns false.
@@ -81,6 +81,29 @@ bool FilterContext::getJwtPayload(const std::string& issuer,
          getJwtPayloadFromIstioJwtFilter(issuer, payload);
 }
 
+JwtAuth::JwtClaimsConstSharedPtr FilterContext::getJwtClaims(
+    const std::string& issuer) const {
+  const std::string& key = JwtAuth::VerifiedJwtClaims::key();
+  if (filter_state_ == nullptr ||
+      !filter_state_->hasData<JwtAuth::VerifiedJwtClaims>(key)) {
+    return nullptr;
+  }
+  auto filter_it = dynamic_metadata_.filter_metadata().find(
+      Extensions::HttpFilters::HttpFilterNames::get().JwtAuthn);
+  if (filter_it != dynamic_metadata_.filter_metadata().end() &&
+      filter_it->second.fields().count(issuer) > 0) {
+    return nullptr;
+  }
+  const auto& by_issuer =
+      filter_state_->getDataReadOnly<JwtAuth::VerifiedJwtClaims>(key)
+          .by_issuer;
+  auto claims_it = by_issuer.find(issuer);
+  if (claims_it == by_issuer.end()) {
+    return nullptr;
+  }
+  return claims_it->second;
+}
+
 bool FilterContext::getJwtPayloadFromEnvoyJwtFilter(
     const std::string& issuer, std::string* payload) const {
   // Try getting the Jwt payload from Envoy jwt_authn filter.
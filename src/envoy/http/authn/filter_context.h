@@ -22,6 +22,7 @@
 #include "envoy/http/filter.h"
 #include "envoy/network/connection.h"
 #include "extensions/filters/http/well_known_names.h"
+#include "src/envoy/http/jwt_auth/jwt_claims.h"
 #include "src/istio/authn/context.pb.h"
 
 namespace Envoy {
@@ -37,11 +38,13 @@ class FilterContext : public Logger::Loggable<Logger::Id::filter> {
       const envoy::api::v2::core::Metadata& dynamic_metadata,
       const HeaderMap& header_map, const Network::Connection* connection,
       const istio::envoy::config::filter::http::authn::v2alpha1::FilterConfig&
-          filter_config)
+          filter_config,
+      const StreamInfo::FilterState* filter_state = nullptr)
       : dynamic_metadata_(dynamic_metadata),
         header_map_(header_map),
         connection_(connection),
-        filter_config_(filter_config) {}
+        filter_config_(filter_config),
+        filter_state_(filter_state) {}
   virtual ~FilterContext() {}
 
   // Sets peer result based on authenticated payload. Input payload can be null,
@@ -61,7 +64,7 @@ class FilterContext : public Logger::Loggable<Logger::Id::filter> {
   const istio::authn::Result& authenticationResult() { return result_; }
 
   // Accessor to connection
-  const Network::Connection* connection() { return connection_; }
+  const Network::Connection* connection() const { return connection_; }
   // Accessor to the filter config
   const istio::envoy::config::filter::http::authn::v2alpha1::FilterConfig&
   filter_config() const {
@@ -73,8 +76,19 @@ class FilterContext : public Logger::Loggable<Logger::Id::filter> {
   // returns false.
   bool getJwtPayload(const std::string& issuer, std::string* payload) const;
 
+  // Gets the claims of the JWT payload for given issuer, as parsed by the
+  // Istio jwt filter. Returns nullptr if they are not available, or if
+  // getJwtPayload() would prefer the payload of the Envoy jwt filter.
+  JwtAuth::JwtClaimsConstSharedPtr getJwtClaims(
+      const std::string& issuer) const;
+
   const HeaderMap& headerMap() const { return header_map_; }
 
+  // Accessor to the request dynamic metadata.
+  const envoy::api::v2::core::Metadata& dynamicMetadata() const {
+    return dynamic_metadata_;
+  }
+
  private:
   // Helper function for getJwtPayload(). It gets the jwt payload from Envoy jwt
   // filter metadata and write to |payload|.
@@ -102,6 +116,10 @@ class FilterContext : public Logger::Loggable<Logger::Id::filter> {
   // Store the Istio authn filter config.
   const istio::envoy::config::filter::http::authn::v2alpha1::FilterConfig&
       filter_config_;
+
+  // Filter state of the request, which holds the JWT claims parsed by the
+  // Istio jwt filter. It is null if not given.
+  const StreamInfo::FilterState* filter_state_;
 };
 
 }  // namespace AuthN
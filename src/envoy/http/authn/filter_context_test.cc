@@ -15,6 +15,7 @@
 
 #include "src/envoy/http/authn/filter_context.h"
 
+#include "common/stream_info/filter_state_impl.h"
 #include "envoy/api/v2/core/base.pb.h"
 #include "src/envoy/http/authn/test_utils.h"
 #include "test/test_common/utility.h"
@@ -122,6 +123,33 @@ TEST_F(FilterContextTest, PrincipalUsePeerOnEmptyPeer) {
                                       filter_context_.authenticationResult()));
 }
 
+TEST(FilterContextJwtClaimsTest, GetJwtClaims) {
+  envoy::api::v2::core::Metadata metadata;
+  Envoy::Http::TestHeaderMapImpl header{};
+  StreamInfo::FilterStateImpl filter_state;
+  FilterContext filter_context{metadata, header, nullptr,
+                               istio::envoy::config::filter::http::authn::
+                                   v2alpha1::FilterConfig::default_instance(),
+                               &filter_state};
+  EXPECT_EQ(filter_context.getJwtClaims("issuer"), nullptr);
+
+  auto claims = std::make_shared<JwtAuth::JwtClaims>();
+  ASSERT_TRUE(claims->Parse(R"({"iss": "issuer", "sub": "user"})"));
+  auto verified = std::make_unique<JwtAuth::VerifiedJwtClaims>();
+  verified->by_issuer["issuer"] = claims;
+  filter_state.setData(JwtAuth::VerifiedJwtClaims::key(), std::move(verified),
+                       StreamInfo::FilterState::StateType::Mutable);
+  EXPECT_EQ(filter_context.getJwtClaims("issuer"), claims);
+  EXPECT_EQ(filter_context.getJwtClaims("other"), nullptr);
+
+  // The payload from the Envoy jwt filter takes precedence.
+  (*(*metadata.mutable_filter_metadata())
+        [Extensions::HttpFilters::HttpFilterNames::get().JwtAuthn]
+            .mutable_fields())["issuer"]
+      .mutable_struct_value();
+  EXPECT_EQ(filter_context.getJwtClaims("issuer"), nullptr);
+}
+
 }  // namespace
 }  // namespace AuthN
 }  // namespace Istio
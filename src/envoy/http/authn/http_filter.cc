@@ -40,8 +40,12 @@ struct RcDetailsValues {
 };
 typedef ConstSingleton<RcDetailsValues> RcDetails;
 
-AuthenticationFilter::AuthenticationFilter(const FilterConfig& filter_config)
-    : filter_config_(filter_config) {}
+AuthenticationFilter::AuthenticationFilter(
+    const FilterConfig& filter_config,
+    const OriginTriggerMatchers* origin_triggers, ResultCache* result_cache)
+    : filter_config_(filter_config),
+      origin_triggers_(origin_triggers),
+      result_cache_(result_cache) {}
 
 AuthenticationFilter::~AuthenticationFilter() {}
 
@@ -57,7 +61,22 @@ FilterHeadersStatus AuthenticationFilter::decodeHeaders(HeaderMap& headers,
 
   filter_context_.reset(new Istio::AuthN::FilterContext(
       decoder_callbacks_->streamInfo().dynamicMetadata(), headers,
-      decoder_callbacks_->connection(), filter_config_));
+      decoder_callbacks_->connection(), filter_config_,
+      &decoder_callbacks_->streamInfo().filterState()));
+
+  std::string cache_key;
+  if (result_cache_ != nullptr) {
+    cache_key = result_cache_->Key(*filter_context_);
+    auto data = result_cache_->Lookup(cache_key);
+    if (data != nullptr) {
+      decoder_callbacks_->streamInfo().setDynamicMetadata(
+          Utils::IstioFilterName::kAuthentication, *data);
+      ENVOY_LOG(debug, "Saved cached Dynamic Metadata:\n{}",
+                data->DebugString());
+      state_ = State::COMPLETE;
+      return FilterHeadersStatus::Continue;
+    }
+  }
 
   Payload payload;
 
@@ -86,6 +105,9 @@ FilterHeadersStatus AuthenticationFilter::decodeHeaders(HeaderMap& headers,
     decoder_callbacks_->streamInfo().setDynamicMetadata(
         Utils::IstioFilterName::kAuthentication, data);
     ENVOY_LOG(debug, "Saved Dynamic Metadata:\n{}", data.DebugString());
+    if (result_cache_ != nullptr) {
+      result_cache_->Insert(cache_key, data);
+    }
   }
   state_ = State::COMPLETE;
   return FilterHeadersStatus::Continue;
@@ -131,7 +153,7 @@ std::unique_ptr<Istio::AuthN::AuthenticatorBase>
 AuthenticationFilter::createOriginAuthenticator(
     Istio::AuthN::FilterContext* filter_context) {
   return std::make_unique<Istio::AuthN::OriginAuthenticator>(
-      filter_context, filter_config_.policy());
+      filter_context, filter_config_.policy(), origin_triggers_);
 }
 
 }  // namespace AuthN
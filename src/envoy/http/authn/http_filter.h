@@ -20,6 +20,8 @@
 #include "envoy/http/filter.h"
 #include "src/envoy/http/authn/authenticator_base.h"
 #include "src/envoy/http/authn/filter_context.h"
+#include "src/envoy/http/authn/result_cache.h"
+#include "src/envoy/http/authn/trigger_rule_matcher.h"
 
 namespace Envoy {
 namespace Http {
@@ -32,7 +34,9 @@ class AuthenticationFilter : public StreamDecoderFilter,
  public:
   AuthenticationFilter(
       const istio::envoy::config::filter::http::authn::v2alpha1::FilterConfig&
-          config);
+          config,
+      const OriginTriggerMatchers* origin_triggers = nullptr,
+      ResultCache* result_cache = nullptr);
   ~AuthenticationFilter();
 
   // Http::StreamFilterBase
@@ -68,6 +72,14 @@ class AuthenticationFilter : public StreamDecoderFilter,
   const istio::envoy::config::filter::http::authn::v2alpha1::FilterConfig&
       filter_config_;
 
+  // The compiled trigger rules of the policy origins, owned by the factory.
+  // The origin authenticator compiles them itself if this is null.
+  const OriginTriggerMatchers* origin_triggers_;
+
+  // The result cache of the worker for the filter config, results are not
+  // cached if this is null.
+  ResultCache* result_cache_;
+
   StreamDecoderFilterCallbacks* decoder_callbacks_{};
 
   enum State { INIT, PROCESSING, COMPLETE, REJECTED };
@@ -34,7 +34,7 @@ class AuthnFilterConfig : public NamedHttpFilterConfigFactory,
  public:
   Http::FilterFactoryCb createFilterFactory(const Json::Object& config,
                                             const std::string&,
-                                            FactoryContext&) override {
+                                            FactoryContext& context) override {
     ENVOY_LOG(debug, "Called AuthnFilterConfig : {}", __func__);
     FilterConfig filter_config;
     google::protobuf::util::Status status =
@@ -48,14 +48,14 @@ class AuthnFilterConfig : public NamedHttpFilterConfigFactory,
           "is: " +
           status.ToString());
     }
-    return createFilterFactory(filter_config);
+    return createFilterFactory(filter_config, context);
   }
 
   Http::FilterFactoryCb createFilterFactoryFromProto(
       const Protobuf::Message& proto_config, const std::string&,
-      FactoryContext&) override {
+      FactoryContext& context) override {
     auto filter_config = dynamic_cast<const FilterConfig&>(proto_config);
-    return createFilterFactory(filter_config);
+    return createFilterFactory(filter_config, context);
   }
 
   ProtobufTypes::MessagePtr createEmptyConfigProto() override {
@@ -68,7 +68,8 @@ class AuthnFilterConfig : public NamedHttpFilterConfigFactory,
   }
 
  private:
-  Http::FilterFactoryCb createFilterFactory(const FilterConfig& config_pb) {
+  Http::FilterFactoryCb createFilterFactory(const FilterConfig& config_pb,
+                                            FactoryContext& context) {
     ENVOY_LOG(debug, "Called AuthnFilterConfig : {}", __func__);
     // Make it shared_ptr so that the object is still reachable when callback is
     // invoked.
@@ -78,12 +79,28 @@ class AuthnFilterConfig : public NamedHttpFilterConfigFactory,
     // Print a log to remind user to upgrade to the mTLS setting. This will only
     // be called when a new config is received by Envoy.
     warnPermissiveMode(*filter_config);
-    return
-        [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
-          callbacks.addStreamDecoderFilter(
-              std::make_shared<Http::Istio::AuthN::AuthenticationFilter>(
-                  *filter_config));
-        };
+    // Compile the trigger rules once instead of for every request. Throws
+    // EnvoyException for regexes which can't be compiled, rather than
+    // skipping the JWT of the paths they should have included.
+    auto origin_triggers =
+        std::make_shared<const Http::Istio::AuthN::OriginTriggerMatchers>(
+            filter_config->policy());
+    // Each worker caches the results of the policy for the requests it
+    // authenticates.
+    std::shared_ptr<ThreadLocal::Slot> result_cache =
+        context.threadLocal().allocateSlot();
+    result_cache->set([filter_config, origin_triggers](Event::Dispatcher&)
+                          -> ThreadLocal::ThreadLocalObjectSharedPtr {
+      return std::make_shared<Http::Istio::AuthN::ResultCache>(
+          filter_config->policy(), origin_triggers);
+    });
+    return [filter_config, origin_triggers, result_cache](
+               Http::FilterChainFactoryCallbacks& callbacks) -> void {
+      callbacks.addStreamDecoderFilter(
+          std::make_shared<Http::Istio::AuthN::AuthenticationFilter>(
+              *filter_config, origin_triggers.get(),
+              &result_cache->getTyped<Http::Istio::AuthN::ResultCache>()));
+    };
   }
 
   void warnPermissiveMode(const FilterConfig& filter_config) {
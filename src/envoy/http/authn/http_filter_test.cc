@@ -87,8 +87,9 @@ class MockAuthenticationFilter : public AuthenticationFilter {
  public:
   // We'll use fake authenticator for test, so policy is not really needed. Use
   // default config for simplicity.
-  MockAuthenticationFilter(const FilterConfig &filter_config)
-      : AuthenticationFilter(filter_config) {}
+  MockAuthenticationFilter(const FilterConfig &filter_config,
+                           ResultCache *result_cache = nullptr)
+      : AuthenticationFilter(filter_config, nullptr, result_cache) {}
 
   ~MockAuthenticationFilter(){};
 
@@ -211,6 +212,50 @@ TEST_F(AuthenticationFilterTest, AllPass) {
   EXPECT_TRUE(TestUtility::protoEqual(expected_data, *data));
 }
 
+TEST_F(AuthenticationFilterTest, CachedResult) {
+  ResultCache result_cache(filter_config_.policy(),
+                           std::make_shared<const OriginTriggerMatchers>(
+                               filter_config_.policy()));
+  DangerousDeprecatedTestTime test_time;
+  StreamInfo::StreamInfoImpl stream_info(Http::Protocol::Http2,
+                                         test_time.timeSystem());
+  EXPECT_CALL(decoder_callbacks_, streamInfo())
+      .Times(AtLeast(1))
+      .WillRepeatedly(ReturnRef(stream_info));
+
+  StrictMock<MockAuthenticationFilter> filter(filter_config_, &result_cache);
+  filter.setDecoderFilterCallbacks(decoder_callbacks_);
+  EXPECT_CALL(filter, createPeerAuthenticator(_))
+      .Times(1)
+      .WillOnce(Invoke(createAlwaysPassAuthenticator));
+  EXPECT_CALL(filter, createOriginAuthenticator(_))
+      .Times(1)
+      .WillOnce(Invoke(createAlwaysPassAuthenticator));
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            filter.decodeHeaders(request_headers_, true));
+  EXPECT_EQ(1, result_cache.Size());
+
+  // The next request with the same peer and tokens skips the authenticators.
+  StreamInfo::StreamInfoImpl cached_stream_info(Http::Protocol::Http2,
+                                                test_time.timeSystem());
+  EXPECT_CALL(decoder_callbacks_, streamInfo())
+      .Times(AtLeast(1))
+      .WillRepeatedly(ReturnRef(cached_stream_info));
+  StrictMock<MockAuthenticationFilter> cached_filter(filter_config_,
+                                                     &result_cache);
+  cached_filter.setDecoderFilterCallbacks(decoder_callbacks_);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue,
+            cached_filter.decodeHeaders(request_headers_, true));
+
+  const auto *data = Utils::Authentication::GetResultFromMetadata(
+      cached_stream_info.dynamicMetadata());
+  ASSERT_TRUE(data);
+  EXPECT_TRUE(TestUtility::protoEqual(
+      *Utils::Authentication::GetResultFromMetadata(
+          stream_info.dynamicMetadata()),
+      *data));
+}
+
 TEST_F(AuthenticationFilterTest, IgnoreBothFail) {
   iaapi::Policy policy_;
   ASSERT_TRUE(
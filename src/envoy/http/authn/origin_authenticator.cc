@@ -18,7 +18,6 @@
 #include "absl/strings/match.h"
 #include "authentication/v1alpha1/policy.pb.h"
 #include "common/http/headers.h"
-#include "src/envoy/http/authn/authn_utils.h"
 
 using istio::authn::Payload;
 
@@ -39,8 +38,14 @@ bool isCORSPreflightRequest(const Http::HeaderMap& headers) {
 }
 
 OriginAuthenticator::OriginAuthenticator(FilterContext* filter_context,
-                                         const iaapi::Policy& policy)
-    : AuthenticatorBase(filter_context), policy_(policy) {}
+                                         const iaapi::Policy& policy,
+                                         const OriginTriggerMatchers* triggers)
+    : AuthenticatorBase(filter_context), policy_(policy), triggers_(triggers) {
+  if (triggers_ == nullptr) {
+    owned_triggers_ = std::make_unique<OriginTriggerMatchers>(policy_);
+    triggers_ = owned_triggers_.get();
+  }
+}
 
 bool OriginAuthenticator::run(Payload* payload) {
   if (policy_.origins_size() == 0 &&
@@ -77,10 +82,10 @@ bool OriginAuthenticator::run(Payload* payload) {
 
   bool triggered = false;
   bool triggered_success = false;
-  for (const auto& method : policy_.origins()) {
-    const auto& jwt = method.jwt();
+  for (int i = 0; i < policy_.origins_size(); ++i) {
+    const auto& jwt = policy_.origins(i).jwt();
 
-    if (AuthnUtils::ShouldValidateJwtPerPath(request_path, jwt)) {
+    if (triggers_->origin(i).ShouldValidate(request_path)) {
       ENVOY_LOG(debug, "Validating request path {} for jwt {}", request_path,
                 jwt.DebugString());
       // set triggered to true if any of the jwt trigger rule matched.
@@ -17,17 +17,25 @@
 
 #include "authentication/v1alpha1/policy.pb.h"
 #include "src/envoy/http/authn/authenticator_base.h"
+#include "src/envoy/http/authn/trigger_rule_matcher.h"
 
 namespace Envoy {
 namespace Http {
 namespace Istio {
 namespace AuthN {
 
+// Returns true if the request is a CORS preflight, which origin
+// authentication always allows.
+bool isCORSPreflightRequest(const Http::HeaderMap& headers);
+
 // OriginAuthenticator performs origin authentication for given credential rule.
 class OriginAuthenticator : public AuthenticatorBase {
  public:
+  // The trigger rules of the policy are compiled here unless the caller
+  // passes them compiled already.
   OriginAuthenticator(FilterContext* filter_context,
-                      const istio::authentication::v1alpha1::Policy& policy);
+                      const istio::authentication::v1alpha1::Policy& policy,
+                      const OriginTriggerMatchers* triggers = nullptr);
 
   bool run(istio::authn::Payload*) override;
 
@@ -35,6 +43,9 @@ class OriginAuthenticator : public AuthenticatorBase {
   // Reference to the authentication policy that the authenticator should
   // enforce. Typically, the actual object is owned by filter.
   const istio::authentication::v1alpha1::Policy& policy_;
+  // Set if the trigger rules were not passed to the constructor.
+  std::unique_ptr<OriginTriggerMatchers> owned_triggers_;
+  const OriginTriggerMatchers* triggers_;
 };
 
 }  // namespace AuthN
@@ -0,0 +1,188 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/authn/result_cache.h"
+
+#include <algorithm>
+
+#include "extensions/filters/http/well_known_names.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "openssl/sha.h"
+#include "src/envoy/http/authn/origin_authenticator.h"
+#include "src/envoy/utils/connection_identity.h"
+#include "src/envoy/utils/filter_names.h"
+
+namespace iaapi = istio::authentication::v1alpha1;
+
+namespace Envoy {
+namespace Http {
+namespace Istio {
+namespace AuthN {
+namespace {
+
+// Appends an optional value with its length, so the fields of a key can not
+// run into each other.
+void AppendField(bool present, absl::string_view value, std::string* key) {
+  if (!present) {
+    key->push_back('-');
+    return;
+  }
+  key->append(std::to_string(value.size()));
+  key->push_back(':');
+  key->append(value.data(), value.size());
+}
+
+void UpdateDigest(absl::string_view value, SHA256_CTX* ctx) {
+  const uint64_t size = value.size();
+  SHA256_Update(ctx, &size, sizeof(size));
+  SHA256_Update(ctx, value.data(), value.size());
+}
+
+// Returns the field of issuer in the dynamic metadata of filter_name, or
+// nullptr if there is none.
+const ProtobufWkt::Value* FindIssuer(
+    const envoy::api::v2::core::Metadata& metadata,
+    const std::string& filter_name, const std::string& issuer) {
+  auto filter_it = metadata.filter_metadata().find(filter_name);
+  if (filter_it == metadata.filter_metadata().end()) {
+    return nullptr;
+  }
+  auto entry_it = filter_it->second.fields().find(issuer);
+  if (entry_it == filter_it->second.fields().end()) {
+    return nullptr;
+  }
+  return &entry_it->second;
+}
+
+}  // namespace
+
+ResultCache::ResultCache(const iaapi::Policy& policy,
+                         OriginTriggerMatchersConstSharedPtr origin_triggers,
+                         int64_t max_entries)
+    : num_origins_(policy.origins_size()),
+      origin_triggers_(std::move(origin_triggers)),
+      cache_(new LRUCache(max_entries)) {
+  auto add_issuer = [this](const std::string& issuer) {
+    if (std::find(issuers_.begin(), issuers_.end(), issuer) ==
+        issuers_.end()) {
+      issuers_.push_back(issuer);
+    }
+  };
+  for (const auto& method : policy.peers()) {
+    switch (method.params_case()) {
+      case iaapi::PeerAuthenticationMethod::ParamsCase::kMtls:
+        has_mtls_ = true;
+        break;
+      case iaapi::PeerAuthenticationMethod::ParamsCase::kJwt:
+        add_issuer(method.jwt().issuer());
+        break;
+      default:
+        break;
+    }
+  }
+  for (const auto& method : policy.origins()) {
+    add_issuer(method.jwt().issuer());
+  }
+}
+
+std::string ResultCache::Key(const FilterContext& filter_context) const {
+  std::string key;
+
+  // The peer identity, for mTLS peer methods.
+  if (has_mtls_) {
+    const Network::Connection* connection = filter_context.connection();
+    if (connection == nullptr) {
+      key.push_back('0');
+    } else {
+      const auto& identity = Utils::ConnectionIdentity::get(*connection);
+      key.push_back(identity.mutualTLS() ? 'm' : 'p');
+      std::string value;
+      bool present = identity.principal(true, &value);
+      AppendField(present, value, &key);
+      present = identity.trustDomain(true, &value);
+      AppendField(present, value, &key);
+      present = identity.trustDomain(false, &value);
+      AppendField(present, value, &key);
+    }
+  }
+
+  // The origins whose trigger rules match the request.
+  if (num_origins_ > 0) {
+    const HeaderMap& headers = filter_context.headerMap();
+    if (isCORSPreflightRequest(headers)) {
+      key.push_back('c');
+    } else {
+      absl::string_view path;
+      if (headers.Path() != nullptr) {
+        path = headers.Path()->value().getStringView();
+      }
+      for (int i = 0; i < num_origins_; ++i) {
+        key.push_back(origin_triggers_->origin(i).ShouldValidate(path) ? '1'
+                                                                       : '0');
+      }
+    }
+  }
+
+  // The JWT payloads of the issuers, as the authenticators read them.
+  SHA256_CTX ctx;
+  SHA256_Init(&ctx);
+  const auto& metadata = filter_context.dynamicMetadata();
+  std::string bytes;
+  for (const auto& issuer : issuers_) {
+    bytes.clear();
+    const ProtobufWkt::Value* value = FindIssuer(
+        metadata, Extensions::HttpFilters::HttpFilterNames::get().JwtAuthn,
+        issuer);
+    // The claims of the Istio jwt filter are not used if the issuer is there,
+    // even without a payload.
+    const uint8_t present = value != nullptr;
+    SHA256_Update(&ctx, &present, sizeof(present));
+    if (value != nullptr) {
+      Protobuf::io::StringOutputStream stream(&bytes);
+      Protobuf::io::CodedOutputStream coded(&stream);
+      coded.SetSerializationDeterministic(true);
+      value->struct_value().SerializeToCodedStream(&coded);
+    }
+    UpdateDigest(bytes, &ctx);
+    value = FindIssuer(metadata, Utils::IstioFilterName::kJwt, issuer);
+    UpdateDigest(value != nullptr ? value->string_value() : "", &ctx);
+  }
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, &ctx);
+  key.append(reinterpret_cast<const char*>(digest), sizeof(digest));
+  return key;
+}
+
+std::shared_ptr<const ProtobufWkt::Struct> ResultCache::Lookup(
+    const std::string& key) {
+  LRUCache::ScopedLookup lookup(cache_.get(), key);
+  if (!lookup.Found()) {
+    return nullptr;
+  }
+  return lookup.value()->data;
+}
+
+void ResultCache::Insert(const std::string& key,
+                         const ProtobufWkt::Struct& data) {
+  cache_->Insert(key,
+                 new Entry{std::make_shared<const ProtobufWkt::Struct>(data)},
+                 1);
+}
+
+}  // namespace AuthN
+}  // namespace Istio
+}  // namespace Http
+}  // namespace Envoy
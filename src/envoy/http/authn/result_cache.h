@@ -0,0 +1,84 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "authentication/v1alpha1/policy.pb.h"
+#include "common/protobuf/protobuf.h"
+#include "envoy/thread_local/thread_local.h"
+#include "include/istio/utils/simple_lru_cache.h"
+#include "include/istio/utils/simple_lru_cache_inl.h"
+#include "src/envoy/http/authn/filter_context.h"
+#include "src/envoy/http/authn/trigger_rule_matcher.h"
+
+namespace Envoy {
+namespace Http {
+namespace Istio {
+namespace AuthN {
+
+// Number of results the cache of a worker keeps for a policy.
+const int64_t kResultCacheSize = 1000;
+
+// A bounded LRU cache of the dynamic metadata the authentication filter saves
+// for successfully authenticated requests. The result of a policy only
+// depends on the identity of the peer, the JWT payloads of the issuers of the
+// policy, and which trigger rules the request path matches, so requests which
+// agree on them reuse the metadata instead of running the authenticators.
+// There is one cache per worker for each filter config, it is not
+// thread-safe.
+class ResultCache : public ThreadLocal::ThreadLocalObject {
+ public:
+  ResultCache(const istio::authentication::v1alpha1::Policy& policy,
+              OriginTriggerMatchersConstSharedPtr origin_triggers,
+              int64_t max_entries = kResultCacheSize);
+
+  ~ResultCache() { cache_->RemoveAll(); }
+
+  // Gets the key of the request of filter_context. The peer identity is kept
+  // as is and the JWT payloads are replaced by their SHA256 digest.
+  std::string Key(const FilterContext& filter_context) const;
+
+  // Returns the metadata cached for key, or nullptr if there is none.
+  std::shared_ptr<const ProtobufWkt::Struct> Lookup(const std::string& key);
+
+  void Insert(const std::string& key, const ProtobufWkt::Struct& data);
+
+  // Gets the number of cached results.
+  int64_t Size() const { return cache_->Size(); }
+
+ private:
+  // Holds a shared_ptr so a hit stays valid if the entry is evicted.
+  struct Entry {
+    std::shared_ptr<const ProtobufWkt::Struct> data;
+  };
+  using LRUCache = ::istio::utils::SimpleLRUCache<std::string, Entry>;
+
+  // Whether any peer method of the policy is mTLS.
+  bool has_mtls_{};
+  int num_origins_;
+  // Issuers of the peer and origin JWTs of the policy, without duplicates.
+  std::vector<std::string> issuers_;
+  OriginTriggerMatchersConstSharedPtr origin_triggers_;
+  std::unique_ptr<LRUCache> cache_;
+};
+
+}  // namespace AuthN
+}  // namespace Istio
+}  // namespace Http
+}  // namespace Envoy
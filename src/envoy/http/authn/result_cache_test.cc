@@ -0,0 +1,157 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/authn/result_cache.h"
+
+#include "common/protobuf/protobuf.h"
+#include "envoy/api/v2/core/base.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/envoy/utils/filter_names.h"
+#include "test/mocks/network/mocks.h"
+#include "test/mocks/ssl/mocks.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/utility.h"
+
+using istio::envoy::config::filter::http::authn::v2alpha1::FilterConfig;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+
+namespace iaapi = istio::authentication::v1alpha1;
+
+namespace Envoy {
+namespace Http {
+namespace Istio {
+namespace AuthN {
+namespace {
+
+const char kPolicy[] = R"(
+  peers {
+    mtls {}
+  }
+  origins {
+    jwt {
+      issuer: "abc.xyz"
+      trigger_rules {
+        excluded_paths {
+          exact: "/health"
+        }
+      }
+    }
+  }
+)";
+
+// A connection with the given peer certificate URI SAN.
+class TestConnection {
+ public:
+  TestConnection(const std::string& peer_san) {
+    auto ssl = std::make_shared<NiceMock<Ssl::MockConnectionInfo>>();
+    ON_CALL(*ssl, peerCertificatePresented()).WillByDefault(Return(true));
+    ON_CALL(*ssl, uriSanPeerCertificate())
+        .WillByDefault(Return(std::vector<std::string>{peer_san}));
+    ON_CALL(*ssl, uriSanLocalCertificate())
+        .WillByDefault(Return(std::vector<std::string>{"spiffe://td/local"}));
+    ON_CALL(Const(connection_), ssl()).WillByDefault(Return(ssl));
+    ON_CALL(connection_, streamInfo()).WillByDefault(ReturnRef(stream_info_));
+  }
+
+  const Network::Connection* get() const { return &connection_; }
+
+ private:
+  NiceMock<StreamInfo::MockStreamInfo> stream_info_;
+  NiceMock<Network::MockConnection> connection_;
+};
+
+class ResultCacheTest : public testing::Test {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(Protobuf::TextFormat::ParseFromString(kPolicy, &policy_));
+    cache_ = std::make_unique<ResultCache>(
+        policy_, std::make_shared<const OriginTriggerMatchers>(policy_), 2);
+  }
+
+ protected:
+  // Gets the key of a request on connection with the given path, and the
+  // payload of the Istio jwt filter for "abc.xyz" unless it is empty.
+  std::string Key(const TestConnection& connection, const std::string& path,
+                  const std::string& payload) {
+    envoy::api::v2::core::Metadata metadata;
+    if (!payload.empty()) {
+      (*metadata.mutable_filter_metadata())[Utils::IstioFilterName::kJwt] =
+          MessageUtil::keyValueStruct("abc.xyz", payload);
+    }
+    Http::TestHeaderMapImpl headers{{":method", "GET"}, {":path", path}};
+    FilterContext filter_context(metadata, headers, connection.get(),
+                                 FilterConfig::default_instance());
+    return cache_->Key(filter_context);
+  }
+
+  iaapi::Policy policy_;
+  std::unique_ptr<ResultCache> cache_;
+};
+
+TEST_F(ResultCacheTest, SameRequestSameKey) {
+  TestConnection connection("spiffe://td/foo");
+  TestConnection other_connection("spiffe://td/foo");
+  EXPECT_EQ(Key(connection, "/a", "{\"sub\":\"x\"}"),
+            Key(other_connection, "/a", "{\"sub\":\"x\"}"));
+  // The path only matters through the trigger rules.
+  EXPECT_EQ(Key(connection, "/a", "{\"sub\":\"x\"}"),
+            Key(connection, "/b", "{\"sub\":\"x\"}"));
+}
+
+TEST_F(ResultCacheTest, DifferentPeer) {
+  TestConnection connection("spiffe://td/foo");
+  TestConnection other_connection("spiffe://td/bar");
+  EXPECT_NE(Key(connection, "/a", "{\"sub\":\"x\"}"),
+            Key(other_connection, "/a", "{\"sub\":\"x\"}"));
+}
+
+TEST_F(ResultCacheTest, DifferentToken) {
+  TestConnection connection("spiffe://td/foo");
+  EXPECT_NE(Key(connection, "/a", "{\"sub\":\"x\"}"),
+            Key(connection, "/a", "{\"sub\":\"y\"}"));
+  EXPECT_NE(Key(connection, "/a", "{\"sub\":\"x\"}"),
+            Key(connection, "/a", ""));
+}
+
+TEST_F(ResultCacheTest, DifferentTrigger) {
+  TestConnection connection("spiffe://td/foo");
+  EXPECT_NE(Key(connection, "/a", "{\"sub\":\"x\"}"),
+            Key(connection, "/health", "{\"sub\":\"x\"}"));
+}
+
+TEST_F(ResultCacheTest, LookupAndEvict) {
+  ProtobufWkt::Struct data = MessageUtil::keyValueStruct("k", "v");
+  EXPECT_EQ(nullptr, cache_->Lookup("a"));
+  cache_->Insert("a", data);
+  auto cached = cache_->Lookup("a");
+  ASSERT_NE(nullptr, cached);
+  EXPECT_TRUE(TestUtility::protoEqual(data, *cached));
+
+  cache_->Insert("b", data);
+  cache_->Insert("c", data);
+  EXPECT_EQ(2, cache_->Size());
+  EXPECT_EQ(nullptr, cache_->Lookup("a"));
+  // A result which was looked up stays valid after it is evicted.
+  EXPECT_TRUE(TestUtility::protoEqual(data, *cached));
+}
+
+}  // namespace
+}  // namespace AuthN
+}  // namespace Istio
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,192 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/authn/trigger_rule_matcher.h"
+
+#include <algorithm>
+#include <string>
+
+#include "envoy/common/exception.h"
+
+namespace iaapi = istio::authentication::v1alpha1;
+
+namespace Envoy {
+namespace Http {
+namespace Istio {
+namespace AuthN {
+
+void PathTrie::Add(absl::string_view pattern, bool is_prefix) {
+  uint32_t node = 0;
+  for (char c : pattern) {
+    uint32_t child = Child(node, c);
+    if (child == 0) {
+      child = nodes_.size();
+      auto& children = nodes_[node].children;
+      children.insert(
+          std::lower_bound(children.begin(), children.end(),
+                           std::make_pair(c, uint32_t(0))),
+          std::make_pair(c, child));
+      // Invalidates references into nodes_.
+      nodes_.emplace_back();
+    }
+    node = child;
+  }
+  if (is_prefix) {
+    nodes_[node].prefix = true;
+  } else {
+    nodes_[node].exact = true;
+  }
+}
+
+uint32_t PathTrie::Child(uint32_t node, char c) const {
+  const auto& children = nodes_[node].children;
+  auto it = std::lower_bound(
+      children.begin(), children.end(), c,
+      [](const std::pair<char, uint32_t>& child, char c) {
+        return child.first < c;
+      });
+  if (it == children.end() || it->first != c) {
+    return 0;
+  }
+  return it->second;
+}
+
+StringMatchSet::StringMatchSet(
+    const google::protobuf::RepeatedPtrField<iaapi::StringMatch>& matches,
+    int64_t regex_max_mem)
+    : empty_(true) {
+  re2::RE2::Options options;
+  options.set_log_errors(false);
+  options.set_max_mem(regex_max_mem);
+  std::vector<const std::string*> re2_patterns;
+  for (const auto& match : matches) {
+    switch (match.match_type_case()) {
+      case iaapi::StringMatch::kExact:
+        prefixes_.Add(match.exact(), false);
+        break;
+      case iaapi::StringMatch::kPrefix:
+        prefixes_.Add(match.prefix(), true);
+        break;
+      case iaapi::StringMatch::kSuffix: {
+        std::string reversed(match.suffix().rbegin(), match.suffix().rend());
+        suffixes_.Add(reversed, true);
+        break;
+      }
+      case iaapi::StringMatch::kRegex: {
+        if (!regexes_) {
+          regexes_.reset(new re2::RE2::Set(options, re2::RE2::ANCHOR_BOTH));
+        }
+        std::string error;
+        if (regexes_->Add(match.regex(), &error) >= 0) {
+          re2_patterns.push_back(&match.regex());
+          break;
+        }
+        // ECMAScript regexes may use features RE2 doesn't have.
+        try {
+          std_regexes_.emplace_back(match.regex());
+        } catch (const std::regex_error& e) {
+          throw EnvoyException(fmt::format("Invalid trigger rule regex {}: {}",
+                                           match.regex(), e.what()));
+        }
+        break;
+      }
+      default:
+        // Matches nothing, like AuthnUtils::MatchString.
+        continue;
+    }
+    empty_ = false;
+  }
+  if (regexes_ && !regexes_->Compile()) {
+    // Usually too many regexes for the memory budget of one set.
+    ENVOY_LOG(warn, "Matching {} trigger rule regexes one by one",
+              re2_patterns.size());
+    regexes_.reset();
+    for (const std::string* pattern : re2_patterns) {
+      single_regexes_.emplace_back(new re2::RE2(*pattern, options));
+      if (!single_regexes_.back()->ok()) {
+        throw EnvoyException(
+            fmt::format("Failed to compile trigger rule regex {}: {}",
+                        *pattern, single_regexes_.back()->error()));
+      }
+    }
+  }
+}
+
+bool StringMatchSet::Matches(absl::string_view str) const {
+  if (prefixes_.Matches(str.begin(), str.end()) ||
+      suffixes_.Matches(str.rbegin(), str.rend())) {
+    return true;
+  }
+  if (regexes_ &&
+      regexes_->Match(re2::StringPiece(str.data(), str.size()), nullptr)) {
+    return true;
+  }
+  for (const auto& regex : single_regexes_) {
+    if (re2::RE2::FullMatch(re2::StringPiece(str.data(), str.size()),
+                            *regex)) {
+      return true;
+    }
+  }
+  if (!std_regexes_.empty()) {
+    std::string s(str);
+    for (const auto& regex : std_regexes_) {
+      if (std::regex_match(s, regex)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+JwtTriggerMatcher::JwtTriggerMatcher(const iaapi::Jwt& jwt) {
+  for (const auto& rule : jwt.trigger_rules()) {
+    rules_.push_back(Rule{
+        std::make_unique<StringMatchSet>(rule.excluded_paths()),
+        rule.included_paths_size() > 0
+            ? std::make_unique<StringMatchSet>(rule.included_paths())
+            : nullptr});
+  }
+}
+
+bool JwtTriggerMatcher::ShouldValidate(absl::string_view path) const {
+  // If the path is empty which shouldn't happen for a HTTP request or if
+  // there are no trigger rules at all, then simply return true as if there're
+  // no per-path jwt support.
+  if (path == "" || rules_.empty()) {
+    return true;
+  }
+  for (const auto& rule : rules_) {
+    // The rule is not matched if any of excluded_paths matched.
+    if (rule.excluded->Matches(path)) {
+      continue;
+    }
+    // The rule is matched if included_paths is empty or any of them matched.
+    if (rule.included == nullptr || rule.included->Matches(path)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+OriginTriggerMatchers::OriginTriggerMatchers(const iaapi::Policy& policy) {
+  for (const auto& method : policy.origins()) {
+    origins_.emplace_back(new JwtTriggerMatcher(method.jwt()));
+  }
+}
+
+}  // namespace AuthN
+}  // namespace Istio
+}  // namespace Http
+}  // namespace Envoy
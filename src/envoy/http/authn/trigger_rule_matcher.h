@@ -0,0 +1,140 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <regex>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "authentication/v1alpha1/policy.pb.h"
+#include "common/common/logger.h"
+#include "re2/re2.h"
+#include "re2/set.h"
+
+namespace Envoy {
+namespace Http {
+namespace Istio {
+namespace AuthN {
+
+// A trie of exact and prefix patterns. Suffix patterns are added reversed
+// and matched with reverse iterators.
+class PathTrie {
+ public:
+  PathTrie() : nodes_(1) {}
+
+  void Add(absl::string_view pattern, bool is_prefix);
+
+  // Returns true if [begin, end) equals an exact pattern or starts with a
+  // prefix pattern.
+  template <typename Iterator>
+  bool Matches(Iterator begin, Iterator end) const {
+    uint32_t node = 0;
+    for (Iterator it = begin; it != end; ++it) {
+      if (nodes_[node].prefix) {
+        return true;
+      }
+      node = Child(node, *it);
+      if (node == 0) {
+        return false;
+      }
+    }
+    return nodes_[node].prefix || nodes_[node].exact;
+  }
+
+  bool empty() const { return nodes_.size() == 1 && !nodes_[0].prefix; }
+
+ private:
+  struct Node {
+    // Sorted by character, the root is never a child so 0 means none.
+    std::vector<std::pair<char, uint32_t>> children;
+    bool exact = false;
+    bool prefix = false;
+  };
+
+  uint32_t Child(uint32_t node, char c) const;
+
+  std::vector<Node> nodes_;
+};
+
+// Matches a string against a list of StringMatch, like AuthnUtils::MatchString
+// on each of them, with the patterns compiled once. Throws EnvoyException for
+// a regex neither RE2 nor std::regex accepts, which would otherwise match
+// nothing and skip the JWT of an included path. regex_max_mem is the RE2
+// memory budget of the regexes.
+class StringMatchSet : public Logger::Loggable<Logger::Id::filter> {
+ public:
+  StringMatchSet(const google::protobuf::RepeatedPtrField<
+                     istio::authentication::v1alpha1::StringMatch>& matches,
+                 int64_t regex_max_mem = kDefaultRegexMaxMem);
+
+  // The RE2 default.
+  static constexpr int64_t kDefaultRegexMaxMem = 8 << 20;
+
+  // Returns true if str matches any of the patterns.
+  bool Matches(absl::string_view str) const;
+
+  bool empty() const { return empty_; }
+
+ private:
+  bool empty_;
+  // Exact and prefix patterns.
+  PathTrie prefixes_;
+  // Reversed suffix patterns.
+  PathTrie suffixes_;
+  std::unique_ptr<re2::RE2::Set> regexes_;
+  // The regexes of regexes_ one by one, if they don't fit in one set.
+  std::vector<std::unique_ptr<re2::RE2>> single_regexes_;
+  // Regexes which RE2 does not support.
+  std::vector<std::regex> std_regexes_;
+};
+
+// The trigger rules of a JWT, compiled once. ShouldValidate() is the same as
+// AuthnUtils::ShouldValidateJwtPerPath.
+class JwtTriggerMatcher {
+ public:
+  JwtTriggerMatcher(const istio::authentication::v1alpha1::Jwt& jwt);
+
+  // Returns true if the jwt should be validated for the request path.
+  bool ShouldValidate(absl::string_view path) const;
+
+ private:
+  struct Rule {
+    std::unique_ptr<StringMatchSet> excluded;
+    std::unique_ptr<StringMatchSet> included;
+  };
+  std::vector<Rule> rules_;
+};
+
+// The trigger matchers of the origins of a policy, indexed like
+// policy.origins(). The authn filter config compiles them once.
+class OriginTriggerMatchers {
+ public:
+  OriginTriggerMatchers(const istio::authentication::v1alpha1::Policy& policy);
+
+  const JwtTriggerMatcher& origin(int index) const { return *origins_[index]; }
+
+ private:
+  std::vector<std::unique_ptr<JwtTriggerMatcher>> origins_;
+};
+
+typedef std::shared_ptr<const OriginTriggerMatchers>
+    OriginTriggerMatchersConstSharedPtr;
+
+}  // namespace AuthN
+}  // namespace Istio
+}  // namespace Http
+}  // namespace Envoy
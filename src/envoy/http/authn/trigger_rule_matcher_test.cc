@@ -0,0 +1,173 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "src/envoy/http/authn/trigger_rule_matcher.h"
+
+#include "gtest/gtest.h"
+#include "src/envoy/http/authn/authn_utils.h"
+
+namespace iaapi = istio::authentication::v1alpha1;
+
+namespace Envoy {
+namespace Http {
+namespace Istio {
+namespace AuthN {
+namespace {
+
+const std::vector<std::string> kPaths = {
+    "",        "/",        "/good",   "/good-x",     "/good-1",
+    "/allow",  "/allow-x", "/allow-1", "/other",     "/hello",
+    "/hello/", "/a.jpg",   "/b/c.jpg", "/jpg",       "/api/v1/users",
+    "/api/v2", "/api",     "/healthz", "/healthz/ok"};
+
+// Expects the matcher to agree with AuthnUtils::ShouldValidateJwtPerPath.
+void ExpectSameAsAuthnUtils(const iaapi::Jwt& jwt) {
+  JwtTriggerMatcher matcher(jwt);
+  for (const auto& path : kPaths) {
+    EXPECT_EQ(AuthnUtils::ShouldValidateJwtPerPath(path, jwt),
+              matcher.ShouldValidate(path))
+        << "path: " << path << " jwt: " << jwt.DebugString();
+  }
+}
+
+TEST(PathTrieTest, ExactAndPrefix) {
+  PathTrie trie;
+  EXPECT_TRUE(trie.empty());
+  EXPECT_FALSE(trie.Matches(kPaths[1].begin(), kPaths[1].end()));
+
+  trie.Add("/good", false);
+  trie.Add("/go", true);
+  trie.Add("/allow", false);
+  EXPECT_FALSE(trie.empty());
+
+  for (const std::string path : {"/good", "/go", "/gone", "/allow"}) {
+    EXPECT_TRUE(trie.Matches(path.begin(), path.end())) << path;
+  }
+  for (const std::string path : {"/g", "/allo", "/allow-x", ""}) {
+    EXPECT_FALSE(trie.Matches(path.begin(), path.end())) << path;
+  }
+}
+
+TEST(PathTrieTest, EmptyPrefixMatchesAll) {
+  PathTrie trie;
+  trie.Add("", true);
+  EXPECT_FALSE(trie.empty());
+  EXPECT_TRUE(trie.Matches(kPaths[0].begin(), kPaths[0].end()));
+  EXPECT_TRUE(trie.Matches(kPaths[3].begin(), kPaths[3].end()));
+}
+
+TEST(JwtTriggerMatcherTest, NoRules) {
+  iaapi::Jwt jwt;
+  ExpectSameAsAuthnUtils(jwt);
+  EXPECT_TRUE(JwtTriggerMatcher(jwt).ShouldValidate(""));
+  EXPECT_TRUE(JwtTriggerMatcher(jwt).ShouldValidate("/test"));
+}
+
+TEST(JwtTriggerMatcherTest, Excluded) {
+  iaapi::Jwt jwt;
+  auto* rule = jwt.add_trigger_rules();
+  rule->add_excluded_paths()->set_exact("/good-x");
+  rule->add_excluded_paths()->set_exact("/allow-x");
+  ExpectSameAsAuthnUtils(jwt);
+
+  rule->add_included_paths()->set_prefix("/good");
+  rule->add_included_paths()->set_prefix("/allow");
+  ExpectSameAsAuthnUtils(jwt);
+  EXPECT_FALSE(JwtTriggerMatcher(jwt).ShouldValidate("/good-x"));
+  EXPECT_TRUE(JwtTriggerMatcher(jwt).ShouldValidate("/good-1"));
+  EXPECT_FALSE(JwtTriggerMatcher(jwt).ShouldValidate("/other"));
+}
+
+TEST(JwtTriggerMatcherTest, MultipleRules) {
+  iaapi::Jwt jwt;
+  jwt.add_trigger_rules()->add_excluded_paths()->set_exact("/hello");
+  ExpectSameAsAuthnUtils(jwt);
+
+  jwt.add_trigger_rules()->add_included_paths()->set_exact("/hello");
+  ExpectSameAsAuthnUtils(jwt);
+  EXPECT_TRUE(JwtTriggerMatcher(jwt).ShouldValidate("/hello"));
+}
+
+TEST(JwtTriggerMatcherTest, SuffixAndRegex) {
+  iaapi::Jwt jwt;
+  auto* rule = jwt.add_trigger_rules();
+  rule->add_included_paths()->set_suffix(".jpg");
+  rule->add_included_paths()->set_regex("/api/v[0-9]+(/.*)?");
+  rule->add_excluded_paths()->set_suffix("/ok");
+  rule->add_excluded_paths()->set_regex("/b/.*");
+  ExpectSameAsAuthnUtils(jwt);
+  EXPECT_TRUE(JwtTriggerMatcher(jwt).ShouldValidate("/a.jpg"));
+  EXPECT_FALSE(JwtTriggerMatcher(jwt).ShouldValidate("/b/c.jpg"));
+  EXPECT_TRUE(JwtTriggerMatcher(jwt).ShouldValidate("/api/v1/users"));
+  // The regex has to match the whole path.
+  EXPECT_FALSE(JwtTriggerMatcher(jwt).ShouldValidate("/api"));
+}
+
+TEST(JwtTriggerMatcherTest, RegexNotSupportedByRe2) {
+  iaapi::Jwt jwt;
+  // RE2 doesn't support lookahead, std::regex is used instead.
+  jwt.add_trigger_rules()->add_included_paths()->set_regex(
+      "/(?!healthz).*");
+  ExpectSameAsAuthnUtils(jwt);
+  EXPECT_TRUE(JwtTriggerMatcher(jwt).ShouldValidate("/other"));
+  EXPECT_FALSE(JwtTriggerMatcher(jwt).ShouldValidate("/healthz"));
+}
+
+TEST(JwtTriggerMatcherTest, InvalidRegexIsRejected) {
+  iaapi::Jwt jwt;
+  auto* rule = jwt.add_trigger_rules();
+  rule->add_included_paths()->set_regex("/[a");
+  rule->add_included_paths()->set_exact("/hello");
+  EXPECT_THROW_WITH_REGEX(JwtTriggerMatcher matcher(jwt), EnvoyException,
+                          "Invalid trigger rule regex /\\[a");
+
+  iaapi::Policy policy;
+  *policy.add_origins()->mutable_jwt() = jwt;
+  EXPECT_THROW(OriginTriggerMatchers matchers(policy), EnvoyException);
+}
+
+TEST(StringMatchSetTest, RegexesOverSetBudgetMatchOneByOne) {
+  google::protobuf::RepeatedPtrField<iaapi::StringMatch> matches;
+  for (int i = 0; i < 50; i++) {
+    matches.Add()->set_regex("/api/v[0-9]+/item-" + std::to_string(i) +
+                             "/.*");
+  }
+  // Enough for each regex, but not for all of them in one set.
+  StringMatchSet set(matches, 20000);
+  EXPECT_TRUE(set.Matches("/api/v1/item-0/a"));
+  EXPECT_TRUE(set.Matches("/api/v2/item-49/b"));
+  EXPECT_FALSE(set.Matches("/api/v2/item-50/b"));
+  EXPECT_FALSE(set.Matches("/api/item-1/a"));
+
+  StringMatchSet defaults(matches);
+  EXPECT_TRUE(defaults.Matches("/api/v2/item-49/b"));
+  EXPECT_FALSE(defaults.Matches("/api/v2/item-50/b"));
+}
+
+TEST(OriginTriggerMatchersTest, OneMatcherPerOrigin) {
+  iaapi::Policy policy;
+  policy.add_origins()->mutable_jwt()->add_trigger_rules()
+      ->add_included_paths()->set_exact("/hello");
+  policy.add_origins();
+  OriginTriggerMatchers matchers(policy);
+  EXPECT_TRUE(matchers.origin(0).ShouldValidate("/hello"));
+  EXPECT_FALSE(matchers.origin(0).ShouldValidate("/other"));
+  EXPECT_TRUE(matchers.origin(1).ShouldValidate("/other"));
+}
+
+}  // namespace
+}  // namespace AuthN
+}  // namespace Istio
+}  // namespace Http
+}  // namespace Envoy
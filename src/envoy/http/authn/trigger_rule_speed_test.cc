@@ -0,0 +1,108 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+#include "src/envoy/http/authn/authn_utils.h"
+#include "src/envoy/http/authn/trigger_rule_matcher.h"
+
+namespace iaapi = istio::authentication::v1alpha1;
+
+namespace Envoy {
+namespace Http {
+namespace Istio {
+namespace AuthN {
+namespace {
+
+// Returns a JWT whose rule excludes num_paths paths, a quarter of each match
+// type, and includes everything under /api.
+iaapi::Jwt JwtWithPaths(int num_paths) {
+  iaapi::Jwt jwt;
+  auto* rule = jwt.add_trigger_rules();
+  for (int i = 0; i < num_paths; i++) {
+    auto* match = rule->add_excluded_paths();
+    switch (i % 4) {
+      case 0:
+        match->set_exact(absl::StrCat("/api/v1/exact/", i));
+        break;
+      case 1:
+        match->set_prefix(absl::StrCat("/api/v1/prefix/", i, "/"));
+        break;
+      case 2:
+        match->set_suffix(absl::StrCat("/suffix-", i));
+        break;
+      default:
+        match->set_regex(absl::StrCat("/api/v[0-9]+/regex/", i, "/[a-z]+"));
+        break;
+    }
+  }
+  rule->add_included_paths()->set_prefix("/api/");
+  return jwt;
+}
+
+// Request paths hitting each match type, and one which matches nothing.
+const std::vector<std::string>& RequestPaths() {
+  static const auto* paths = new std::vector<std::string>{
+      "/api/v1/exact/0", "/api/v1/prefix/1/users", "/api/v1/users/suffix-2",
+      "/api/v2/regex/3/abc", "/api/v1/users/12345/profile"};
+  return *paths;
+}
+
+static void BM_ShouldValidateJwtPerPath(benchmark::State& state) {
+  iaapi::Jwt jwt = JwtWithPaths(state.range(0));
+  const auto& paths = RequestPaths();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(AuthnUtils::ShouldValidateJwtPerPath(
+        paths[i++ % paths.size()], jwt));
+  }
+}
+BENCHMARK(BM_ShouldValidateJwtPerPath)->Arg(4)->Arg(40)->Arg(400);
+
+static void BM_JwtTriggerMatcher(benchmark::State& state) {
+  JwtTriggerMatcher matcher(JwtWithPaths(state.range(0)));
+  const auto& paths = RequestPaths();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        matcher.ShouldValidate(paths[i++ % paths.size()]));
+  }
+}
+BENCHMARK(BM_JwtTriggerMatcher)->Arg(4)->Arg(40)->Arg(400);
+
+static void BM_CompileJwtTriggerMatcher(benchmark::State& state) {
+  iaapi::Jwt jwt = JwtWithPaths(state.range(0));
+  for (auto _ : state) {
+    JwtTriggerMatcher matcher(jwt);
+    benchmark::DoNotOptimize(&matcher);
+  }
+}
+BENCHMARK(BM_CompileJwtTriggerMatcher)->Arg(4)->Arg(40)->Arg(400);
+
+}  // namespace
+}  // namespace AuthN
+}  // namespace Istio
+}  // namespace Http
+}  // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs
+// them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,137 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/codec.h"
+
+#include <algorithm>
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+namespace {
+
+// The base64url alphabet, each digit carries six table positions
+constexpr char kDigits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+int digitValue(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '-') {
+        return 62;
+    }
+    if (c == '_') {
+        return 63;
+    }
+    return -1;
+}
+
+static_assert(MAX_LABELS % 64 == 0, "label bits are visited in 64 bit words");
+
+}  // namespace
+
+LabelCodec::LabelCodec(const google::protobuf::RepeatedPtrField<std::string>& table) {
+    positions_.fill(kNoPosition);
+    for (const std::string& name : table) {
+        TableEntry entry{false, 0, name};
+        entry.interned = LabelInterner::get().intern(name, &entry.label);
+        // Only interned labels can be encoded, so positions beyond what the
+        // digits can hold are never needed
+        if (entry.interned && positions_[entry.label] == kNoPosition &&
+            table_.size() < kMaxDigits * 6) {
+            positions_[entry.label] = table_.size();
+        }
+        table_.push_back(std::move(entry));
+    }
+}
+
+bool LabelCodec::encode(const LabelSet& labels, std::string* out) const {
+    if (labels.size() == 0 || labels.hasOverflow() || table_.empty()) {
+        return false;
+    }
+    std::array<uint8_t, kMaxDigits> digits{};
+    size_t length = 0;
+    // Visits the set bits a word at a time, sets are sparse
+    const LabelBits mask(~0ULL);
+    for (LabelId base = 0; base < MAX_LABELS; base += 64) {
+        uint64_t word = ((labels.bits() >> base) & mask).to_ullong();
+        while (word != 0) {
+            int position = positions_[base + __builtin_ctzll(word)];
+            word &= word - 1;
+            if (position == kNoPosition) {
+                return false;
+            }
+            digits[position / 6] |= 1 << (position % 6);
+            length = std::max(length, static_cast<size_t>(position / 6 + 1));
+        }
+    }
+    out->resize(length);
+    for (size_t i = 0; i < length; i++) {
+        (*out)[i] = kDigits[digits[i]];
+    }
+    return true;
+}
+
+bool LabelCodec::decode(absl::string_view encoded, LabelSet* labels) const {
+    if (encoded.empty() || encoded.size() > (table_.size() + 5) / 6) {
+        return false;
+    }
+    LabelSet decoded;
+    for (size_t i = 0; i < encoded.size(); i++) {
+        int digit = digitValue(encoded[i]);
+        if (digit < 0) {
+            return false;
+        }
+        for (size_t bit = 0; digit != 0; bit++, digit >>= 1) {
+            if ((digit & 1) == 0) {
+                continue;
+            }
+            size_t position = i * 6 + bit;
+            if (position >= table_.size()) {
+                return false;
+            }
+            const TableEntry& entry = table_[position];
+            if (entry.interned) {
+                decoded.put(entry.label);
+            } else {
+                decoded.put(entry.name);
+            }
+        }
+    }
+    *labels = std::move(decoded);
+    return true;
+}
+
+LabelSet LabelCodec::read(absl::string_view value, absl::string_view encoding) const {
+    if (encoding == COMPACT_ENCODING) {
+        LabelSet labels;
+        if (decode(value, &labels)) {
+            return labels;
+        }
+        ENVOY_LOG(debug, "DataTracing: x-data {} is not a known bitset, reading it as text", value);
+    }
+    return LabelSet(value);
+}
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,82 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "common/common/logger.h"
+#include "google/protobuf/repeated_field.h"
+#include "src/envoy/http/data/labels.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+// Value of the x-data-encoding header when x-data carries a label bitset
+const std::string COMPACT_ENCODING = "bitset";
+
+/**
+ * Compact form of the x-data header, a bitset of positions in a label table
+ * that every hop is configured with in the same order. Digit i of the value
+ * is a base64url digit whose bit k marks table position 6 * i + k, trailing
+ * zero digits are dropped.
+ *
+ * Sets with labels outside of the table cannot be encoded and are sent as
+ * text instead, so the table only has to cover the common labels.
+ */
+class LabelCodec : Logger::Loggable<Logger::Id::filter> {
+public:
+    LabelCodec() {
+        positions_.fill(kNoPosition);
+    };
+
+    explicit LabelCodec(const google::protobuf::RepeatedPtrField<std::string>& table);
+
+    // Encodes labels into out, fails for empty sets and labels not in the table
+    bool encode(const LabelSet& labels, std::string* out) const;
+
+    // Replaces labels with the labels of an encoded value, fails on
+    // malformed values and positions beyond the table
+    bool decode(absl::string_view encoded, LabelSet* labels) const;
+
+    // Parses an x-data value sent with the given x-data-encoding, empty if
+    // the header is missing. Values that are not marked as COMPACT_ENCODING
+    // or fail to decode are read as text.
+    LabelSet read(absl::string_view value, absl::string_view encoding) const;
+
+private:
+    // Marks labels without a table position
+    static constexpr int kNoPosition = -1;
+    // Enough digits for a table of all interned labels
+    static constexpr size_t kMaxDigits = (MAX_LABELS + 5) / 6;
+
+    struct TableEntry {
+        bool interned;
+        LabelId label;
+        std::string name;
+    };
+
+    std::vector<TableEntry> table_;
+    // Table position of every interned label, indexed by LabelId
+    std::array<int, MAX_LABELS> positions_;
+};
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
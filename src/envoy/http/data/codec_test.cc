@@ -0,0 +1,101 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/codec.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+namespace {
+
+// Eight labels, so sets span two base64url digits
+google::protobuf::RepeatedPtrField<std::string> labelTable() {
+    google::protobuf::RepeatedPtrField<std::string> table;
+    for (const char* label : {"CODEC_0", "CODEC_1", "CODEC_2", "CODEC_3", "CODEC_4", "CODEC_5",
+                              "CODEC_6", "CODEC_7"}) {
+        table.Add(label);
+    }
+    return table;
+}
+
+class LabelCodecTest : public ::testing::Test {
+  protected:
+    LabelCodec codec_{labelTable()};
+};
+
+TEST_F(LabelCodecTest, RoundTrip) {
+    for (const char* text : {"CODEC_0", "CODEC_5", "CODEC_6", "CODEC_1;CODEC_3;CODEC_7",
+                             "CODEC_0;CODEC_1;CODEC_2;CODEC_3;CODEC_4;CODEC_5;CODEC_6;CODEC_7"}) {
+        std::string encoded;
+        ASSERT_TRUE(codec_.encode(LabelSet(text), &encoded)) << text;
+        LabelSet decoded;
+        ASSERT_TRUE(codec_.decode(encoded, &decoded)) << encoded;
+        EXPECT_EQ(text, decoded.toString());
+    }
+
+    // Bit k of digit i marks position 6 * i + k, trailing zero digits are dropped
+    std::string encoded;
+    ASSERT_TRUE(codec_.encode(LabelSet("CODEC_1;CODEC_5"), &encoded));
+    EXPECT_EQ("i", encoded);
+    ASSERT_TRUE(codec_.encode(LabelSet("CODEC_0;CODEC_7"), &encoded));
+    EXPECT_EQ("BC", encoded);
+}
+
+TEST_F(LabelCodecTest, LabelsMissingFromTableAreNotEncoded) {
+    std::string encoded;
+    EXPECT_FALSE(codec_.encode(LabelSet(), &encoded));
+    // Known to no config at all
+    EXPECT_FALSE(codec_.encode(LabelSet("CODEC_0;CODEC_UNKNOWN"), &encoded));
+
+    // Interned for another config, but not in the table
+    LabelId id;
+    ASSERT_TRUE(LabelInterner::get().intern("CODEC_ELSEWHERE", &id));
+    EXPECT_FALSE(codec_.encode(LabelSet("CODEC_0;CODEC_ELSEWHERE"), &encoded));
+
+    LabelCodec no_table;
+    EXPECT_FALSE(no_table.encode(LabelSet("CODEC_0"), &encoded));
+}
+
+TEST_F(LabelCodecTest, DecodeRejectsMalformedValues) {
+    LabelSet labels("CODEC_0");
+    // Empty, outside of the alphabet, more digits than the table needs and
+    // a position beyond the table
+    for (const char* encoded : {"", "B=", "*", "BBB", "BE"}) {
+        EXPECT_FALSE(codec_.decode(encoded, &labels)) << encoded;
+        EXPECT_EQ("CODEC_0", labels.toString());
+    }
+}
+
+TEST_F(LabelCodecTest, ReadFallsBackToText) {
+    std::string encoded;
+    ASSERT_TRUE(codec_.encode(LabelSet("CODEC_2;CODEC_6"), &encoded));
+    EXPECT_EQ("CODEC_2;CODEC_6", codec_.read(encoded, COMPACT_ENCODING).toString());
+
+    // Without the encoding header, or with another encoding, values are text
+    EXPECT_EQ("CODEC_2;CODEC_6", codec_.read("CODEC_2;CODEC_6", "").toString());
+    EXPECT_EQ(encoded, codec_.read(encoded, "").toString());
+    EXPECT_EQ(encoded, codec_.read(encoded, "gzip").toString());
+
+    // So are values marked as bitsets that don't decode
+    EXPECT_EQ("CODEC_2;CODEC_6", codec_.read("CODEC_2;CODEC_6", COMPACT_ENCODING).toString());
+    EXPECT_EQ("BE", codec_.read("BE", COMPACT_ENCODING).toString());
+}
+
+}  // namespace
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
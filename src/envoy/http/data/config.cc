@@ -14,15 +14,29 @@
  */
 
 #include "common/protobuf/message_validator_impl.h"
+#include "common/protobuf/utility.h"
 #include "src/envoy/http/data/config.h"
 #include "src/envoy/http/data/data_filter.h"
-#include "src/envoy/http/data/map.h"
+#include "src/envoy/http/data/trace_state.h"
 #include "src/envoy/utils/filter_names.h"
 
 namespace Envoy {
 namespace Http {
 namespace Data {
 
+namespace {
+
+// Trace state not accessed for this long is dropped by default
+constexpr std::chrono::milliseconds kDefaultTraceTtl(60000);
+
+// Default upper bound of the traces kept in memory
+constexpr uint32_t kDefaultMaxTraces = 100000;
+
+}  // namespace
+
+// Trace state shared by all data tracing filters of the process
+SINGLETON_MANAGER_REGISTRATION(data_tracing_trace_state);
+
 Http::FilterFactoryCb
 DataTracingFilterFactory::createFilterFactory(
         const Json::Object &config, const std::string &stat_prefix,
@@ -32,7 +46,7 @@ DataTracingFilterFactory::createFilterFactory(
     ENVOY_LOG(warn, "Create from JSON");
     MessageUtil::loadFromJson(config.asJsonString(), filter_config,
                               ProtobufMessage::getNullValidationVisitor());
-    return createFilterFactory(filter_config, context.clusterManager());
+    return createFilterFactory(filter_config, context);
 }
 
 Http::FilterFactoryCb
@@ -41,7 +55,7 @@ DataTracingFilterFactory::createFilterFactoryFromProto(
     Server::Configuration::FactoryContext &context) {
     (void) stat_prefix;
     ENVOY_LOG(warn, "Create from proto");
-    return createFilterFactory(dynamic_cast<const data::FilterConfig &>(config), context.clusterManager());
+    return createFilterFactory(dynamic_cast<const data::FilterConfig &>(config), context);
 }
 
 ProtobufTypes::MessagePtr
@@ -57,16 +71,30 @@ DataTracingFilterFactory::name() {
 
 Http::FilterFactoryCb
 DataTracingFilterFactory::createFilterFactory(const data::FilterConfig &proto_config,
-                                              Upstream::ClusterManager &cluster_manager) {
-    (void) cluster_manager;
+                                              Server::Configuration::FactoryContext &context) {
     ENVOY_LOG(warn, "Config in Constructor: {}", proto_config.DebugString());
 
     DataTracingFilterConfigSharedPtr filter_config =
             std::make_shared<DataTracingFilterConfig>(proto_config);
 
-    return [filter_config](Http::FilterChainFactoryCallbacks& callbacks) -> void {
+    // The limits and mode of whichever config creates the trace state apply
+    std::chrono::milliseconds ttl(
+            PROTOBUF_GET_MS_OR_DEFAULT(proto_config, trace_ttl, kDefaultTraceTtl.count()));
+    size_t max_traces = proto_config.max_traces() > 0 ? proto_config.max_traces()
+                                                      : kDefaultMaxTraces;
+    TraceStateSharedPtr trace_state = context.singletonManager().getTyped<TraceState>(
+            SINGLETON_MANAGER_REGISTERED_NAME(data_tracing_trace_state),
+            [&context, ttl, max_traces, &proto_config] {
+                return std::make_shared<TraceState>(context.dispatcher(), context.threadLocal(),
+                                                    context.scope(), ttl, max_traces,
+                                                    proto_config.worker_local());
+            });
+
+    // Only the factory callbacks, which are destroyed on the main thread, own
+    // the trace state. Its timer and slot belong to the main thread.
+    return [filter_config, trace_state](Http::FilterChainFactoryCallbacks& callbacks) -> void {
         callbacks.addStreamFilter(std::make_unique<DataTracingFilter>(
-                filter_config, dataMap));
+                filter_config, *trace_state));
     };
 
 }
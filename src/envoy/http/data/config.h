@@ -20,14 +20,12 @@
 #include "src/envoy/utils/filter_names.h"
 #include "src/istio/data/data_filter.pb.h"
 #include "src/envoy/http/data/data_filter.h"
-#include "src/envoy/http/data/map.h"
+#include "src/envoy/http/data/trace_state.h"
 
 namespace Envoy {
 namespace Http {
 namespace Data {
 
-ThreadSafeStringMapSharedPtr dataMap = std::make_shared<ThreadSafeStringMap>();
-
 /**
  * Config registration for the data filter.
  */
@@ -51,7 +49,7 @@ public:
 private:
     Http::FilterFactoryCb createFilterFactory(
             const data::FilterConfig& config_pb,
-            Upstream::ClusterManager &cluster_manager);
+            Server::Configuration::FactoryContext &context);
 
 };
 
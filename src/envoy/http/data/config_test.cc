@@ -0,0 +1,74 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/config.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/server/mocks.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+namespace {
+
+// The name config.cc registers the trace state under
+const char kTraceStateName[] = "data_tracing_trace_state_singleton";
+
+// Returns whether the trace state singleton is alive, without creating it
+bool traceStateAlive(Server::Configuration::FactoryContext& context) {
+    bool alive = true;
+    context.singletonManager().get(kTraceStateName, [&alive] {
+        alive = false;
+        return Singleton::InstanceSharedPtr();
+    });
+    return alive;
+}
+
+TEST(DataTracingFilterFactoryTest, FilterOutlivesFactory) {
+    NiceMock<Server::Configuration::MockFactoryContext> context;
+    data::FilterConfig proto_config;
+    proto_config.set_worker_local(true);
+    DataTracingFilterFactory factory;
+    Http::FilterFactoryCb cb = factory.createFilterFactoryFromProto(proto_config, "stats", context);
+
+    Http::MockFilterChainFactoryCallbacks filter_callbacks;
+    Http::StreamFilterSharedPtr filter;
+    EXPECT_CALL(filter_callbacks, addStreamFilter(_))
+            .WillOnce(Invoke([&filter](Http::StreamFilterSharedPtr added) {
+                filter = std::move(added);
+            }));
+    cb(filter_callbacks);
+    ASSERT_NE(nullptr, dynamic_cast<DataTracingFilter*>(filter.get()));
+    EXPECT_TRUE(traceStateAlive(context));
+
+    // The state, with its timer and worker slot, goes with the factory
+    // callback on this thread even though a filter is left.
+    cb = nullptr;
+    EXPECT_FALSE(traceStateAlive(context));
+
+    filter->onDestroy();
+    filter.reset();
+}
+
+}  // namespace
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,215 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/labels.h"
+
+#include <algorithm>
+
+#include "absl/hash/hash.h"
+#include "common/common/macros.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+namespace {
+
+size_t hashLabel(absl::string_view label) {
+    return absl::Hash<absl::string_view>()(label);
+}
+
+// Sorts and joins the distinct labels with DELIM
+std::string joinLabels(std::vector<absl::string_view>* labels) {
+    std::sort(labels->begin(), labels->end());
+    labels->erase(std::unique(labels->begin(), labels->end()), labels->end());
+    size_t length = 0;
+    for (absl::string_view label : *labels) {
+        length += label.size() + DELIM.size();
+    }
+    std::string ret;
+    ret.reserve(length);
+    for (absl::string_view label : *labels) {
+        if (!ret.empty()) {
+            ret.append(DELIM);
+        }
+        ret.append(label.data(), label.size());
+    }
+    return ret;
+}
+
+}  // namespace
+
+LabelInterner& LabelInterner::get() {
+    MUTABLE_CONSTRUCT_ON_FIRST_USE(LabelInterner);
+}
+
+LabelInterner::LabelInterner() {
+    for (size_t i = 0; i < kSlots; i++) {
+        slots_[i].store(0, std::memory_order_relaxed);
+        hashes_[i].store(0, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < kCacheSlots; i++) {
+        cache_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+bool LabelInterner::lookup(absl::string_view label, LabelId* id) const {
+    size_t hash = hashLabel(label);
+    for (size_t i = 0; i < kSlots; i++) {
+        size_t slot = (hash + i) % kSlots;
+        LabelId found = slots_[slot].load(std::memory_order_acquire);
+        if (found == 0) {
+            return false;
+        }
+        if (hashes_[slot].load(std::memory_order_relaxed) == hash &&
+            names_[found - 1] == label) {
+            *id = found - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LabelInterner::intern(absl::string_view label, LabelId* id) {
+    if (lookup(label, id)) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lookup(label, id)) {
+        return true;
+    }
+    if (size_ == MAX_LABELS) {
+        return false;
+    }
+    size_t hash = hashLabel(label);
+    size_t slot = hash % kSlots;
+    while (slots_[slot].load(std::memory_order_relaxed) != 0) {
+        slot = (slot + 1) % kSlots;
+    }
+    names_[size_] = std::string(label);
+    hashes_[slot].store(hash, std::memory_order_relaxed);
+    slots_[slot].store(size_ + 1, std::memory_order_release);
+    *id = size_++;
+    return true;
+}
+
+std::string LabelInterner::toString(const LabelBits& bits) {
+    std::atomic<const CacheEntry*>& slot = cache_[std::hash<LabelBits>()(bits) % kCacheSlots];
+    const CacheEntry* entry = slot.load(std::memory_order_acquire);
+    if (entry != nullptr && entry->bits == bits) {
+        return entry->str;
+    }
+
+    std::vector<absl::string_view> labels;
+    labels.reserve(bits.count());
+    for (LabelId id = 0; id < MAX_LABELS; id++) {
+        if (bits.test(id)) {
+            labels.push_back(names_[id]);
+        }
+    }
+    std::string str = joinLabels(&labels);
+
+    if (entry == nullptr) {
+        // Entries live as long as the process, the cache is bounded by its slots
+        const CacheEntry* created = new CacheEntry{bits, str};
+        if (!slot.compare_exchange_strong(entry, created, std::memory_order_release)) {
+            delete created;
+        }
+    }
+    return str;
+}
+
+LabelSet::LabelSet(absl::string_view str) {
+    while (!str.empty()) {
+        size_t pos = str.find(DELIM);
+        absl::string_view token = str.substr(0, pos);
+        if (!token.empty() && token != DEFAULT_NO_DATA) {
+            put(token);
+        }
+        if (pos == absl::string_view::npos) {
+            break;
+        }
+        str.remove_prefix(pos + DELIM.size());
+    }
+}
+
+// A label put before a config interned it stays in overflow_, so both
+// places are checked.
+bool LabelSet::contains(absl::string_view key) const {
+    LabelId id;
+    if (LabelInterner::get().lookup(key, &id) && bits_.test(id)) {
+        return true;
+    }
+    return std::binary_search(overflow_.begin(), overflow_.end(), key);
+}
+
+void LabelSet::put(absl::string_view key) {
+    // Labels from headers are untrusted, only configs assign IDs
+    LabelId id;
+    if (LabelInterner::get().lookup(key, &id)) {
+        put(id);
+        return;
+    }
+    auto it = std::lower_bound(overflow_.begin(), overflow_.end(), key);
+    if (it == overflow_.end() || *it != key) {
+        overflow_.emplace(it, key);
+    }
+}
+
+bool LabelSet::remove(absl::string_view key) {
+    LabelId id;
+    if (LabelInterner::get().lookup(key, &id)) {
+        return remove(id);
+    }
+    auto it = std::lower_bound(overflow_.begin(), overflow_.end(), key);
+    if (it == overflow_.end() || *it != key) {
+        return false;
+    }
+    overflow_.erase(it);
+    return true;
+}
+
+bool LabelSet::overflowContains(LabelId id) const {
+    const std::string& name = LabelInterner::get().name(id);
+    return std::binary_search(overflow_.begin(), overflow_.end(), name);
+}
+
+bool LabelSet::overflowRemove(LabelId id) {
+    const std::string& name = LabelInterner::get().name(id);
+    auto it = std::lower_bound(overflow_.begin(), overflow_.end(), name);
+    if (it == overflow_.end() || *it != name) {
+        return false;
+    }
+    overflow_.erase(it);
+    return true;
+}
+
+std::string LabelSet::toString() const {
+    if (overflow_.empty()) {
+        return LabelInterner::get().toString(bits_);
+    }
+    std::vector<absl::string_view> labels(overflow_.begin(), overflow_.end());
+    const LabelInterner& interner = LabelInterner::get();
+    for (LabelId id = 0; id < MAX_LABELS; id++) {
+        if (bits_.test(id)) {
+            labels.push_back(interner.name(id));
+        }
+    }
+    return joinLabels(&labels);
+}
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
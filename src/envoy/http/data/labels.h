@@ -15,7 +15,14 @@
 
 #pragma once
 
-#include "common/router/string_accessor_impl.h"
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
 
 namespace Envoy {
 namespace Http {
@@ -24,70 +31,123 @@ namespace Data {
 const std::string DELIM = ";";
 const std::string DEFAULT_NO_DATA = "__NONE__";
 
+// Number of distinct labels which can be given an ID
+constexpr size_t MAX_LABELS = 128;
+
+using LabelId = uint32_t;
+using LabelBits = std::bitset<MAX_LABELS>;
+
+/**
+ * Process wide mapping from label strings to small integer IDs.
+ *
+ * IDs are never released, so lookups are lock-free and only assigning a
+ * new ID locks. Once MAX_LABELS labels are known intern() fails and the
+ * caller has to keep the label as a string. Only labels from configs are
+ * interned, labels received in headers are looked up.
+ */
+class LabelInterner {
+public:
+    static LabelInterner& get();
+
+    // Finds the ID of label, assigning a new one if there is room
+    bool intern(absl::string_view label, LabelId* id);
+
+    // Finds the ID of label without assigning one
+    bool lookup(absl::string_view label, LabelId* id) const;
+
+    const std::string& name(LabelId id) const {
+        return names_[id];
+    }
+
+    // Returns the labels of bits sorted and joined by DELIM. The result is
+    // cached per distinct bitset.
+    std::string toString(const LabelBits& bits);
+
+private:
+    LabelInterner();
+
+    struct CacheEntry {
+        LabelBits bits;
+        std::string str;
+    };
+
+    // Open addressing table of the ids_ plus one, 0 marks an empty slot
+    static constexpr size_t kSlots = MAX_LABELS * 2;
+    // Direct mapped cache of canonical strings, entries are never replaced
+    static constexpr size_t kCacheSlots = 1024;
+
+    std::mutex mutex_;
+    std::array<std::atomic<LabelId>, kSlots> slots_;
+    std::array<std::atomic<size_t>, kSlots> hashes_;
+    // Written once before the ID is published in slots_
+    std::array<std::string, MAX_LABELS> names_;
+    LabelId size_{0};
+
+    std::array<std::atomic<const CacheEntry*>, kCacheSlots> cache_;
+};
+
+/**
+ * The set of data labels carried by the x-data header.
+ */
 class LabelSet {
 public:
-    LabelSet(std::string delim) {
-        _delim = delim;
+    LabelSet() {};
+
+    // Parses a DELIM separated list of labels
+    explicit LabelSet(absl::string_view str);
+
+    bool contains(absl::string_view key) const;
+
+    void put(absl::string_view key);
+
+    bool remove(absl::string_view key);
+
+    // Operations on interned labels are single bit operations, unless some
+    // labels are kept as strings. Those may have been interned since.
+    bool contains(LabelId id) const {
+        return bits_.test(id) || (!overflow_.empty() && overflowContains(id));
     };
 
-    LabelSet(std::string str, std::string delim) {
-        _delim = delim;
-        size_t pos = 0;
-        std::string s = str;
-        std::string token;
-        while ((pos = s.find(delim)) != std::string::npos) {
-            token = s.substr(0, pos);
-            if (token != DEFAULT_NO_DATA) {
-                _labels.insert(token);
-            }
-            s.erase(0, pos + delim.length());
-        }
-        if (s.length() > 0 && s != DEFAULT_NO_DATA) {
-            _labels.insert(s);
+    void put(LabelId id) {
+        bits_.set(id);
+        if (!overflow_.empty()) {
+            overflowRemove(id);
         }
     };
 
-    bool contains(std::string key) {
-        return _labels.find(key) != _labels.end();
+    bool remove(LabelId id) {
+        bool found = bits_.test(id);
+        bits_.reset(id);
+        if (!overflow_.empty()) {
+            found = overflowRemove(id) || found;
+        }
+        return found;
     };
 
-    void put(std::string key) {
-        _labels.insert(key);
+    int size() const {
+        return bits_.count() + overflow_.size();
     };
 
-    bool remove(std::string key) {
-        std::set<std::string>::iterator it = _labels.find(key);
-        if (it == _labels.end()) {
-            return false;
-        }
-        _labels.erase(it);
-        return true;
-    };
+    std::string toString() const;
 
-    int size() {
-        return _labels.size();
+    const LabelBits& bits() const {
+        return bits_;
     };
 
-    std::string toString() {
-        std::set<std::string>::iterator it;
-        std::string ret = "";
-        int count = 1;
-        for (it = _labels.begin(); it != _labels.end(); ++it)
-        {
-            ret += *it;
-            if (count < size()) {
-                ret += _delim;
-                count++;
-            }
-        }
-        return ret;
-    }
+    // Whether some labels are kept as strings instead of in bits()
+    bool hasOverflow() const {
+        return !overflow_.empty();
+    };
 
 private:
-    std::set<std::string> _labels;
-    std::string _delim;
+    bool overflowContains(LabelId id) const;
+    bool overflowRemove(LabelId id);
+
+    LabelBits bits_;
+    // Labels without an ID, sorted
+    std::vector<std::string> overflow_;
 };
 
 }  // namespace Data
 }  // namespace Http
-}  // namespace Envoy
\ No newline at end of file
+}  // namespace Envoy
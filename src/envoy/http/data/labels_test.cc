@@ -0,0 +1,76 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/labels.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+namespace {
+
+TEST(LabelSetTest, HeaderLabelsAreNotInterned) {
+    LabelSet labels("HEADER_ONLY_B;HEADER_ONLY_A;HEADER_ONLY_B");
+
+    LabelId id;
+    EXPECT_FALSE(LabelInterner::get().lookup("HEADER_ONLY_A", &id));
+    EXPECT_FALSE(LabelInterner::get().lookup("HEADER_ONLY_B", &id));
+    EXPECT_TRUE(labels.hasOverflow());
+    EXPECT_EQ(2, labels.size());
+    EXPECT_TRUE(labels.contains("HEADER_ONLY_A"));
+    EXPECT_EQ("HEADER_ONLY_A;HEADER_ONLY_B", labels.toString());
+
+    EXPECT_TRUE(labels.remove("HEADER_ONLY_A"));
+    EXPECT_FALSE(labels.remove("HEADER_ONLY_A"));
+    EXPECT_EQ("HEADER_ONLY_B", labels.toString());
+}
+
+TEST(LabelSetTest, ConfigLabelsUseBits) {
+    LabelId id;
+    ASSERT_TRUE(LabelInterner::get().intern("CONFIG_LABEL", &id));
+
+    LabelSet labels("CONFIG_LABEL;" + DEFAULT_NO_DATA);
+    EXPECT_FALSE(labels.hasOverflow());
+    EXPECT_TRUE(labels.contains(id));
+    EXPECT_TRUE(labels.contains("CONFIG_LABEL"));
+    EXPECT_EQ("CONFIG_LABEL", labels.toString());
+}
+
+TEST(LabelSetTest, LabelInternedAfterPut) {
+    LabelSet labels("INTERNED_LATER");
+    LabelId id;
+    ASSERT_TRUE(LabelInterner::get().intern("INTERNED_LATER", &id));
+
+    // The label stays a string but is still found by name and ID
+    EXPECT_TRUE(labels.contains("INTERNED_LATER"));
+    EXPECT_TRUE(labels.contains(id));
+    labels.put(id);
+    EXPECT_FALSE(labels.hasOverflow());
+    EXPECT_EQ(1, labels.size());
+    EXPECT_EQ("INTERNED_LATER", labels.toString());
+
+    LabelSet other("INTERNED_LATER_TOO");
+    LabelId other_id;
+    ASSERT_TRUE(LabelInterner::get().intern("INTERNED_LATER_TOO", &other_id));
+    EXPECT_TRUE(other.remove(other_id));
+    EXPECT_FALSE(other.contains("INTERNED_LATER_TOO"));
+    EXPECT_EQ(0, other.size());
+}
+
+}  // namespace
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
@@ -13,67 +13,685 @@
  * limitations under the License.
  */
 
-#include "common/router/string_accessor_impl.h"
 #include "src/envoy/http/data/map.h"
 
+#include <algorithm>
+#include <deque>
+#include <limits>
+
+#include "absl/hash/hash.h"
+
 namespace Envoy {
 namespace Http {
 namespace Data {
 
-std::string ThreadSafeStringMap::get(std::string key) {
-    m_.lock();
-    std::string value = _unsafe_get(key);
-    m_.unlock();
+namespace {
+
+// Buckets of a newly created shard, must be a power of two
+constexpr size_t kInitialBuckets = 16;
+
+// A shard grows once it holds this many keys per bucket
+constexpr size_t kMaxLoadFactor = 2;
+
+int64_t toMillis(MonotonicTime time) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            time.time_since_epoch()).count();
+}
+
+size_t roundUpToPowerOfTwo(size_t n) {
+    size_t ret = 1;
+    while (ret < n) {
+        ret <<= 1;
+    }
+    return ret;
+}
+
+// Values of a reader slot that don't pin any epoch
+constexpr uint64_t kFreeSlot = 0;
+constexpr uint64_t kIdleSlot = 1;
+
+// Threads that can read at the same time with a slot of their own, later
+// threads share one counter
+constexpr size_t kMaxReaders = 256;
+
+/**
+ * Epoch based reclamation shared by all maps of the process.
+ *
+ * A reader publishes the global epoch in a slot owned by its thread before
+ * it loads any node and clears it when done, so readers never write a cache
+ * line shared with other threads. A writer tags the nodes it unlinked with
+ * the epoch before advancing it, and frees them once every published epoch
+ * is newer than the tag.
+ */
+class EpochDomain {
+  public:
+    static EpochDomain& get() {
+        // Leaked, threads release their slots on exit
+        static EpochDomain* domain = new EpochDomain();
+        return *domain;
+    }
+
+    void enter() {
+        ThreadReader& reader = threadReader();
+        if (reader.depth++ > 0) {
+            return;
+        }
+        if (reader.slot == nullptr && !reader.registered) {
+            reader.registered = true;
+            reader.slot = acquireSlot();
+        }
+        if (reader.slot != nullptr) {
+            reader.slot->store(epoch_.load());
+        } else {
+            overflow_readers_.fetch_add(1);
+        }
+    }
+
+    void leave() {
+        ThreadReader& reader = threadReader();
+        if (--reader.depth > 0) {
+            return;
+        }
+        if (reader.slot != nullptr) {
+            reader.slot->store(kIdleSlot, std::memory_order_release);
+        } else {
+            overflow_readers_.fetch_sub(1);
+        }
+    }
+
+    // Closes the current epoch and returns it, call after unlinking nodes
+    uint64_t advance() {
+        return epoch_.fetch_add(1);
+    }
+
+    // Returns the oldest epoch a reader may still be in. Nodes retired in an
+    // older epoch are unreachable.
+    uint64_t oldestPinned() const {
+        if (overflow_readers_.load() != 0) {
+            return 0;
+        }
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        size_t used = used_slots_.load();
+        for (size_t i = 0; i < used; i++) {
+            uint64_t epoch = slots_[i].epoch.load();
+            if (epoch != kFreeSlot && epoch != kIdleSlot) {
+                oldest = std::min(oldest, epoch);
+            }
+        }
+        return oldest;
+    }
+
+  private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{kFreeSlot};
+    };
+
+    struct ThreadReader {
+        ~ThreadReader() {
+            if (slot != nullptr) {
+                slot->store(kFreeSlot, std::memory_order_release);
+            }
+        }
+
+        std::atomic<uint64_t>* slot = nullptr;
+        bool registered = false;
+        int depth = 0;
+    };
+
+    static ThreadReader& threadReader() {
+        static thread_local ThreadReader reader;
+        return reader;
+    }
+
+    std::atomic<uint64_t>* acquireSlot() {
+        for (size_t i = 0; i < kMaxReaders; i++) {
+            uint64_t expected = kFreeSlot;
+            if (slots_[i].epoch.compare_exchange_strong(expected, kIdleSlot)) {
+                size_t used = used_slots_.load();
+                while (used < i + 1 && !used_slots_.compare_exchange_weak(used, i + 1)) {
+                }
+                return &slots_[i].epoch;
+            }
+        }
+        return nullptr;
+    }
+
+    // Epochs start above the values of an unpinned slot
+    std::atomic<uint64_t> epoch_{kIdleSlot + 1};
+    Slot slots_[kMaxReaders];
+    // Slots ever handed out, the rest is never scanned
+    std::atomic<size_t> used_slots_{0};
+    // Readers without a slot, they pin every epoch while active
+    std::atomic<size_t> overflow_readers_{0};
+};
+
+// Pins the current epoch for the lifetime of the guard
+class ReadGuard {
+  public:
+    ReadGuard() {
+        EpochDomain::get().enter();
+    }
+    ~ReadGuard() {
+        EpochDomain::get().leave();
+    }
+};
+
+}  // namespace
+
+struct ThreadSafeStringMap::Entry {
+    Entry(size_t hash, absl::string_view key, int64_t now)
+        : hash(hash), key(key), listed(now), last_access(now) {}
+
+    const size_t hash;
+    const std::string key;
+
+    // Position in the recency list of the shard, guarded by its mutex
+    Entry* newer = nullptr;
+    Entry* older = nullptr;
+    // When the entry was last moved to the front of the list
+    int64_t listed;
+    bool removed = false;
+
+    // Refreshed by readers without locking, they queue the entry so that
+    // the next writer moves it to the front of the list
+    std::atomic<int64_t> last_access;
+    std::atomic<bool> queued{false};
+    Entry* next_queued = nullptr;
+};
+
+// The immutable node of a bucket chain. A key keeps its entry while its
+// node is copied or its value replaced.
+struct ThreadSafeStringMap::Node {
+    Node(Entry* entry, absl::string_view value, const Node* next)
+        : hash(entry->hash), entry(entry), value(value), next(next) {}
+
+    // Copies other with a new next
+    Node(const Node& other, const Node* next) : Node(other.entry, other.value, next) {}
+
+    const size_t hash;
+    Entry* const entry;
+    const std::string value;
+    const Node* const next;
+};
+
+struct ThreadSafeStringMap::Table {
+    explicit Table(size_t num_buckets)
+        : mask(num_buckets - 1), buckets(new std::atomic<const Node*>[num_buckets]) {
+        for (size_t i = 0; i < num_buckets; i++) {
+            buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<const Node*>& bucket(size_t hash) {
+        return buckets[hash & mask];
+    }
+
+    const size_t mask;
+    std::unique_ptr<std::atomic<const Node*>[]> buckets;
+};
+
+class ThreadSafeStringMap::Shard {
+  public:
+    Shard(const std::atomic<int64_t>& now, size_t max_size)
+        : now_(now), max_size_(max_size), table_(new Table(kInitialBuckets)) {}
+
+    ~Shard() {
+        // No reader may be left, free everything without waiting
+        retire(table_.load(std::memory_order_relaxed));
+        for (Entry* entry = newest_; entry != nullptr;) {
+            Entry* older = entry->older;
+            delete entry;
+            entry = older;
+        }
+        seal();
+        retired_.clear();
+    }
+
+    bool find(size_t hash, absl::string_view key, std::string* value) const {
+        // Pins every node reachable from table_ until the guard goes away
+        ReadGuard guard;
+        const Node* node = table_.load()->bucket(hash).load();
+        for (; node != nullptr; node = node->next) {
+            if (node->hash == hash && absl::string_view(node->entry->key) == key) {
+                break;
+            }
+        }
+        // Like get(), an empty value counts as missing
+        if (node == nullptr || node->value.empty()) {
+            return false;
+        }
+        touch(node->entry);
+        if (value != nullptr) {
+            value->assign(node->value);
+        }
+        return true;
+    }
+
+    bool write(size_t hash, absl::string_view key, absl::string_view value, Mode mode,
+               std::vector<std::string>* dropped) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drainTouched();
+        Table* table = table_.load(std::memory_order_relaxed);
+        std::atomic<const Node*>& bucket = table->bucket(hash);
+        const Node* head = bucket.load(std::memory_order_relaxed);
+
+        const Node* existing = head;
+        for (; existing != nullptr; existing = existing->next) {
+            if (existing->hash == hash && absl::string_view(existing->entry->key) == key) {
+                break;
+            }
+        }
+        // As with the original map, a key holding an empty value counts as
+        // missing: create() overwrites it, update() and del() leave it alone
+        bool exists = existing != nullptr && !existing->value.empty();
+        if (!exists && (mode == Mode::UPDATE || mode == Mode::DELETE)) {
+            return false;
+        }
+        if (exists && mode == Mode::CREATE) {
+            promote(existing->entry);
+            return false;
+        }
+
+        if (existing == nullptr) {
+            // New keys are prepended, the rest of the chain stays untouched
+            Entry* entry = new Entry(hash, key, now_.load(std::memory_order_relaxed));
+            link(entry);
+            bucket.store(new Node(entry, value, head));
+            size_++;
+            if (max_size_ > 0 && size_.load(std::memory_order_relaxed) > max_size_) {
+                evictOldest(dropped);
+            }
+            maybeGrow(table_.load(std::memory_order_relaxed));
+        } else if (mode == Mode::DELETE) {
+            remove(&bucket, [existing](const Node* node) { return node == existing; });
+        } else {
+            // Nodes are immutable, so rebuild the chain without the old node
+            const Node* chain = nullptr;
+            for (const Node* node = head; node != nullptr; node = node->next) {
+                if (node != existing) {
+                    chain = new Node(*node, chain);
+                }
+            }
+            bucket.store(new Node(existing->entry, value, chain));
+            retire(head);
+            promote(existing->entry);
+        }
+        reclaim();
+        return true;
+    }
+
+    // Removes the entries not accessed since deadline, walking the recency
+    // list from its oldest end.
+    size_t expire(int64_t deadline, std::vector<std::string>* dropped) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drainTouched();
+        size_t expired = 0;
+        Entry* entry = oldest_;
+        while (entry != nullptr && entry->listed < deadline) {
+            Entry* newer = entry->newer;
+            // A read racing with the drain leaves the entry for the next one
+            if (entry->last_access.load(std::memory_order_relaxed) < deadline) {
+                erase(entry, dropped);
+                expired++;
+            }
+            entry = newer;
+        }
+        reclaim();
+        return expired;
+    }
+
+    void drain() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drainTouched();
+    }
+
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t evictions() const {
+        return evictions_.load(std::memory_order_relaxed);
+    }
+
+    size_t retired() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t retired = pending_nodes_.size();
+        for (const Batch& batch : retired_) {
+            retired += batch.nodes.size();
+        }
+        return retired;
+    }
+
+  private:
+    // Records a read of entry. Only the first read of a tick queues it, and
+    // an entry is queued at most once until the queue is drained.
+    void touch(Entry* entry) const {
+        int64_t now = now_.load(std::memory_order_relaxed);
+        if (entry->last_access.load(std::memory_order_relaxed) == now) {
+            return;
+        }
+        entry->last_access.store(now, std::memory_order_relaxed);
+        if (entry->queued.exchange(true, std::memory_order_acquire)) {
+            return;
+        }
+        Entry* head = touched_.load(std::memory_order_relaxed);
+        do {
+            entry->next_queued = head;
+        } while (!touched_.compare_exchange_weak(head, entry, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    }
+
+    // Moves the entries read since the last drain to the front of the list
+    void drainTouched() {
+        Entry* entry = touched_.exchange(nullptr, std::memory_order_acquire);
+        while (entry != nullptr) {
+            Entry* next = entry->next_queued;
+            entry->queued.store(false, std::memory_order_release);
+            if (!entry->removed) {
+                promote(entry);
+            }
+            entry = next;
+        }
+    }
+
+    void link(Entry* entry) {
+        entry->older = newest_;
+        entry->newer = nullptr;
+        if (newest_ != nullptr) {
+            newest_->newer = entry;
+        } else {
+            oldest_ = entry;
+        }
+        newest_ = entry;
+    }
+
+    void unlink(Entry* entry) {
+        if (entry->newer != nullptr) {
+            entry->newer->older = entry->older;
+        } else {
+            newest_ = entry->older;
+        }
+        if (entry->older != nullptr) {
+            entry->older->newer = entry->newer;
+        } else {
+            oldest_ = entry->newer;
+        }
+    }
+
+    // Moves entry to the front of the list. The list stays ordered by
+    // listed, so a read is dated to the drain that handles it. Every tick
+    // starts with a drain, so that is only late for reads racing with it.
+    void promote(Entry* entry) {
+        int64_t now = now_.load(std::memory_order_relaxed);
+        entry->listed = now;
+        if (entry->last_access.load(std::memory_order_relaxed) < now) {
+            entry->last_access.store(now, std::memory_order_relaxed);
+        }
+        if (entry != newest_) {
+            unlink(entry);
+            link(entry);
+        }
+    }
+
+    // Rebuilds the chain of bucket without the nodes matching pred and
+    // returns how many were removed.
+    template <typename Pred>
+    size_t remove(std::atomic<const Node*>* bucket, Pred pred) {
+        const Node* head = bucket->load(std::memory_order_relaxed);
+        const Node* node = head;
+        while (node != nullptr && !pred(node)) {
+            node = node->next;
+        }
+        if (node == nullptr) {
+            return 0;
+        }
+        size_t removed = 0;
+        const Node* chain = nullptr;
+        for (node = head; node != nullptr; node = node->next) {
+            if (pred(node)) {
+                unlink(node->entry);
+                node->entry->removed = true;
+                pending_entries_.push_back(node->entry);
+                removed++;
+            } else {
+                chain = new Node(*node, chain);
+            }
+        }
+        bucket->store(chain);
+        retire(head);
+        size_ -= removed;
+        return removed;
+    }
+
+    // Removes the key of entry, which is still in the map
+    void erase(Entry* entry, std::vector<std::string>* dropped) {
+        if (dropped != nullptr) {
+            dropped->push_back(entry->key);
+        }
+        Table* table = table_.load(std::memory_order_relaxed);
+        remove(&table->bucket(entry->hash),
+               [entry](const Node* node) { return node->entry == entry; });
+    }
+
+    // Evicts the least recently used key of the shard. The key just added
+    // is at the front, so it is never the one evicted.
+    void evictOldest(std::vector<std::string>* dropped) {
+        if (oldest_ != nullptr && oldest_ != newest_) {
+            erase(oldest_, dropped);
+            evictions_++;
+        }
+    }
+
+    void maybeGrow(Table* table) {
+        size_t num_buckets = table->mask + 1;
+        if (size_.load(std::memory_order_relaxed) <= num_buckets * kMaxLoadFactor) {
+            return;
+        }
+        Table* grown = new Table(num_buckets * 2);
+        for (size_t i = 0; i < num_buckets; i++) {
+            const Node* node = table->buckets[i].load(std::memory_order_relaxed);
+            for (; node != nullptr; node = node->next) {
+                std::atomic<const Node*>& bucket = grown->bucket(node->hash);
+                bucket.store(new Node(*node, bucket.load(std::memory_order_relaxed)),
+                             std::memory_order_relaxed);
+            }
+        }
+        table_.store(grown);
+        retire(table);
+    }
+
+    // Nodes, entries and tables unlinked in the same epoch
+    struct Batch {
+        Batch() = default;
+        Batch(const Batch&) = delete;
+        ~Batch() {
+            for (const Node* node : nodes) {
+                delete node;
+            }
+            for (Entry* entry : entries) {
+                delete entry;
+            }
+        }
+
+        uint64_t epoch;
+        std::vector<const Node*> nodes;
+        std::vector<Entry*> entries;
+        std::vector<std::unique_ptr<Table>> tables;
+    };
+
+    void retire(const Node* chain) {
+        for (; chain != nullptr; chain = chain->next) {
+            pending_nodes_.push_back(chain);
+        }
+    }
+
+    void retire(Table* table) {
+        for (size_t i = 0; i <= table->mask; i++) {
+            retire(table->buckets[i].load(std::memory_order_relaxed));
+        }
+        pending_tables_.emplace_back(table);
+    }
+
+    // Tags what the current write retired with the epoch it was unlinked in
+    void seal() {
+        if (pending_nodes_.empty() && pending_entries_.empty() && pending_tables_.empty()) {
+            return;
+        }
+        retired_.emplace_back();
+        Batch& batch = retired_.back();
+        batch.epoch = EpochDomain::get().advance();
+        batch.nodes.swap(pending_nodes_);
+        batch.entries.swap(pending_entries_);
+        batch.tables.swap(pending_tables_);
+    }
+
+    // Frees the batches no reader can reach anymore. Readers are tracked
+    // per thread, so a steady stream of reads only holds back the batches
+    // retired while those particular reads were running.
+    void reclaim() {
+        seal();
+        if (retired_.empty()) {
+            return;
+        }
+        uint64_t oldest = EpochDomain::get().oldestPinned();
+        // A reader that saw a retired entry may have queued it before it
+        // left, so drain the queue after the readers were checked
+        drainTouched();
+        while (!retired_.empty() && retired_.front().epoch < oldest) {
+            retired_.pop_front();
+        }
+    }
+
+    const std::atomic<int64_t>& now_;
+    const size_t max_size_;
+
+    std::mutex mutex_;
+    std::atomic<Table*> table_;
+    std::atomic<size_t> size_{0};
+    std::atomic<uint64_t> evictions_{0};
+
+    // Entries read since the last drain, a lock free stack
+    mutable std::atomic<Entry*> touched_{nullptr};
+    // The recency list, guarded by mutex_
+    Entry* newest_ = nullptr;
+    Entry* oldest_ = nullptr;
+
+    // Replaced nodes and tables waiting for readers to leave, guarded by mutex_
+    std::vector<const Node*> pending_nodes_;
+    std::vector<Entry*> pending_entries_;
+    std::vector<std::unique_ptr<Table>> pending_tables_;
+    std::deque<Batch> retired_;
+};
+
+ThreadSafeStringMap::ThreadSafeStringMap(TimeSource& time_source, size_t max_size,
+                                         size_t num_shards)
+    : time_source_(time_source), now_(toMillis(time_source.monotonicTime())) {
+    num_shards = roundUpToPowerOfTwo(num_shards);
+    // Each shard gets an equal share of the bound, but at least one key
+    size_t max_shard_size = max_size == 0 ? 0 : std::max<size_t>(1, max_size / num_shards);
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; i++) {
+        shards_.emplace_back(new Shard(now_, max_shard_size));
+    }
+}
+
+ThreadSafeStringMap::~ThreadSafeStringMap() {}
+
+void ThreadSafeStringMap::setDropCallback(DropCallback callback) {
+    drop_callback_ = std::move(callback);
+}
+
+ThreadSafeStringMap::Shard& ThreadSafeStringMap::shard(size_t hash) const {
+    // Buckets use the low bits of the hash, shards the high ones
+    return *shards_[(hash >> (sizeof(size_t) * 4)) & (shards_.size() - 1)];
+}
+
+std::string ThreadSafeStringMap::get(absl::string_view key) const {
+    std::string value;
+    find(key, &value);
     return value;
 }
 
-void ThreadSafeStringMap::put(std::string key, std::string value) {
-    m_.lock();
-    map_[key] = value;
-    m_.unlock();
+bool ThreadSafeStringMap::find(absl::string_view key, std::string* value) const {
+    size_t hash = absl::Hash<absl::string_view>()(key);
+    return shard(hash).find(hash, key, value);
+}
+
+bool ThreadSafeStringMap::write(absl::string_view key, absl::string_view value, Mode mode) {
+    size_t hash = absl::Hash<absl::string_view>()(key);
+    std::vector<std::string> dropped;
+    bool written = shard(hash).write(hash, key, value, mode, &dropped);
+    // Outside of the shard lock, the callback may write to another map
+    notifyDropped(dropped);
+    return written;
 }
 
-bool ThreadSafeStringMap::update(std::string key, std::string value) {
-    m_.lock();
-    bool updated = false;
-    if (_unsafe_get(key).length() != 0) {
-        map_[key] = value;
-        updated = true;
+void ThreadSafeStringMap::notifyDropped(const std::vector<std::string>& keys) {
+    if (drop_callback_ == nullptr) {
+        return;
+    }
+    for (const std::string& key : keys) {
+        drop_callback_(key);
     }
-    m_.unlock();
-    return updated;
 }
 
-bool ThreadSafeStringMap::create(std::string key, std::string value) {
-    m_.lock();
-    bool created = false;
-    if (_unsafe_get(key).length() == 0) {
-        map_[key] = value;
-        created = true;
+void ThreadSafeStringMap::put(absl::string_view key, absl::string_view value) {
+    write(key, value, Mode::PUT);
+}
+
+bool ThreadSafeStringMap::update(absl::string_view key, absl::string_view value) {
+    return write(key, value, Mode::UPDATE);
+}
+
+bool ThreadSafeStringMap::create(absl::string_view key, absl::string_view value) {
+    return write(key, value, Mode::CREATE);
+}
+
+bool ThreadSafeStringMap::del(absl::string_view key) {
+    return write(key, absl::string_view(), Mode::DELETE);
+}
+
+size_t ThreadSafeStringMap::size() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+        size += shard->size();
     }
-    m_.unlock();
-    return created;
+    return size;
 }
 
-bool ThreadSafeStringMap::del(std::string key) {
-    m_.lock();
-    bool found = false;
-    if (_unsafe_get(key).length() != 0) {
-        map_.erase(key);
-        found = true;
+size_t ThreadSafeStringMap::expire(std::chrono::milliseconds ttl) {
+    // Reads so far happened before now, move them while they still date so
+    for (const auto& shard : shards_) {
+        shard->drain();
     }
-    m_.unlock();
-    return found;
+    int64_t now = toMillis(time_source_.monotonicTime());
+    now_.store(now, std::memory_order_relaxed);
+    size_t expired = 0;
+    std::vector<std::string> dropped;
+    for (const auto& shard : shards_) {
+        expired += shard->expire(now - ttl.count(), &dropped);
+        notifyDropped(dropped);
+        dropped.clear();
+    }
+    return expired;
 }
 
-std::string ThreadSafeStringMap::_unsafe_get(std::string key) {
-    std::string value = "";
-    if (map_.find(key) != map_.end()) {
-        value = map_[key];
+size_t ThreadSafeStringMap::retired() const {
+    size_t retired = 0;
+    for (const auto& shard : shards_) {
+        retired += shard->retired();
     }
-    return value;
+    return retired;
+}
+
+uint64_t ThreadSafeStringMap::evictions() const {
+    uint64_t evictions = 0;
+    for (const auto& shard : shards_) {
+        evictions += shard->evictions();
+    }
+    return evictions;
 }
 
 }  // namespace Data
 }  // namespace Http
-}  // namespace Envoy
\ No newline at end of file
+}  // namespace Envoy
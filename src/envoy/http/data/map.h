@@ -15,33 +15,104 @@
 
 #pragma once
 
-#include "common/router/string_accessor_impl.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "envoy/common/time.h"
 
 namespace Envoy {
 namespace Http {
 namespace Data {
 
+/**
+ * A concurrent string to string hash map split into shards.
+ *
+ * Writers serialize on a per shard mutex and replace the affected bucket
+ * chain copy-on-write. Readers never lock: they publish the current epoch in
+ * a slot of their thread, walk the immutable chain and clear the slot.
+ * Replaced nodes are freed by a later writer once every reader that could
+ * still see them has left.
+ *
+ * As in the original map, a key holding an empty value counts as missing.
+ *
+ * Every key remembers when it was last accessed, at the granularity of the
+ * calls to expire(), and each shard keeps its keys in a recency list. Writes
+ * move a key to the front under the shard lock, reads queue it lock free and
+ * the next write or expire() moves it. expire() drops keys that were idle for
+ * too long starting from the back of the lists, and with a max_size a write
+ * to a full shard evicts the key at the back of its list.
+ */
 class ThreadSafeStringMap {
   public:
-    ThreadSafeStringMap() {};
-    std::string get(std::string key);
+    // max_size bounds the number of keys, 0 means unbounded
+    ThreadSafeStringMap(TimeSource& time_source, size_t max_size = 0, size_t num_shards = 64);
+    ~ThreadSafeStringMap();
+
+    ThreadSafeStringMap(const ThreadSafeStringMap&) = delete;
+    ThreadSafeStringMap& operator=(const ThreadSafeStringMap&) = delete;
+
+    // Called with each key the map drops by itself, i.e. expired or evicted.
+    // It runs after the shard is unlocked, so it may write to other maps.
+    using DropCallback = std::function<void(absl::string_view key)>;
+
+    // Must be set before the map is used from several threads
+    void setDropCallback(DropCallback callback);
+
+    // Returns the value of key, or an empty string if it doesn't exist
+    std::string get(absl::string_view key) const;
+
+    // Copies the value of key into value unless it is null, returns false if
+    // it doesn't exist
+    bool find(absl::string_view key, std::string* value) const;
 
     // Sets a Key Value pair
-    void put(std::string key, std::string value);
+    void put(absl::string_view key, absl::string_view value);
 
     // Performs a put iff the key exists
-    bool update(std::string key, std::string value);
+    bool update(absl::string_view key, absl::string_view value);
 
     // Performs a put iff the key doesnt exist
-    bool create(std::string key, std::string value);
+    bool create(absl::string_view key, absl::string_view value);
 
     // Deletes an existing key
-    bool del(std::string key);
+    bool del(absl::string_view key);
+
+    // Number of keys in the map
+    size_t size() const;
+
+    // Removes the keys not accessed within ttl and advances the access time
+    // of later operations to now. Returns the number of removed keys.
+    size_t expire(std::chrono::milliseconds ttl);
+
+    // Total number of keys evicted to stay within max_size
+    uint64_t evictions() const;
+
+    // Number of replaced nodes not freed yet
+    size_t retired() const;
 
   private:
-    std::string _unsafe_get(std::string key);
-    std::map<std::string, std::string> map_;
-    std::mutex m_;
+    struct Entry;
+    struct Node;
+    struct Table;
+    class Shard;
+
+    enum class Mode { PUT, UPDATE, CREATE, DELETE };
+
+    Shard& shard(size_t hash) const;
+    bool write(absl::string_view key, absl::string_view value, Mode mode);
+    void notifyDropped(const std::vector<std::string>& keys);
+
+    TimeSource& time_source_;
+    // The access time given to keys, in milliseconds of the monotonic clock
+    std::atomic<int64_t> now_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    DropCallback drop_callback_;
 };
 
 }  // namespace Data
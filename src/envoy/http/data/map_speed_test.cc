@@ -0,0 +1,90 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "common/event/real_time_system.h"
+#include "src/envoy/http/data/map.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+// Number of traces that are live at any time in the benchmarks
+constexpr int kLiveTraces = 1024;
+
+ThreadSafeStringMap* sharedMap() {
+    static ThreadSafeStringMap* map = [] {
+        static Event::RealTimeSystem time_system;
+        ThreadSafeStringMap* map = new ThreadSafeStringMap(time_system);
+        for (int i = 0; i < kLiveTraces; i++) {
+            map->put("shared-" + std::to_string(i), "LABEL_A;LABEL_B");
+        }
+        return map;
+    }();
+    return map;
+}
+
+// Read only lookups of existing traces from all threads
+static void BM_MapGet(benchmark::State& state) {
+    ThreadSafeStringMap* map = sharedMap();
+    std::vector<std::string> keys;
+    for (int i = 0; i < kLiveTraces; i++) {
+        keys.push_back("shared-" + std::to_string(i));
+    }
+    std::string value;
+    size_t i = state.thread_index;
+    for (auto _ : state) {
+        map->find(keys[i++ % keys.size()], &value);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_MapGet)->ThreadRange(1, 16)->UseRealTime();
+
+// The access pattern of one traced request: decodeHeaders creates the parent
+// and data entries and reads the data back, encodeHeaders reads the parent,
+// updates the data and finally deletes both.
+static void BM_MapTraceLifecycle(benchmark::State& state) {
+    ThreadSafeStringMap* map = sharedMap();
+    std::vector<std::string> keys;
+    for (int i = 0; i < kLiveTraces; i++) {
+        keys.push_back("trace-" + std::to_string(state.thread_index) + "-" + std::to_string(i));
+    }
+    std::string value;
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& key = keys[i++ % keys.size()];
+        map->create(key, "42");
+        map->find(key, &value);
+        map->update(key, "LABEL_A;LABEL_B");
+        map->find(key, &value);
+        map->del(key);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_MapTraceLifecycle)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs
+// them.
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+}
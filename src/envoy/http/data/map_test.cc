@@ -0,0 +1,297 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/map.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+namespace {
+
+class FakeTimeSource : public TimeSource {
+  public:
+    SystemTime systemTime() override {
+        return SystemTime();
+    }
+    MonotonicTime monotonicTime() override {
+        return now_;
+    }
+
+    void advance(std::chrono::milliseconds duration) {
+        now_ += duration;
+    }
+
+  private:
+    MonotonicTime now_;
+};
+
+class ThreadSafeStringMapTest : public ::testing::Test {
+  protected:
+    FakeTimeSource time_source_;
+};
+
+TEST_F(ThreadSafeStringMapTest, PutUpdateCreateDelete) {
+    ThreadSafeStringMap map(time_source_);
+
+    EXPECT_FALSE(map.update("trace", "A"));
+    EXPECT_FALSE(map.del("trace"));
+    EXPECT_TRUE(map.create("trace", "A"));
+    EXPECT_FALSE(map.create("trace", "B"));
+    EXPECT_EQ("A", map.get("trace"));
+
+    EXPECT_TRUE(map.update("trace", "C"));
+    EXPECT_EQ("C", map.get("trace"));
+    map.put("trace", "D");
+    EXPECT_EQ("D", map.get("trace"));
+    EXPECT_EQ(1, map.size());
+
+    EXPECT_TRUE(map.del("trace"));
+    EXPECT_FALSE(map.del("trace"));
+    EXPECT_FALSE(map.find("trace", nullptr));
+    EXPECT_EQ("", map.get("trace"));
+    EXPECT_EQ(0, map.size());
+}
+
+TEST_F(ThreadSafeStringMapTest, EmptyValueCountsAsMissing) {
+    ThreadSafeStringMap map(time_source_);
+
+    map.put("trace", "");
+    EXPECT_FALSE(map.find("trace", nullptr));
+    EXPECT_FALSE(map.update("trace", "A"));
+    EXPECT_FALSE(map.del("trace"));
+
+    EXPECT_TRUE(map.create("trace", "A"));
+    EXPECT_EQ("A", map.get("trace"));
+}
+
+TEST_F(ThreadSafeStringMapTest, ReplaceAndDeleteWithinChains) {
+    // Few shards and many keys, so buckets hold chains and the tables grow
+    ThreadSafeStringMap map(time_source_, 0, 2);
+    constexpr int kKeys = 1000;
+    for (int i = 0; i < kKeys; i++) {
+        EXPECT_TRUE(map.create("key-" + std::to_string(i), std::to_string(i)));
+    }
+    for (int i = 0; i < kKeys; i += 2) {
+        EXPECT_TRUE(map.update("key-" + std::to_string(i), "even"));
+    }
+    for (int i = 0; i < kKeys; i += 3) {
+        EXPECT_TRUE(map.del("key-" + std::to_string(i)));
+    }
+
+    size_t expected_size = 0;
+    for (int i = 0; i < kKeys; i++) {
+        std::string value;
+        bool found = map.find("key-" + std::to_string(i), &value);
+        if (i % 3 == 0) {
+            EXPECT_FALSE(found);
+            continue;
+        }
+        expected_size++;
+        EXPECT_TRUE(found);
+        EXPECT_EQ(i % 2 == 0 ? "even" : std::to_string(i), value);
+    }
+    EXPECT_EQ(expected_size, map.size());
+}
+
+TEST_F(ThreadSafeStringMapTest, ConcurrentWritersAndReaders) {
+    ThreadSafeStringMap map(time_source_, 0, 4);
+    constexpr int kThreads = 8;
+    constexpr int kKeys = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&map, t] {
+            std::string prefix = std::to_string(t) + "-";
+            std::string other = std::to_string((t + 1) % kThreads) + "-";
+            std::string value;
+            for (int i = 0; i < kKeys; i++) {
+                std::string key = prefix + std::to_string(i);
+                EXPECT_TRUE(map.create(key, "created"));
+                EXPECT_TRUE(map.update(key, key));
+                EXPECT_TRUE(map.find(key, &value));
+                EXPECT_EQ(key, value);
+                // Keys of another thread may or may not be there yet
+                map.find(other + std::to_string(i), &value);
+                if (i % 2 == 0) {
+                    EXPECT_TRUE(map.del(key));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(kThreads * kKeys / 2, map.size());
+    for (int t = 0; t < kThreads; t++) {
+        for (int i = 0; i < kKeys; i++) {
+            std::string key = std::to_string(t) + "-" + std::to_string(i);
+            EXPECT_EQ(i % 2 == 0 ? "" : key, map.get(key));
+        }
+    }
+}
+
+TEST_F(ThreadSafeStringMapTest, ExpiresIdleKeys) {
+    ThreadSafeStringMap map(time_source_, 0, 1);
+    std::vector<std::string> dropped;
+    map.setDropCallback([&dropped](absl::string_view key) { dropped.emplace_back(key); });
+    map.put("read", "A");
+    map.put("idle", "B");
+
+    time_source_.advance(std::chrono::seconds(30));
+    EXPECT_EQ(0, map.expire(std::chrono::seconds(60)));
+    EXPECT_TRUE(map.find("read", nullptr));
+
+    time_source_.advance(std::chrono::seconds(40));
+    EXPECT_EQ(1, map.expire(std::chrono::seconds(60)));
+    EXPECT_EQ(std::vector<std::string>({"idle"}), dropped);
+    EXPECT_EQ("A", map.get("read"));
+    EXPECT_EQ("", map.get("idle"));
+
+    // The get() above was the last access
+    time_source_.advance(std::chrono::seconds(60));
+    EXPECT_EQ(0, map.expire(std::chrono::seconds(60)));
+    time_source_.advance(std::chrono::seconds(1));
+    EXPECT_EQ(1, map.expire(std::chrono::seconds(60)));
+    EXPECT_EQ(std::vector<std::string>({"idle", "read"}), dropped);
+    EXPECT_EQ(0, map.size());
+    EXPECT_EQ(0, map.evictions());
+}
+
+TEST_F(ThreadSafeStringMapTest, EvictsLeastRecentlyUsed) {
+    ThreadSafeStringMap map(time_source_, 3, 1);
+    std::vector<std::string> dropped;
+    map.setDropCallback([&dropped](absl::string_view key) { dropped.emplace_back(key); });
+    map.put("a", "1");
+    map.put("b", "2");
+    map.put("c", "3");
+
+    // Reads are recorded per tick, start a new one
+    time_source_.advance(std::chrono::seconds(1));
+    map.expire(std::chrono::hours(1));
+    EXPECT_TRUE(map.find("a", nullptr));
+
+    map.put("d", "4");
+    EXPECT_EQ(std::vector<std::string>({"b"}), dropped);
+    map.put("e", "5");
+    EXPECT_EQ(std::vector<std::string>({"b", "c"}), dropped);
+
+    // Writes move a key to the front as well
+    EXPECT_TRUE(map.update("a", "6"));
+    map.put("f", "7");
+    EXPECT_EQ(std::vector<std::string>({"b", "c", "d"}), dropped);
+
+    EXPECT_EQ(3, map.size());
+    EXPECT_EQ(3, map.evictions());
+    EXPECT_EQ("6", map.get("a"));
+    EXPECT_EQ("5", map.get("e"));
+    EXPECT_EQ("7", map.get("f"));
+}
+
+TEST_F(ThreadSafeStringMapTest, DropCallbackMayWriteToOtherMaps) {
+    ThreadSafeStringMap parents(time_source_, 1, 1);
+    ThreadSafeStringMap data(time_source_, 1, 1);
+    parents.setDropCallback([&data](absl::string_view key) { data.del(key); });
+    data.setDropCallback([&parents](absl::string_view key) { parents.del(key); });
+
+    parents.put("first", "1");
+    data.put("first", "A");
+    // Evicting the first trace from one map drops it from the other one
+    parents.put("second", "2");
+    EXPECT_EQ("", data.get("first"));
+    data.put("second", "B");
+    EXPECT_EQ(1, parents.size());
+    EXPECT_EQ(1, data.size());
+}
+
+TEST_F(ThreadSafeStringMapTest, ConcurrentEvictionAndExpiry) {
+    ThreadSafeStringMap map(time_source_, 256, 4);
+    constexpr int kThreads = 4;
+    std::atomic<int> running{kThreads};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&map, &running, t] {
+            std::string value;
+            for (int i = 0; i < 100000; i++) {
+                // Reads queue keys that writers concurrently evict
+                map.find(std::to_string(i % 512), &value);
+                if (i % kThreads == t) {
+                    map.put(std::to_string(i % 512), "value");
+                }
+            }
+            running--;
+        });
+    }
+    // Only this thread advances the time, as the expiry timer would
+    while (running.load() > 0) {
+        time_source_.advance(std::chrono::milliseconds(10));
+        map.expire(std::chrono::milliseconds(500));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_LE(map.size(), 256);
+}
+
+TEST_F(ThreadSafeStringMapTest, ReclaimsWhileReadersKeepReading) {
+    ThreadSafeStringMap map(time_source_, 0, 1);
+    map.put("hot", "0");
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&map, &done] {
+            std::string value;
+            while (!done.load()) {
+                EXPECT_TRUE(map.find("hot", &value));
+            }
+        });
+    }
+
+    // With a shared reader count the replaced nodes would pile up as long as
+    // some reader is active, per thread epochs only hold back the nodes
+    // replaced during the reads in flight.
+    constexpr int kWrites = 20000;
+    for (int i = 0; i < kWrites; i++) {
+        map.put("hot", std::to_string(i));
+    }
+    size_t retired = map.retired();
+    for (int i = 0; i < kWrites && retired >= 100; i++) {
+        map.put("hot", "again");
+        retired = map.retired();
+    }
+    EXPECT_LT(retired, 100);
+
+    done.store(true);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    // Without readers the next write frees everything
+    map.put("hot", "last");
+    EXPECT_EQ(0, map.retired());
+    EXPECT_EQ("last", map.get("hot"));
+}
+
+}  // namespace
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
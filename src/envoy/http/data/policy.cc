@@ -0,0 +1,217 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/policy.h"
+
+#include "common/common/macros.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+namespace {
+
+// Number of distinct x-data-override values whose program is cached
+constexpr size_t kMaxCachedOverrides = 64;
+
+// Longer x-data-override values are parsed on every request instead
+constexpr size_t kMaxCachedOverrideLength = 1024;
+
+bool parseOperation(absl::string_view str, data::FilterConfig_Operation *op) {
+    if (str == "ADD") {
+        *op = data::FilterConfig::ADD;
+    } else if (str == "REMOVE") {
+        *op = data::FilterConfig::REMOVE;
+    } else if (str == "CHECK_INCLUDE") {
+        *op = data::FilterConfig::CHECK_INCLUDE;
+    } else if (str == "CHECK_EXCLUDE") {
+        *op = data::FilterConfig::CHECK_EXCLUDE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+DataTracingFilterConfig::DataTracingFilterConfig(const data::FilterConfig &proto_config)
+    : codec_(proto_config.label_table()),
+      compact_encoding_(proto_config.compact_encoding() && proto_config.label_table_size() > 0) {
+    for (const auto& action : proto_config.actions()) {
+        if (!data::FilterConfig_When_IsValid(action.when())) {
+            ENVOY_LOG(warn, "Ignoring action on {} with unknown direction {}",
+                      action.member(), action.when());
+            continue;
+        }
+        add(action.operation(), action.when(), action.member(), true);
+    }
+}
+
+DataTracingFilterConfig::DataTracingFilterConfig(absl::string_view overrides) {
+    while (!overrides.empty()) {
+        size_t pos = overrides.find(DELIM);
+        absl::string_view token = overrides.substr(0, pos);
+        overrides.remove_prefix(pos == absl::string_view::npos ? overrides.size()
+                                                               : pos + DELIM.size());
+        size_t open = token.find('(');
+        data::FilterConfig_Operation op;
+        if (open == absl::string_view::npos || token.back() != ')' ||
+            !parseOperation(token.substr(0, open), &op)) {
+            ENVOY_LOG(debug, "Ignoring malformed override operation {}", token);
+            continue;
+        }
+        absl::string_view member = token.substr(open + 1, token.size() - open - 2);
+        if (member.empty()) {
+            ENVOY_LOG(debug, "Ignoring override operation {} without a label", token);
+            continue;
+        }
+        // Overrides come from headers, they must not use up label IDs
+        add(op, data::FilterConfig::INBOUND, member, false);
+        add(op, data::FilterConfig::OUTBOUND, member, false);
+    }
+}
+
+void DataTracingFilterConfig::add(data::FilterConfig_Operation operation,
+                                  data::FilterConfig_When when, absl::string_view member,
+                                  bool intern) {
+    if (operation == data::FilterConfig::SKIP || !data::FilterConfig_Operation_IsValid(operation)) {
+        return;
+    }
+    DataPolicyInstruction instruction{operation, false, 0, ""};
+    LabelInterner& interner = LabelInterner::get();
+    instruction.interned = intern ? interner.intern(member, &instruction.label)
+                                  : interner.lookup(member, &instruction.label);
+    if (!instruction.interned) {
+        instruction.member = std::string(member);
+    }
+    instructions_[when].push_back(std::move(instruction));
+}
+
+bool DataTracingFilterConfig::apply(LabelSet &labels, data::FilterConfig_When when) const {
+    for (const DataPolicyInstruction& instruction : instructions_[when]) {
+        bool contains;
+        switch (instruction.operation) {
+            case data::FilterConfig::ADD:
+                if (instruction.interned) {
+                    labels.put(instruction.label);
+                } else {
+                    labels.put(instruction.member);
+                }
+                break;
+            case data::FilterConfig::REMOVE:
+                if (instruction.interned) {
+                    labels.remove(instruction.label);
+                } else {
+                    labels.remove(instruction.member);
+                }
+                break;
+            case data::FilterConfig::CHECK_INCLUDE:
+            case data::FilterConfig::CHECK_EXCLUDE:
+                contains = instruction.interned ? labels.contains(instruction.label)
+                                                : labels.contains(instruction.member);
+                if (contains != (instruction.operation == data::FilterConfig::CHECK_INCLUDE)) {
+                    ENVOY_LOG(trace, "Data policy check {} on {} failed", instruction.operation,
+                              instruction.interned ? LabelInterner::get().name(instruction.label)
+                                                   : instruction.member);
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+DataPolicyOverrideCache::DataPolicyOverrideCache(size_t max_entries)
+    : max_entries_(max_entries) {}
+
+DataPolicyOverrideCache& DataPolicyOverrideCache::get() {
+    MUTABLE_CONSTRUCT_ON_FIRST_USE(DataPolicyOverrideCache, kMaxCachedOverrides);
+}
+
+DataTracingFilterConfigConstSharedPtr DataPolicyOverrideCache::lookup(absl::string_view overrides) {
+    if (overrides.size() > kMaxCachedOverrideLength) {
+        return std::make_shared<const DataTracingFilterConfig>(overrides);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(overrides);
+        if (it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->program;
+        }
+    }
+
+    // Parse outside the lock, a concurrent miss on the same value is harmless
+    DataTracingFilterConfigConstSharedPtr program =
+            std::make_shared<const DataTracingFilterConfig>(overrides);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(overrides);
+    if (it != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->program;
+    }
+    if (entries_.size() >= max_entries_) {
+        index_.erase(entries_.back().overrides);
+        entries_.pop_back();
+    }
+    entries_.push_front(Entry{std::string(overrides), program});
+    index_.emplace(entries_.front().overrides, entries_.begin());
+    return program;
+}
+
+size_t DataPolicyOverrideCache::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+DataPolicyResults DataPolicy::apply(const DataTracingFilterConfigSharedPtr &config,
+                                    absl::string_view data_contents,
+                                    data::FilterConfig_When when,
+                                    absl::string_view overrides) {
+    return apply(config, LabelSet(data_contents), when, overrides);
+}
+
+DataPolicyResults DataPolicy::apply(const DataTracingFilterConfigSharedPtr &config,
+                                    LabelSet l,
+                                    data::FilterConfig_When when,
+                                    absl::string_view overrides) {
+    DataPolicyResults results{};
+    results.status = Http::FilterHeadersStatus::StopIteration;
+    if (!config->apply(l, when)) {
+        return results;
+    }
+    if (overrides.length() > 0) {
+        ENVOY_LOG(trace, "Applying override operations {}", overrides);
+        if (!DataPolicyOverrideCache::get().lookup(overrides)->apply(l, when)) {
+            return results;
+        }
+    }
+
+    if (l.size() == 0) {
+        results.data = DEFAULT_NO_DATA;
+    } else {
+        results.data = l.toString();
+    }
+    results.labels = std::move(l);
+    results.status = Http::FilterHeadersStatus::Continue;
+    return results;
+}
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
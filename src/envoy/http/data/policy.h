@@ -0,0 +1,153 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "common/common/logger.h"
+#include "envoy/http/filter.h"
+#include "src/envoy/http/data/codec.h"
+#include "src/envoy/http/data/labels.h"
+#include "src/istio/data/data_filter.pb.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+/**
+ * One precompiled policy operation.
+ */
+struct DataPolicyInstruction {
+    data::FilterConfig_Operation operation;
+    // Whether the member has an ID from the LabelInterner
+    bool interned;
+    LabelId label;
+    // Only used when the member is not interned
+    std::string member;
+};
+
+/**
+ * A data policy compiled into one instruction list per direction.
+ */
+class DataTracingFilterConfig : Logger::Loggable<Logger::Id::filter> {
+public:
+    explicit DataTracingFilterConfig(const data::FilterConfig &proto_config);
+
+    // Parses x-data-override operations i.e. ADD(label);REMOVE(label), they
+    // apply in both directions. Malformed or unknown operations are skipped.
+    explicit DataTracingFilterConfig(absl::string_view overrides);
+
+    // Applies the instructions for when to labels, returns false as soon as
+    // a check fails.
+    bool apply(LabelSet &labels, data::FilterConfig_When when) const;
+
+    // Number of instructions for when
+    size_t size(data::FilterConfig_When when) const {
+        return instructions_[when].size();
+    }
+
+    // Decodes compact x-data values received from other hops
+    const LabelCodec& codec() const {
+        return codec_;
+    }
+
+    // Whether x-data is sent in the compact encoding when possible
+    bool compactEncoding() const {
+        return compact_encoding_;
+    }
+
+private:
+    // Assigns member an ID if intern, otherwise only uses an existing one
+    void add(data::FilterConfig_Operation operation, data::FilterConfig_When when,
+             absl::string_view member, bool intern);
+
+    // Indexed by data::FilterConfig_When
+    std::array<std::vector<DataPolicyInstruction>, data::FilterConfig_When_When_ARRAYSIZE>
+            instructions_;
+    LabelCodec codec_;
+    bool compact_encoding_{false};
+};
+
+using DataTracingFilterConfigSharedPtr = std::shared_ptr<DataTracingFilterConfig>;
+using DataTracingFilterConfigConstSharedPtr = std::shared_ptr<const DataTracingFilterConfig>;
+
+/**
+ * A bounded, thread-safe cache of parsed x-data-override programs keyed by
+ * the header value. Clients tend to resend a handful of distinct values.
+ * The least recently used value is evicted, hits and evictions take
+ * constant time under the lock.
+ */
+class DataPolicyOverrideCache {
+public:
+    explicit DataPolicyOverrideCache(size_t max_entries);
+
+    static DataPolicyOverrideCache& get();
+
+    // Returns the parsed program of overrides, parsing it on a miss
+    DataTracingFilterConfigConstSharedPtr lookup(absl::string_view overrides);
+
+    size_t size();
+
+private:
+    struct Entry {
+        std::string overrides;
+        DataTracingFilterConfigConstSharedPtr program;
+    };
+    using EntryList = std::list<Entry>;
+
+    const size_t max_entries_;
+    std::mutex mutex_;
+    // Most recently used first
+    EntryList entries_;
+    // Keys point into the strings of entries_
+    absl::flat_hash_map<absl::string_view, EntryList::iterator> index_;
+};
+
+class DataPolicyResults {
+
+public:
+    Http::FilterHeadersStatus status;
+    std::string data;
+    LabelSet labels;
+};
+
+/**
+ * Evaluates the data policy of a request or response on its labels.
+ */
+class DataPolicy : Logger::Loggable<Logger::Id::filter> {
+public:
+    // Applies the actions of config for when, then the overrides, to the
+    // labels in data_contents.
+    static DataPolicyResults apply(const DataTracingFilterConfigSharedPtr &config,
+                                   absl::string_view data_contents,
+                                   data::FilterConfig_When when,
+                                   absl::string_view overrides);
+
+    // Same as above on labels that are already parsed
+    static DataPolicyResults apply(const DataTracingFilterConfigSharedPtr &config,
+                                   LabelSet labels,
+                                   data::FilterConfig_When when,
+                                   absl::string_view overrides);
+};
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,101 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "src/envoy/http/data/policy.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+// A policy checking and rewriting the labels of a request
+DataTracingFilterConfigSharedPtr policyConfig() {
+    data::FilterConfig proto_config;
+    auto add_action = [&proto_config](data::FilterConfig_Operation op,
+                                      data::FilterConfig_When when, const std::string& member) {
+        auto* action = proto_config.add_actions();
+        action->set_operation(op);
+        action->set_when(when);
+        action->set_member(member);
+    };
+    add_action(data::FilterConfig::CHECK_EXCLUDE, data::FilterConfig::INBOUND, "SECRET");
+    add_action(data::FilterConfig::CHECK_INCLUDE, data::FilterConfig::INBOUND, "USER_DATA");
+    add_action(data::FilterConfig::ADD, data::FilterConfig::INBOUND, "PAYMENTS");
+    add_action(data::FilterConfig::REMOVE, data::FilterConfig::INBOUND, "ANONYMOUS");
+    add_action(data::FilterConfig::ADD, data::FilterConfig::OUTBOUND, "AUDITED");
+    return std::make_shared<DataTracingFilterConfig>(proto_config);
+}
+
+// The cost of evaluating the policy on the x-data header of one request
+static void BM_PolicyEvaluation(benchmark::State& state) {
+    DataTracingFilterConfigSharedPtr config = policyConfig();
+    const std::string data_contents = "ANONYMOUS;EU_RESIDENT;TRACKING;USER_DATA";
+    for (auto _ : state) {
+        DataPolicyResults results = DataPolicy::apply(config, data_contents,
+                                                      data::FilterConfig::INBOUND, "");
+        benchmark::DoNotOptimize(results);
+    }
+}
+BENCHMARK(BM_PolicyEvaluation);
+
+// A label table covering the labels of the benchmarks
+google::protobuf::RepeatedPtrField<std::string> labelTable() {
+    google::protobuf::RepeatedPtrField<std::string> table;
+    for (const char* label : {"ANONYMOUS", "AUDITED", "EU_RESIDENT", "PAYMENTS", "SECRET",
+                              "TRACKING", "USER_DATA"}) {
+        table.Add(label);
+    }
+    return table;
+}
+
+// Reading and writing the text form of the x-data header
+static void BM_LabelTextRoundTrip(benchmark::State& state) {
+    const std::string data_contents = "ANONYMOUS;EU_RESIDENT;TRACKING;USER_DATA";
+    for (auto _ : state) {
+        LabelSet labels(data_contents);
+        std::string data = labels.toString();
+        benchmark::DoNotOptimize(data);
+    }
+}
+BENCHMARK(BM_LabelTextRoundTrip);
+
+// Reading and writing the compact form of the same labels
+static void BM_LabelCompactRoundTrip(benchmark::State& state) {
+    LabelCodec codec(labelTable());
+    std::string encoded;
+    codec.encode(LabelSet("ANONYMOUS;EU_RESIDENT;TRACKING;USER_DATA"), &encoded);
+    for (auto _ : state) {
+        LabelSet labels;
+        codec.decode(encoded, &labels);
+        std::string data;
+        codec.encode(labels, &data);
+        benchmark::DoNotOptimize(data);
+    }
+}
+BENCHMARK(BM_LabelCompactRoundTrip);
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs
+// them.
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+}
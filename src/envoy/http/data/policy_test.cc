@@ -0,0 +1,149 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/policy.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+namespace {
+
+TEST(DataTracingFilterConfigTest, ParsesSeveralOverrides) {
+    DataTracingFilterConfig overrides(absl::string_view("ADD(OVERRIDE_A);REMOVE(OVERRIDE_B)"));
+    EXPECT_EQ(2, overrides.size(data::FilterConfig::INBOUND));
+    EXPECT_EQ(2, overrides.size(data::FilterConfig::OUTBOUND));
+
+    LabelSet labels("OVERRIDE_B;OVERRIDE_C");
+    EXPECT_TRUE(overrides.apply(labels, data::FilterConfig::INBOUND));
+    EXPECT_EQ("OVERRIDE_A;OVERRIDE_C", labels.toString());
+}
+
+TEST(DataTracingFilterConfigTest, OverridesDoNotInternLabels) {
+    DataTracingFilterConfig overrides(
+            absl::string_view("ADD(OVERRIDE_ONLY);REMOVE(OVERRIDE_GONE)"));
+    LabelId id;
+    EXPECT_FALSE(LabelInterner::get().lookup("OVERRIDE_ONLY", &id));
+    EXPECT_FALSE(LabelInterner::get().lookup("OVERRIDE_GONE", &id));
+
+    LabelSet labels("OVERRIDE_GONE");
+    EXPECT_TRUE(overrides.apply(labels, data::FilterConfig::INBOUND));
+    EXPECT_EQ("OVERRIDE_ONLY", labels.toString());
+
+    // Labels a config interned are used by ID
+    data::FilterConfig proto_config;
+    auto* action = proto_config.add_actions();
+    action->set_operation(data::FilterConfig::ADD);
+    action->set_member("OVERRIDE_CONFIGURED");
+    DataTracingFilterConfig config(proto_config);
+    DataTracingFilterConfig configured(absl::string_view("REMOVE(OVERRIDE_CONFIGURED)"));
+    EXPECT_TRUE(config.apply(labels, data::FilterConfig::INBOUND));
+    EXPECT_EQ("OVERRIDE_CONFIGURED;OVERRIDE_ONLY", labels.toString());
+    EXPECT_TRUE(configured.apply(labels, data::FilterConfig::INBOUND));
+    EXPECT_EQ("OVERRIDE_ONLY", labels.toString());
+}
+
+TEST(DataTracingFilterConfigTest, SkipsMalformedOverrides) {
+    for (const char* malformed :
+         {"", ";", ";;", "ADD", "ADD(", "ADD(OVERRIDE_A", "ADDOVERRIDE_A)", "ADD()",
+          "UNKNOWN(OVERRIDE_A)", "SKIP(OVERRIDE_A)", "(OVERRIDE_A)"}) {
+        DataTracingFilterConfig overrides{absl::string_view(malformed)};
+        EXPECT_EQ(0, overrides.size(data::FilterConfig::INBOUND)) << malformed;
+        EXPECT_EQ(0, overrides.size(data::FilterConfig::OUTBOUND)) << malformed;
+    }
+
+    // Well formed operations around malformed ones still apply
+    DataTracingFilterConfig overrides(absl::string_view(
+            ";ADD(OVERRIDE_A;UNKNOWN(X);;CHECK_EXCLUDE(OVERRIDE_D);ADD(OVERRIDE_B)"));
+    EXPECT_EQ(2, overrides.size(data::FilterConfig::INBOUND));
+    LabelSet labels;
+    EXPECT_TRUE(overrides.apply(labels, data::FilterConfig::OUTBOUND));
+    EXPECT_EQ("OVERRIDE_B", labels.toString());
+}
+
+TEST(DataPolicyTest, AppliesConfigThenOverrides) {
+    data::FilterConfig proto_config;
+    auto* action = proto_config.add_actions();
+    action->set_operation(data::FilterConfig::CHECK_INCLUDE);
+    action->set_when(data::FilterConfig::INBOUND);
+    action->set_member("POLICY_USER");
+    action = proto_config.add_actions();
+    action->set_operation(data::FilterConfig::ADD);
+    action->set_when(data::FilterConfig::OUTBOUND);
+    action->set_member("POLICY_AUDITED");
+    auto config = std::make_shared<DataTracingFilterConfig>(proto_config);
+
+    DataPolicyResults results = DataPolicy::apply(config, "POLICY_USER;POLICY_OTHER",
+                                                  data::FilterConfig::INBOUND, "");
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, results.status);
+    EXPECT_EQ("POLICY_OTHER;POLICY_USER", results.data);
+
+    results = DataPolicy::apply(config, "POLICY_OTHER", data::FilterConfig::INBOUND, "");
+    EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, results.status);
+
+    results = DataPolicy::apply(config, "POLICY_OTHER", data::FilterConfig::OUTBOUND,
+                                "REMOVE(POLICY_OTHER)");
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, results.status);
+    EXPECT_EQ("POLICY_AUDITED", results.data);
+
+    results = DataPolicy::apply(config, "", data::FilterConfig::OUTBOUND,
+                                "REMOVE(POLICY_AUDITED)");
+    EXPECT_EQ(DEFAULT_NO_DATA, results.data);
+
+    results = DataPolicy::apply(config, "POLICY_SECRET", data::FilterConfig::OUTBOUND,
+                                "CHECK_EXCLUDE(POLICY_SECRET)");
+    EXPECT_EQ(Http::FilterHeadersStatus::StopIteration, results.status);
+}
+
+TEST(DataPolicyOverrideCacheTest, HitsReturnTheCachedProgram) {
+    DataPolicyOverrideCache cache(2);
+    DataTracingFilterConfigConstSharedPtr program = cache.lookup("ADD(CACHED)");
+    EXPECT_EQ(1, program->size(data::FilterConfig::INBOUND));
+    EXPECT_EQ(program, cache.lookup("ADD(CACHED)"));
+    EXPECT_NE(program, cache.lookup("ADD(OTHER)"));
+    EXPECT_EQ(2, cache.size());
+}
+
+TEST(DataPolicyOverrideCacheTest, EvictsLeastRecentlyUsed) {
+    DataPolicyOverrideCache cache(2);
+    DataTracingFilterConfigConstSharedPtr a = cache.lookup("ADD(A)");
+    DataTracingFilterConfigConstSharedPtr b = cache.lookup("ADD(B)");
+    EXPECT_EQ(a, cache.lookup("ADD(A)"));
+
+    // B is the least recently used value now
+    cache.lookup("ADD(C)");
+    EXPECT_EQ(2, cache.size());
+    EXPECT_EQ(a, cache.lookup("ADD(A)"));
+    EXPECT_NE(b, cache.lookup("ADD(B)"));
+
+    // Which evicted C, not A
+    EXPECT_EQ(a, cache.lookup("ADD(A)"));
+}
+
+TEST(DataPolicyOverrideCacheTest, LongValuesAreNotCached) {
+    DataPolicyOverrideCache cache(2);
+    std::string overrides;
+    while (overrides.size() <= 1024) {
+        overrides += "ADD(LONG_LABEL);";
+    }
+    EXPECT_NE(cache.lookup(overrides), cache.lookup(overrides));
+    EXPECT_EQ(0, cache.size());
+}
+
+}  // namespace
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,146 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/data/trace_state.h"
+
+#include <algorithm>
+
+#include "absl/strings/numbers.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+namespace {
+
+// How often idle traces are looked for, also the granularity of the ttl.
+constexpr std::chrono::milliseconds kSweepInterval(1000);
+
+// Shards of the maps shared by all workers
+constexpr size_t kSharedShards = 64;
+
+// Shards of the maps of one worker, other workers rarely access them
+constexpr size_t kWorkerShards = 4;
+
+}  // namespace
+
+TraceState::WorkerTraces::WorkerTraces(TimeSource& time_source, size_t max_traces,
+                                       ThreadSafeStringMap* owners, size_t index)
+    : maps(time_source, max_traces, kWorkerShards, owners), index(std::to_string(index)) {}
+
+TraceState::TraceState(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls,
+                       Stats::Scope& scope, std::chrono::milliseconds ttl, size_t max_traces,
+                       bool worker_local)
+    : shared_(worker_local ? nullptr
+                           : std::make_unique<TraceMaps>(dispatcher.timeSource(), max_traces,
+                                                          kSharedShards)),
+      scope_(scope.createScope("data_tracing.")),
+      stats_{ALL_DATA_TRACING_STATS(POOL_COUNTER(*scope_), POOL_GAUGE(*scope_))},
+      ttl_(ttl) {
+    if (worker_local) {
+        TimeSource& time_source = dispatcher.timeSource();
+        owners_ = std::make_unique<ThreadSafeStringMap>(time_source, 0, kSharedShards);
+        worker_lists_.push_back(std::make_unique<const WorkerList>());
+        workers_.store(worker_lists_.back().get());
+        slot_ = tls.allocateSlot();
+        slot_->set([this, &time_source, max_traces](Event::Dispatcher&)
+                           -> ThreadLocal::ThreadLocalObjectSharedPtr {
+            std::lock_guard<std::mutex> lock(register_mutex_);
+            auto workers = std::make_unique<WorkerList>(*workers_.load());
+            auto worker = std::make_shared<WorkerTraces>(time_source, max_traces,
+                                                         owners_.get(), workers->size());
+            workers->push_back(worker.get());
+            workers_.store(workers.get());
+            worker_lists_.push_back(std::move(workers));
+            worker_traces_.push_back(worker);
+            return worker;
+        });
+    }
+    timer_ = dispatcher.createTimer([this]() { onTimer(); });
+    timer_->enableTimer(std::min(kSweepInterval, ttl_));
+}
+
+TraceMaps& TraceState::lookup(absl::string_view trace_id) {
+    return find(trace_id, false);
+}
+
+TraceMaps& TraceState::claim(absl::string_view trace_id) {
+    return find(trace_id, true);
+}
+
+TraceMaps& TraceState::find(absl::string_view trace_id, bool claim) {
+    if (shared_ != nullptr) {
+        return *shared_;
+    }
+    WorkerTraces& local = slot_->getTyped<WorkerTraces>();
+    if (local.maps.data.find(trace_id, nullptr)) {
+        stats_.lookups_local_.inc();
+        return local.maps;
+    }
+    // The trace started on another worker, or is new. Only the worker
+    // that records itself as the owner of a new trace starts it.
+    std::string owner;
+    if (!owners_->find(trace_id, &owner)) {
+        if (!claim || owners_->create(trace_id, local.index)) {
+            stats_.lookups_missed_.inc();
+            return local.maps;
+        }
+        owners_->find(trace_id, &owner);
+    }
+    size_t index;
+    const WorkerList& workers = *workers_.load();
+    if (owner == local.index || !absl::SimpleAtoi(owner, &index) || index >= workers.size()) {
+        stats_.lookups_missed_.inc();
+        return local.maps;
+    }
+    stats_.lookups_remote_.inc();
+    return workers[index]->maps;
+}
+
+void TraceState::release(absl::string_view trace_id) {
+    if (owners_ != nullptr) {
+        owners_->del(trace_id);
+    }
+}
+
+void TraceState::onTimer() {
+    std::vector<TraceMaps*> all_maps;
+    if (shared_ != nullptr) {
+        all_maps.push_back(shared_.get());
+    } else {
+        for (WorkerTraces* worker : *workers_.load()) {
+            all_maps.push_back(&worker->maps);
+        }
+    }
+
+    uint64_t evictions = 0;
+    size_t active = 0;
+    for (TraceMaps* maps : all_maps) {
+        // Dropping a trace from one map drops it from the other, so a trace
+        // is counted by the map that dropped it first.
+        stats_.traces_expired_.add(maps->data.expire(ttl_) + maps->parents.expire(ttl_));
+        evictions += maps->data.evictions() + maps->parents.evictions();
+        active += maps->data.size();
+    }
+    stats_.traces_evicted_.add(evictions - evictions_);
+    evictions_ = evictions;
+
+    stats_.traces_active_.set(active);
+    timer_->enableTimer(std::min(kSweepInterval, ttl_));
+}
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,167 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread_local/thread_local.h"
+#include "src/envoy/http/data/map.h"
+
+namespace Envoy {
+namespace Http {
+namespace Data {
+
+/**
+ * All data tracing stats. @see stats_macros.h
+ */
+#define ALL_DATA_TRACING_STATS(COUNTER, GAUGE) \
+    COUNTER(traces_expired)                    \
+    COUNTER(traces_evicted)                    \
+    COUNTER(lookups_local)                     \
+    COUNTER(lookups_remote)                    \
+    COUNTER(lookups_missed)                    \
+    GAUGE(traces_active, NeverImport)
+
+/**
+ * Struct definition for all data tracing stats. @see stats_macros.h
+ */
+struct DataTracingStats {
+    ALL_DATA_TRACING_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+/**
+ * The maps of one set of traces, both are keyed by the x-request-id.
+ *
+ * Whichever map expires or evicts a trace drops it from the other one as
+ * well, and from the owner directory if the maps belong to a worker.
+ */
+struct TraceMaps {
+    TraceMaps(TimeSource& time_source, size_t max_traces, size_t num_shards,
+              ThreadSafeStringMap* owners = nullptr)
+        : parents(time_source, max_traces, num_shards),
+          data(time_source, max_traces, num_shards) {
+        parents.setDropCallback([this, owners](absl::string_view trace_id) {
+            data.del(trace_id);
+            if (owners != nullptr) {
+                owners->del(trace_id);
+            }
+        });
+        data.setDropCallback([this, owners](absl::string_view trace_id) {
+            parents.del(trace_id);
+            if (owners != nullptr) {
+                owners->del(trace_id);
+            }
+        });
+    }
+
+    TraceMaps(const TraceMaps&) = delete;
+    TraceMaps& operator=(const TraceMaps&) = delete;
+
+    // Trace ID to the connection ID of the parent request
+    ThreadSafeStringMap parents;
+    // Trace ID to the data labels of the trace
+    ThreadSafeStringMap data;
+};
+
+/**
+ * Process wide trace state.
+ *
+ * By default all workers share one set of maps. With worker_local every
+ * worker starts its traces in its own maps and records itself as their
+ * owner, so the other workers find a trace without a lock and only touch
+ * those maps when a request of the trace lands on them.
+ *
+ * Traces normally end when the parent response is encoded. Traces whose
+ * parent never responds are dropped after ttl without being accessed, and
+ * beyond max_traces (per worker with worker_local) the least recently used
+ * traces are evicted.
+ *
+ * The state is created and destroyed on the main thread, which runs its
+ * timer and owns its slot. Only the filter factory callbacks own it, the
+ * filters on the workers borrow it through lookup(), claim() and release().
+ */
+class TraceState : public Singleton::Instance {
+public:
+    TraceState(Event::Dispatcher& dispatcher, ThreadLocal::SlotAllocator& tls,
+               Stats::Scope& scope, std::chrono::milliseconds ttl, size_t max_traces,
+               bool worker_local);
+
+    // Returns the maps holding trace_id, or the maps of the calling worker
+    // if no maps hold it. Call from workers only.
+    TraceMaps& lookup(absl::string_view trace_id);
+
+    // Same as lookup(), but a trace no maps hold yet is started in the maps
+    // of the calling worker. Concurrent calls for a new trace agree on one
+    // worker.
+    TraceMaps& claim(absl::string_view trace_id);
+
+    // Forgets the owner of a finished trace, after its entries are deleted
+    void release(absl::string_view trace_id);
+
+private:
+    struct WorkerTraces : public ThreadLocal::ThreadLocalObject {
+        WorkerTraces(TimeSource& time_source, size_t max_traces, ThreadSafeStringMap* owners,
+                     size_t index);
+
+        TraceMaps maps;
+        // Position in workers_, as recorded in owners_
+        const std::string index;
+    };
+    using WorkerList = std::vector<WorkerTraces*>;
+
+    TraceMaps& find(absl::string_view trace_id, bool claim);
+
+    // Expires idle traces and updates the stats, runs on the main thread.
+    void onTimer();
+
+    // The shared maps, or nullptr with worker_local
+    const std::unique_ptr<TraceMaps> shared_;
+    ThreadLocal::SlotPtr slot_;
+
+    // With worker_local, the index of the worker owning each live trace. Its
+    // entries leave with the trace, so it is neither expired nor bounded.
+    std::unique_ptr<ThreadSafeStringMap> owners_;
+    // The workers by index. A registering worker publishes a new list, the
+    // old ones are kept since lookups may still read them.
+    std::atomic<const WorkerList*> workers_{nullptr};
+    std::mutex register_mutex_;
+    std::vector<std::unique_ptr<const WorkerList>> worker_lists_;
+    std::vector<std::shared_ptr<WorkerTraces>> worker_traces_;
+
+    // The scope of the listener which created the state may be removed
+    // first, so the stats live in a scope of their own.
+    Stats::ScopePtr scope_;
+    DataTracingStats stats_;
+    const std::chrono::milliseconds ttl_;
+    uint64_t evictions_{0};
+    Event::TimerPtr timer_;
+};
+
+using TraceStateSharedPtr = std::shared_ptr<TraceState>;
+
+}  // namespace Data
+}  // namespace Http
+}  // namespace Envoy
@@ -20,25 +20,42 @@
 #include "envoy/config/filter/http/jwt_auth/v2alpha1/config.pb.h"
 #include "envoy/server/filter_config.h"
 #include "envoy/thread_local/thread_local.h"
+#include "src/envoy/http/jwt_auth/jwks_refresher.h"
 #include "src/envoy/http/jwt_auth/pubkey_cache.h"
+#include "src/envoy/http/jwt_auth/token_cache.h"
 #include "src/envoy/http/jwt_auth/token_extractor.h"
+#include "src/envoy/http/jwt_auth/verify_pool.h"
 
 namespace Envoy {
 namespace Http {
 namespace JwtAuth {
+namespace {
+
+// The number of verified tokens cached per thread.
+const int64_t kTokenCacheSize = 1000;
+
+}  // namespace
 
 typedef std::shared_ptr<const ::istio::envoy::config::filter::http::jwt_auth::
                             v2alpha1::JwtAuthentication>
     JwtAuthenticationConstSharedPtr;
 
 // The JWT auth store object to store config and caches.
-// It only has pubkey_cache for now. In the future it will have token cache.
 // It is per-thread and stored in thread local.
 class JwtAuthStore : public ThreadLocal::ThreadLocalObject {
  public:
-  // Load the config from envoy config.
-  JwtAuthStore(JwtAuthenticationConstSharedPtr config)
-      : config_(config), pubkey_cache_(*config_), token_extractor_(*config_) {}
+  // Load the config from envoy config. Signatures are verified inline unless
+  // a pool and the dispatcher of this thread are given. The pool must outlive
+  // the store.
+  JwtAuthStore(JwtAuthenticationConstSharedPtr config,
+               VerifyPool* verify_pool = nullptr,
+               Event::Dispatcher* dispatcher = nullptr)
+      : config_(config),
+        pubkey_cache_(*config_),
+        token_extractor_(*config_),
+        token_cache_(kTokenCacheSize),
+        verify_pool_(dispatcher != nullptr ? verify_pool : nullptr),
+        dispatcher_(dispatcher) {}
 
   // Get the Config.
   const ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::
@@ -53,6 +70,15 @@ class JwtAuthStore : public ThreadLocal::ThreadLocalObject {
   // Get the private token extractor.
   const JwtTokenExtractor& token_extractor() const { return token_extractor_; }
 
+  // Get the cache of verified tokens.
+  TokenCache& token_cache() { return token_cache_; }
+
+  // Get the pool verifying signatures, null if they are verified inline.
+  VerifyPool* verify_pool() const { return verify_pool_; }
+
+  // Get the dispatcher of this thread, set if verify_pool() is.
+  Event::Dispatcher& dispatcher() const { return *dispatcher_; }
+
  private:
   // Store the config.
   JwtAuthenticationConstSharedPtr config_;
@@ -60,23 +86,57 @@ class JwtAuthStore : public ThreadLocal::ThreadLocalObject {
   PubkeyCache pubkey_cache_;
   // The object to extract token.
   JwtTokenExtractor token_extractor_;
+  // The verified tokens, indexed by digest.
+  TokenCache token_cache_;
+  // The pool shared by all threads, owned by the factory.
+  VerifyPool* verify_pool_;
+  Event::Dispatcher* dispatcher_;
 };
 
 // The factory to create per-thread auth store object.
 class JwtAuthStoreFactory : public Logger::Loggable<Logger::Id::config> {
  public:
+  // Signatures are verified on verify_pool if given. The per-thread stores
+  // only point to it, so the last reference is dropped by a factory on the
+  // main thread.
   JwtAuthStoreFactory(const ::istio::envoy::config::filter::http::jwt_auth::
                           v2alpha1::JwtAuthentication& config,
-                      Server::Configuration::FactoryContext& context)
+                      Server::Configuration::FactoryContext& context,
+                      VerifyPoolSharedPtr verify_pool = nullptr)
       : config_(std::make_shared<const ::istio::envoy::config::filter::http::
                                      jwt_auth::v2alpha1::JwtAuthentication>(
             config)),
         dummy_store_(config_),
-        tls_(context.threadLocal().allocateSlot()) {
-    tls_->set([config = this->config_](Event::Dispatcher&)
+        tls_(context.threadLocal().allocateSlot()),
+        verify_pool_(verify_pool) {
+    tls_->set([config = this->config_, verify_pool = this->verify_pool_.get()](
+                  Event::Dispatcher& dispatcher)
                   -> ThreadLocal::ThreadLocalObjectSharedPtr {
-      return std::make_shared<JwtAuthStore>(config);
+      return std::make_shared<JwtAuthStore>(config, verify_pool, &dispatcher);
     });
+    // Remote JWKS are fetched once for all threads.
+    jwks_refresher_.reset(new JwksRefresher(
+        *config_, context.clusterManager(), context.dispatcher(),
+        [tls = std::weak_ptr<ThreadLocal::Slot>(tls_)](
+            const std::string& issuer, std::shared_ptr<const Pubkeys> pubkey) {
+          auto slot = tls.lock();
+          if (!slot) {
+            return;
+          }
+          // The per-thread store is handed to the update, so the workers
+          // don't reach back into the factory or its slot.
+          slot->runOnAllThreads(
+              [issuer, pubkey](ThreadLocal::ThreadLocalObjectSharedPtr object)
+                  -> ThreadLocal::ThreadLocalObjectSharedPtr {
+                auto item = static_cast<JwtAuthStore&>(*object)
+                                .pubkey_cache()
+                                .LookupByIssuer(issuer);
+                if (item) {
+                  item->SetRemotePubkeys(pubkey);
+                }
+                return object;
+              });
+        }));
     ENVOY_LOG(debug, "Loaded JwtAuthConfig: {}",
               MessageUtil::getJsonStringFromMessage(*config_, true));
   }
@@ -89,8 +149,14 @@ class JwtAuthStoreFactory : public Logger::Loggable<Logger::Id::config> {
   JwtAuthenticationConstSharedPtr config_;
   // A dummy Auth store to verify config is valid
   JwtAuthStore dummy_store_;
-  // Thread local slot to store per-thread auth store
-  ThreadLocal::SlotPtr tls_;
+  // Thread local slot to store per-thread auth store, only the factory owns
+  // it so it is released on the main thread.
+  std::shared_ptr<ThreadLocal::Slot> tls_;
+  // Refreshes the remote JWKS of the per-thread auth stores
+  std::unique_ptr<JwksRefresher> jwks_refresher_;
+  // Verifies signatures for all threads, shared by the factories of the
+  // process
+  VerifyPoolSharedPtr verify_pool_;
 };
 
 }  // namespace JwtAuth
@@ -46,7 +46,8 @@ FilterHeadersStatus JwtVerificationFilter::decodeHeaders(HeaderMap& headers,
   stopped_ = false;
 
   // Verify the JWT token, onDone() will be called when completed.
-  jwt_auth_.Verify(headers, this);
+  jwt_auth_.Verify(headers, this,
+                   &decoder_callbacks_->streamInfo().filterState());
 
   if (state_ == Complete) {
     return FilterHeadersStatus::Continue;
@@ -86,6 +87,20 @@ void JwtVerificationFilter::savePayload(const std::string& key,
       Utils::IstioFilterName::kJwt, MessageUtil::keyValueStruct(key, payload));
 }
 
+void JwtVerificationFilter::saveClaims(
+    const std::string& key, JwtAuth::JwtClaimsConstSharedPtr claims) {
+  StreamInfo::FilterState& filter_state =
+      decoder_callbacks_->streamInfo().filterState();
+  const std::string& state_key = JwtAuth::VerifiedJwtClaims::key();
+  if (!filter_state.hasData<JwtAuth::VerifiedJwtClaims>(state_key)) {
+    filter_state.setData(state_key,
+                         std::make_unique<JwtAuth::VerifiedJwtClaims>(),
+                         StreamInfo::FilterState::StateType::Mutable);
+  }
+  filter_state.getDataMutable<JwtAuth::VerifiedJwtClaims>(state_key)
+      .by_issuer[key] = std::move(claims);
+}
+
 FilterDataStatus JwtVerificationFilter::decodeData(Buffer::Instance&, bool) {
   if (state_ == Calling) {
     return FilterDataStatus::StopIterationAndWatermark;
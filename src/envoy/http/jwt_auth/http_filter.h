@@ -50,6 +50,11 @@ class JwtVerificationFilter : public StreamDecoderFilter,
   // To be called when Jwt validation success to save payload for future use.
   void savePayload(const std::string& key, const std::string& payload) override;
 
+  // the function for JwtAuth::Authenticator::Callbacks interface.
+  // To be called after savePayload() to share the parsed payload.
+  void saveClaims(const std::string& key,
+                  JwtAuth::JwtClaimsConstSharedPtr claims) override;
+
   // The callback funcion.
   StreamDecoderFilterCallbacks* decoder_callbacks_;
   // The auth object.
@@ -15,6 +15,7 @@
 
 #include "common/protobuf/message_validator_impl.h"
 #include "envoy/registry/registry.h"
+#include "envoy/singleton/manager.h"
 #include "google/protobuf/util/json_util.h"
 #include "src/envoy/http/jwt_auth/auth_store.h"
 #include "src/envoy/http/jwt_auth/http_filter.h"
@@ -26,6 +27,18 @@ using ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::
 namespace Envoy {
 namespace Server {
 namespace Configuration {
+namespace {
+
+// Runtime keys of the threads verifying signatures off the worker threads,
+// none by default, and of how many verifications may wait for them.
+const char kVerifyThreadsKey[] = "jwt_auth.verify_threads";
+const char kVerifyQueueLimitKey[] = "jwt_auth.verify_queue_limit";
+const uint64_t kDefaultVerifyQueueLimit = 64;
+
+}  // namespace
+
+// Verify pool shared by all JWT filters of the process
+SINGLETON_MANAGER_REGISTRATION(jwt_auth_verify_pool);
 
 class JwtVerificationFilterConfig : public NamedHttpFilterConfigFactory {
  public:
@@ -54,8 +67,23 @@ class JwtVerificationFilterConfig : public NamedHttpFilterConfigFactory {
  private:
   Http::FilterFactoryCb createFilter(const JwtAuthentication& proto_config,
                                      FactoryContext& context) {
+    // The runtime of whichever filter creates the pool sizes it.
+    Http::JwtAuth::VerifyPoolSharedPtr verify_pool;
+    const auto& snapshot = context.runtime().snapshot();
+    uint64_t verify_threads = snapshot.getInteger(kVerifyThreadsKey, 0);
+    if (verify_threads > 0) {
+      verify_pool =
+          context.singletonManager().getTyped<Http::JwtAuth::VerifyPool>(
+              SINGLETON_MANAGER_REGISTERED_NAME(jwt_auth_verify_pool),
+              [&context, &snapshot, verify_threads] {
+                return std::make_shared<Http::JwtAuth::VerifyPool>(
+                    context.api().threadFactory(), verify_threads,
+                    snapshot.getInteger(kVerifyQueueLimitKey,
+                                        kDefaultVerifyQueueLimit));
+              });
+    }
     auto store_factory = std::make_shared<Http::JwtAuth::JwtAuthStoreFactory>(
-        proto_config, context);
+        proto_config, context, verify_pool);
     Upstream::ClusterManager& cm = context.clusterManager();
     return [&cm, store_factory](
                Http::FilterChainFactoryCallbacks& callbacks) -> void {
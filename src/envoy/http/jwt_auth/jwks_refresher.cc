@@ -0,0 +1,133 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/jwt_auth/jwks_refresher.h"
+
+#include <algorithm>
+
+#include "common/http/message_impl.h"
+#include "common/http/utility.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+namespace {
+
+// How soon a failed fetch is retried.
+const std::chrono::milliseconds kRetryInterval(5000);
+
+}  // namespace
+
+JwksRefresher::JwksRefresher(const ::istio::envoy::config::filter::http::
+                                 jwt_auth::v2alpha1::JwtAuthentication& config,
+                             Upstream::ClusterManager& cm,
+                             Event::Dispatcher& dispatcher, PublishCb publish)
+    : cm_(cm), publish_(publish) {
+  for (const auto& rule : config.rules()) {
+    if (!rule.has_remote_jwks()) {
+      continue;
+    }
+    issuers_.emplace_back(new Issuer(*this, rule, dispatcher));
+    issuers_.back()->Fetch();
+  }
+}
+
+JwksRefresher::Issuer::Issuer(
+    JwksRefresher& parent,
+    const ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::JwtRule&
+        jwt_config,
+    Event::Dispatcher& dispatcher)
+    : parent_(parent),
+      jwt_config_(jwt_config),
+      timer_(dispatcher.createTimer([this]() { Fetch(); })) {}
+
+JwksRefresher::Issuer::~Issuer() {
+  if (request_) {
+    request_->cancel();
+  }
+}
+
+void JwksRefresher::Issuer::Fetch() {
+  const auto& http_uri = jwt_config_.remote_jwks().http_uri();
+  if (parent_.cm_.get(http_uri.cluster()) == nullptr) {
+    // The cluster may not be there yet while the server starts.
+    ScheduleFetch(false);
+    return;
+  }
+  std::string host, path;
+  ExtractUriHostPath(http_uri.uri(), &host, &path);
+
+  MessagePtr message(new RequestMessageImpl());
+  message->headers().insertMethod().value().setReference(
+      Http::Headers::get().MethodValues.Get);
+  message->headers().insertPath().value(path);
+  message->headers().insertHost().value(host);
+
+  ENVOY_LOG(debug, "refresh pubkey from [uri = {}]: start", http_uri.uri());
+  request_ = parent_.cm_.httpAsyncClientForCluster(http_uri.cluster())
+                 .send(std::move(message), *this,
+                       Http::AsyncClient::RequestOptions());
+}
+
+void JwksRefresher::Issuer::onSuccess(MessagePtr&& response) {
+  request_ = nullptr;
+  const std::string& uri = jwt_config_.remote_jwks().http_uri().uri();
+  uint64_t status_code = Http::Utility::getResponseStatus(response->headers());
+  if (status_code != 200 || !response->body()) {
+    ENVOY_LOG(debug, "refresh pubkey [uri = {}]: response status code {}", uri,
+              status_code);
+    ScheduleFetch(false);
+    return;
+  }
+  auto len = response->body()->length();
+  std::string jwks(static_cast<char*>(response->body()->linearize(len)), len);
+  if (pubkey_ == nullptr || jwks != jwks_) {
+    std::shared_ptr<const Pubkeys> pubkey =
+        Pubkeys::CreateFrom(jwks, Pubkeys::JWKS);
+    if (pubkey->GetStatus() != Status::OK) {
+      ENVOY_LOG(debug, "refresh pubkey [uri = {}]: invalid jwks: {}", uri,
+                StatusToString(pubkey->GetStatus()));
+      ScheduleFetch(false);
+      return;
+    }
+    jwks_ = std::move(jwks);
+    pubkey_ = std::move(pubkey);
+  }
+  ENVOY_LOG(debug, "refresh pubkey [uri = {}]: success", uri);
+  // Unchanged keys are published again to renew their expiration.
+  parent_.publish_(jwt_config_.issuer(), pubkey_);
+  ScheduleFetch(true);
+}
+
+void JwksRefresher::Issuer::onFailure(AsyncClient::FailureReason) {
+  request_ = nullptr;
+  ENVOY_LOG(debug, "refresh pubkey [uri = {}]: failed",
+            jwt_config_.remote_jwks().http_uri().uri());
+  ScheduleFetch(false);
+}
+
+void JwksRefresher::Issuer::ScheduleFetch(bool succeeded) {
+  // Renew the keys when three quarters of their cache duration passed, so a
+  // failed refresh can still be retried before they expire.
+  auto refresh_interval =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          RemoteJwksCacheDuration(jwt_config_) * 3 / 4);
+  timer_->enableTimer(succeeded ? refresh_interval
+                                : std::min(kRetryInterval, refresh_interval));
+}
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
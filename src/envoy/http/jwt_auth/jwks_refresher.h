@@ -0,0 +1,89 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/common/logger.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/timer.h"
+#include "envoy/http/async_client.h"
+#include "envoy/upstream/cluster_manager.h"
+#include "src/envoy/http/jwt_auth/pubkey_cache.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+
+// Fetches the remote JWKS of every issuer once per process on the main thread
+// and renews them before the per-thread copies expire, so requests keep
+// using the previous keys while a refresh is running. Requests only fetch
+// JWKS themselves while no refresh succeeded yet or refreshes keep failing.
+class JwksRefresher : public Logger::Loggable<Logger::Id::filter> {
+ public:
+  // Called on the main thread with the keys of an issuer after each refresh.
+  // The same object is passed again while the fetched JWKS does not change.
+  using PublishCb = std::function<void(const std::string& issuer,
+                                       std::shared_ptr<const Pubkeys> pubkey)>;
+
+  JwksRefresher(const ::istio::envoy::config::filter::http::jwt_auth::
+                    v2alpha1::JwtAuthentication& config,
+                Upstream::ClusterManager& cm, Event::Dispatcher& dispatcher,
+                PublishCb publish);
+
+ private:
+  // The refresh of the JWKS of one issuer.
+  class Issuer : public AsyncClient::Callbacks {
+   public:
+    Issuer(JwksRefresher& parent,
+           const ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::
+               JwtRule& jwt_config,
+           Event::Dispatcher& dispatcher);
+    ~Issuer();
+
+    // Start fetching the JWKS.
+    void Fetch();
+
+    // AsyncClient::Callbacks
+    void onSuccess(MessagePtr&& response) override;
+    void onFailure(AsyncClient::FailureReason) override;
+
+   private:
+    // Schedule the next fetch, sooner if this one failed.
+    void ScheduleFetch(bool succeeded);
+
+    JwksRefresher& parent_;
+    const ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::JwtRule&
+        jwt_config_;
+    Event::TimerPtr timer_;
+    // The pending remote request so it can be canceled.
+    AsyncClient::Request* request_{};
+    // The last valid JWKS and the keys parsed from it.
+    std::string jwks_;
+    std::shared_ptr<const Pubkeys> pubkey_;
+  };
+
+  Upstream::ClusterManager& cm_;
+  PublishCb publish_;
+  std::vector<std::unique_ptr<Issuer>> issuers_;
+};
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,182 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/jwt_auth/jwks_refresher.h"
+
+#include "common/http/message_impl.h"
+#include "gtest/gtest.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/upstream/mocks.h"
+#include "test/test_common/utility.h"
+
+using ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::
+    JwtAuthentication;
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+namespace {
+
+// A JWKS with one RSA key
+const std::string kPublicKey =
+    "{\"keys\": [{"
+    "  \"kty\": \"RSA\","
+    "  \"n\": "
+    "\"up97uqrF9MWOPaPkwSaBeuAPLOr9FKcaWGdVEGzQ4f3Zq5WKVZowx9TCBxmImNJ1q"
+    "mUi13pB8otwM_l5lfY1AFBMxVbQCUXntLovhDaiSvYp4wGDjFzQiYA-pUq8h6MUZBnhleYrk"
+    "U7XlCBwNVyN8qNMkpLA7KFZYz-486GnV2NIJJx_4BGa3HdKwQGxi2tjuQsQvao5W4xmSVaaE"
+    "WopBwMy2QmlhSFQuPUpTaywTqUcUq_6SfAHhZ4IDa_FxEd2c2z8gFGtfst9cY3lRYf-c_Zdb"
+    "oY3mqN9Su3-j3z5r2SHWlhB_LNAjyWlBGsvbGPlTqDziYQwZN4aGsqVKQb9Vw\","
+    "  \"e\": \"AQAB\","
+    "  \"alg\": \"RS256\","
+    "  \"kid\": \"62a93512c9ee4c7f8067b5a216dade2763d32a47\""
+    "}]}";
+
+const char kJwtIssuer[] = "https://example.com";
+
+const char kExampleConfig[] = R"(
+{
+   "rules": [
+      {
+         "issuer": "https://example.com",
+         "remote_jwks": {
+            "http_uri": {
+              "uri": "https://pubkey_server/pubkey_path",
+              "cluster": "pubkey_cluster"
+            },
+            "cache_duration": {
+              "seconds": 600
+            }
+         }
+      },
+      {
+         "issuer": "inline_issuer",
+         "local_jwks": {
+            "inline_string": "{\"keys\": []}"
+         }
+      }
+   ]
+}
+)";
+
+class JwksRefresherTest : public ::testing::Test {
+ public:
+  void SetUp() {
+    ASSERT_TRUE(
+        ::google::protobuf::util::JsonStringToMessage(kExampleConfig, &config_)
+            .ok());
+  }
+
+  // Make the JWKS server respond with status and body.
+  void SetResponse(const std::string &status, const std::string &body) {
+    ON_CALL(mock_cm_.async_client_, send_(_, _, _))
+        .WillByDefault(Invoke([this, status, body](
+                                  MessagePtr &, AsyncClient::Callbacks &cb,
+                                  const Http::AsyncClient::RequestOptions &)
+                                  -> AsyncClient::Request * {
+          Http::MessagePtr response_message(new ResponseMessageImpl(
+              HeaderMapPtr{new TestHeaderMapImpl{{":status", status}}}));
+          response_message->body().reset(new Buffer::OwnedImpl(body));
+          fetch_count_++;
+          cb.onSuccess(std::move(response_message));
+          return nullptr;
+        }));
+  }
+
+  std::unique_ptr<JwksRefresher> CreateRefresher() {
+    return std::unique_ptr<JwksRefresher>(new JwksRefresher(
+        config_, mock_cm_, dispatcher_,
+        [this](const std::string &issuer,
+               std::shared_ptr<const Pubkeys> pubkey) {
+          EXPECT_EQ(issuer, kJwtIssuer);
+          EXPECT_EQ(pubkey->GetStatus(), Status::OK);
+          publish_count_++;
+          pubkey_ = pubkey;
+        }));
+  }
+
+  JwtAuthentication config_;
+  NiceMock<Upstream::MockClusterManager> mock_cm_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  int fetch_count_{};
+  int publish_count_{};
+  // The last published keys.
+  std::shared_ptr<const Pubkeys> pubkey_;
+};
+
+TEST_F(JwksRefresherTest, TestRefreshBeforeExpiry) {
+  SetResponse("200", kPublicKey);
+  // Only the issuer with remote JWKS is refreshed.
+  auto timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(450000), _))
+      .Times(2);
+
+  auto refresher = CreateRefresher();
+  EXPECT_EQ(fetch_count_, 1);
+  EXPECT_EQ(publish_count_, 1);
+
+  timer->callback_();
+  EXPECT_EQ(fetch_count_, 2);
+  EXPECT_EQ(publish_count_, 2);
+}
+
+TEST_F(JwksRefresherTest, TestUnchangedJwksKeepsKeys) {
+  SetResponse("200", kPublicKey);
+  auto timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+
+  auto refresher = CreateRefresher();
+  auto pubkey = pubkey_;
+  ASSERT_TRUE(pubkey != nullptr);
+
+  // The same keys are published again to renew them.
+  timer->callback_();
+  EXPECT_EQ(publish_count_, 2);
+  EXPECT_EQ(pubkey_, pubkey);
+
+  // A rotated JWKS is published as new keys.
+  std::string rotated = kPublicKey;
+  rotated.replace(rotated.find("62a93512"), 8, "b3319a14");
+  SetResponse("200", rotated);
+  timer->callback_();
+  EXPECT_EQ(publish_count_, 3);
+  EXPECT_NE(pubkey_, pubkey);
+}
+
+TEST_F(JwksRefresherTest, TestRetryFailedRefresh) {
+  SetResponse("500", "");
+  auto timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(5000), _));
+
+  auto refresher = CreateRefresher();
+  EXPECT_EQ(fetch_count_, 1);
+  EXPECT_EQ(publish_count_, 0);
+}
+
+TEST_F(JwksRefresherTest, TestRetryInvalidJwks) {
+  SetResponse("200", "invalid jwks");
+  auto timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+  EXPECT_CALL(*timer, enableTimer(std::chrono::milliseconds(5000), _));
+
+  auto refresher = CreateRefresher();
+  EXPECT_EQ(publish_count_, 0);
+}
+
+}  // namespace
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
@@ -91,57 +91,48 @@ const uint8_t kReverseLookupTableBase64Url[256] = {
     64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
     64, 64, 64, 64, 64, 64, 64, 64, 64};
 
-bool IsNotBase64UrlChar(int8_t c) {
-  return kReverseLookupTableBase64Url[static_cast<int32_t>(c)] & 64;
-}
-
 }  // namespace
 
-std::string Base64UrlDecode(std::string input) {
+bool Base64UrlDecode(absl::string_view input, std::string *output) {
   // allow at most 2 padding letters at the end of the input, only if input
   // length is divisible by 4
-  int len = input.length();
-  if (len % 4 == 0) {
-    if (input[len - 1] == '=') {
-      input.pop_back();
-      if (input[len - 2] == '=') {
-        input.pop_back();
-      }
+  if (!input.empty() && input.size() % 4 == 0 && input.back() == '=') {
+    input.remove_suffix(1);
+    if (input.back() == '=') {
+      input.remove_suffix(1);
     }
   }
-  // if input contains non-base64url character, return empty string
-  // Note: padding letter must not be contained
-  if (std::find_if(input.begin(), input.end(), IsNotBase64UrlChar) !=
-      input.end()) {
-    return "";
+  // A single letter can not encode a byte.
+  if (input.size() % 4 == 1) {
+    return false;
   }
-
-  // base64url is using '-', '_' instead of '+', '/' in base64 string.
-  std::replace(input.begin(), input.end(), '-', '+');
-  std::replace(input.begin(), input.end(), '_', '/');
-
-  // base64 string should be padded with '=' so as to the length of the string
-  // is divisible by 4.
-  switch (input.length() % 4) {
-    case 0:
-      break;
-    case 2:
-      input += "==";
-      break;
-    case 3:
-      input += "=";
-      break;
-    default:
-      // * an invalid base64url input. return empty string.
-      return "";
+  output->clear();
+  output->reserve(input.size() / 4 * 3 + 2);
+  // Decode straight from the input, 6 bits per letter.
+  uint32_t bits = 0;
+  int num_bits = 0;
+  for (char c : input) {
+    uint8_t value = kReverseLookupTableBase64Url[static_cast<uint8_t>(c)];
+    // if input contains non-base64url character, fail
+    // Note: padding letter must not be contained
+    if (value & 64) {
+      return false;
+    }
+    bits = (bits << 6) | value;
+    num_bits += 6;
+    if (num_bits >= 8) {
+      num_bits -= 8;
+      output->push_back(static_cast<char>(bits >> num_bits));
+      bits &= (1 << num_bits) - 1;
+    }
   }
-  return Base64::decode(input);
+  return true;
 }
 
 namespace {
 
-const uint8_t *CastToUChar(const std::string &str) {
-  return reinterpret_cast<const uint8_t *>(str.c_str());
+const uint8_t *CastToUChar(absl::string_view str) {
+  return reinterpret_cast<const uint8_t *>(str.data());
 }
 
 // Class to create EVP_PKEY object from string of public key, formatted in PEM
@@ -213,8 +204,8 @@ class EvpPkeyGetter : public WithStatus {
   }
 
   bssl::UniquePtr<BIGNUM> BigNumFromBase64UrlString(const std::string &s) {
-    std::string s_decoded = Base64UrlDecode(s);
-    if (s_decoded == "") {
+    std::string s_decoded;
+    if (!Base64UrlDecode(s, &s_decoded) || s_decoded.empty()) {
       return nullptr;
     }
     return bssl::UniquePtr<BIGNUM>(
@@ -239,39 +230,74 @@ class EvpPkeyGetter : public WithStatus {
 
 }  // namespace
 
-Jwt::Jwt(const std::string &jwt) {
-  // jwt must have exactly 2 dots
-  if (std::count(jwt.begin(), jwt.end(), '.') != 2) {
+Jwt::Jwt(const std::string &jwt)
+    : jwt_(jwt), payload_(std::make_shared<JwtClaims>()) {
+  // jwt must have exactly 2 dots, with something around each of them
+  size_t header_end = jwt_.find('.');
+  size_t payload_end = header_end == std::string::npos
+                           ? std::string::npos
+                           : jwt_.find('.', header_end + 1);
+  if (payload_end == std::string::npos ||
+      jwt_.find('.', payload_end + 1) != std::string::npos ||
+      header_end == 0 || payload_end == header_end + 1 ||
+      payload_end + 1 == jwt_.size()) {
     UpdateStatus(Status::JWT_BAD_FORMAT);
     return;
   }
-  auto jwt_split = StringUtil::splitToken(jwt, ".");
-  if (jwt_split.size() != 3) {
-    UpdateStatus(Status::JWT_BAD_FORMAT);
+  absl::string_view token(jwt_);
+  header_str_base64url_ = token.substr(0, header_end);
+  payload_str_base64url_ =
+      token.substr(header_end + 1, payload_end - header_end - 1);
+  signed_data_ = token.substr(0, payload_end);
+
+  // Header and payload are decoded into a new buffer each, which the parsed
+  // claims take over.
+  std::string decoded;
+  if (!Base64UrlDecode(header_str_base64url_, &decoded)) {
+    UpdateStatus(Status::JWT_HEADER_PARSE_ERROR);
+    return;
+  }
+  ParseHeader(std::move(decoded));
+  if (GetStatus() != Status::OK) {
     return;
   }
 
-  // Parse header json
-  header_str_base64url_ = std::string(jwt_split[0].begin(), jwt_split[0].end());
-  header_str_ = Base64UrlDecode(header_str_base64url_);
-  try {
-    header_ = Json::Factory::loadFromString(header_str_);
-  } catch (Json::Exception &e) {
+  if (!Base64UrlDecode(payload_str_base64url_, &decoded)) {
+    UpdateStatus(Status::JWT_PAYLOAD_PARSE_ERROR);
+    return;
+  }
+  ParsePayload(std::move(decoded));
+  if (GetStatus() != Status::OK) {
+    return;
+  }
+
+  // Set up signature
+  if (!Base64UrlDecode(token.substr(payload_end + 1), &signature_) ||
+      signature_.empty()) {
+    // Signature is a bad Base64url input.
+    UpdateStatus(Status::JWT_SIGNATURE_PARSE_ERROR);
+    return;
+  }
+}
+
+void Jwt::ParseHeader(std::string header_str) {
+  if (!header_.Parse(std::move(header_str))) {
     UpdateStatus(Status::JWT_HEADER_PARSE_ERROR);
     return;
   }
+  header_parsed_ = true;
 
   // Header should contain "alg".
-  if (!header_->hasObject("alg")) {
+  const JwtClaims::Claim *alg = header_.Find("alg");
+  if (alg == nullptr) {
     UpdateStatus(Status::JWT_HEADER_NO_ALG);
     return;
   }
-  try {
-    alg_ = header_->getString("alg");
-  } catch (Json::Exception &e) {
+  if (alg->type != JwtClaims::Type::STRING) {
     UpdateStatus(Status::JWT_HEADER_BAD_ALG);
     return;
   }
+  alg_ = std::string(header_.Strings(*alg)[0]);
 
   if (alg_ != "RS256" && alg_ != "ES256" && alg_ != "RS384" &&
       alg_ != "RS512") {
@@ -280,50 +306,54 @@ Jwt::Jwt(const std::string &jwt) {
   }
 
   // Header may contain "kid", which should be a string if exists.
-  try {
-    kid_ = header_->getString("kid", "");
-  } catch (Json::Exception &e) {
-    UpdateStatus(Status::JWT_HEADER_BAD_KID);
-    return;
+  const JwtClaims::Claim *kid = header_.Find("kid");
+  if (kid != nullptr) {
+    if (kid->type != JwtClaims::Type::STRING) {
+      UpdateStatus(Status::JWT_HEADER_BAD_KID);
+      return;
+    }
+    kid_ = std::string(header_.Strings(*kid)[0]);
   }
+}
 
-  // Parse payload json
-  payload_str_base64url_ =
-      std::string(jwt_split[1].begin(), jwt_split[1].end());
-  payload_str_ = Base64UrlDecode(payload_str_base64url_);
-  try {
-    payload_ = Json::Factory::loadFromString(payload_str_);
-  } catch (Json::Exception &e) {
+void Jwt::ParsePayload(std::string payload_str) {
+  if (!payload_->Parse(std::move(payload_str))) {
     UpdateStatus(Status::JWT_PAYLOAD_PARSE_ERROR);
     return;
   }
+  payload_parsed_ = true;
 
-  iss_ = payload_->getString("iss", "");
-  sub_ = payload_->getString("sub", "");
-  exp_ = payload_->getInteger("exp", 0);
+  // The claims are optional, but have to have the right type if they exist.
+  const JwtClaims::Claim *iss = payload_->Find("iss");
+  const JwtClaims::Claim *sub = payload_->Find("sub");
+  const JwtClaims::Claim *exp = payload_->Find("exp");
+  if ((iss != nullptr && iss->type != JwtClaims::Type::STRING) ||
+      (sub != nullptr && sub->type != JwtClaims::Type::STRING) ||
+      (exp != nullptr && exp->type != JwtClaims::Type::INTEGER)) {
+    UpdateStatus(Status::JWT_PAYLOAD_PARSE_ERROR);
+    return;
+  }
+  if (iss != nullptr) {
+    iss_ = std::string(payload_->Strings(*iss)[0]);
+  }
+  if (sub != nullptr) {
+    sub_ = std::string(payload_->Strings(*sub)[0]);
+  }
+  if (exp != nullptr) {
+    exp_ = exp->integer;
+  }
 
   // "aud" can be either string array or string.
-  // Try as string array, read it as empty array if doesn't exist.
-  try {
-    aud_ = payload_->getStringArray("aud", true);
-  } catch (Json::Exception &e) {
-    // Try as string
-    try {
-      auto audience = payload_->getString("aud");
-      aud_.push_back(audience);
-    } catch (Json::Exception &e) {
+  const JwtClaims::Claim *aud = payload_->Find("aud");
+  if (aud != nullptr) {
+    if (aud->type != JwtClaims::Type::STRING &&
+        aud->type != JwtClaims::Type::STRING_ARRAY) {
       UpdateStatus(Status::JWT_PAYLOAD_PARSE_ERROR);
       return;
     }
-  }
-
-  // Set up signature
-  signature_ =
-      Base64UrlDecode(std::string(jwt_split[2].begin(), jwt_split[2].end()));
-  if (signature_ == "") {
-    // Signature is a bad Base64url input.
-    UpdateStatus(Status::JWT_SIGNATURE_PARSE_ERROR);
-    return;
+    for (absl::string_view audience : payload_->Strings(*aud)) {
+      aud_.emplace_back(audience);
+    }
   }
 }
 
@@ -332,20 +362,22 @@ bool Verifier::VerifySignatureRSA(EVP_PKEY *key, const EVP_MD *md,
                                   size_t signature_len,
                                   const uint8_t *signed_data,
                                   size_t signed_data_len) {
-  bssl::UniquePtr<EVP_MD_CTX> md_ctx(EVP_MD_CTX_create());
-
-  if (EVP_DigestVerifyInit(md_ctx.get(), nullptr, md, nullptr, key) != 1) {
-    return false;
-  }
-  if (EVP_DigestVerifyUpdate(md_ctx.get(), signed_data, signed_data_len) != 1) {
-    return false;
-  }
-  return (EVP_DigestVerifyFinal(md_ctx.get(), signature, signature_len) == 1);
+  // The context is reused by all verifications on this thread. It is cleaned
+  // up after each use, so it does not keep a reference to the key.
+  static thread_local bssl::UniquePtr<EVP_MD_CTX> md_ctx(EVP_MD_CTX_create());
+
+  bool verified =
+      EVP_DigestVerifyInit(md_ctx.get(), nullptr, md, nullptr, key) == 1 &&
+      EVP_DigestVerifyUpdate(md_ctx.get(), signed_data, signed_data_len) ==
+          1 &&
+      EVP_DigestVerifyFinal(md_ctx.get(), signature, signature_len) == 1;
+  EVP_MD_CTX_cleanup(md_ctx.get());
+  return verified;
 }
 
 bool Verifier::VerifySignatureRSA(EVP_PKEY *key, const EVP_MD *md,
                                   const std::string &signature,
-                                  const std::string &signed_data) {
+                                  absl::string_view signed_data) {
   return VerifySignatureRSA(key, md, CastToUChar(signature), signature.length(),
                             CastToUChar(signed_data), signed_data.length());
 }
@@ -375,7 +407,7 @@ bool Verifier::VerifySignatureEC(EC_KEY *key, const uint8_t *signature,
 }
 
 bool Verifier::VerifySignatureEC(EC_KEY *key, const std::string &signature,
-                                 const std::string &signed_data) {
+                                 absl::string_view signed_data) {
   return VerifySignatureEC(key, CastToUChar(signature), signature.length(),
                            CastToUChar(signed_data), signed_data.length());
 }
@@ -393,38 +425,33 @@ bool Verifier::Verify(const Jwt &jwt, const Pubkeys &pubkeys) {
     return false;
   }
 
-  std::string signed_data =
-      jwt.header_str_base64url_ + '.' + jwt.payload_str_base64url_;
-  bool kid_alg_matched = false;
-  for (auto &pubkey : pubkeys.keys_) {
-    // If kid is specified in JWT, JWK with the same kid is used for
-    // verification.
-    // If kid is not specified in JWT, try all JWK.
-    if (jwt.kid_ != "" && pubkey->kid_specified_ && pubkey->kid_ != jwt.kid_) {
-      continue;
+  absl::string_view signed_data = jwt.signed_data_;
+  const auto &keys = pubkeys.FindKeys(jwt.alg_, jwt.kid_);
+  // The index only holds keys whose kid and alg match the JWT, the key type
+  // is checked here so that a mismatch reports an invalid signature.
+  bool kid_alg_matched = !keys.empty();
+  if (jwt.alg_ == "ES256") {
+    for (const auto *pubkey : keys) {
+      if (pubkey->kty_ == "EC" &&
+          VerifySignatureEC(pubkey->ec_key_.get(), jwt.signature_,
+                            signed_data)) {
+        // Verification succeeded.
+        return true;
+      }
     }
-
-    // The same alg must be used.
-    if (pubkey->alg_specified_ && pubkey->alg_ != jwt.alg_) {
-      continue;
+  } else {
+    const EVP_MD *md;
+    if (jwt.alg_ == "RS384") {
+      md = EVP_sha384();
+    } else if (jwt.alg_ == "RS512") {
+      md = EVP_sha512();
+    } else {
+      // default to SHA256
+      md = EVP_sha256();
     }
-    kid_alg_matched = true;
-
-    if (pubkey->kty_ == "EC" &&
-        VerifySignatureEC(pubkey->ec_key_.get(), jwt.signature_, signed_data)) {
-      // Verification succeeded.
-      return true;
-    } else if (pubkey->pem_format_ || pubkey->kty_ == "RSA") {
-      const EVP_MD *md;
-      if (jwt.alg_ == "RS384") {
-        md = EVP_sha384();
-      } else if (jwt.alg_ == "RS512") {
-        md = EVP_sha512();
-      } else {
-        // default to SHA256
-        md = EVP_sha256();
-      }
-      if (VerifySignatureRSA(pubkey->evp_pkey_.get(), md, jwt.signature_,
+    for (const auto *pubkey : keys) {
+      if ((pubkey->pem_format_ || pubkey->kty_ == "RSA") &&
+          VerifySignatureRSA(pubkey->evp_pkey_.get(), md, jwt.signature_,
                              signed_data)) {
         // Verification succeeded.
         return true;
@@ -441,18 +468,29 @@ bool Verifier::Verify(const Jwt &jwt, const Pubkeys &pubkeys) {
 }
 
 // Returns the parsed header.
-Json::ObjectSharedPtr Jwt::Header() { return header_; }
+Json::ObjectSharedPtr Jwt::Header() {
+  if (!header_json_ && header_parsed_) {
+    header_json_ = Json::Factory::loadFromString(header_.json());
+  }
+  return header_json_;
+}
 
-const std::string &Jwt::HeaderStr() { return header_str_; }
-const std::string &Jwt::HeaderStrBase64Url() { return header_str_base64url_; }
+const std::string &Jwt::HeaderStr() { return header_.json(); }
+absl::string_view Jwt::HeaderStrBase64Url() { return header_str_base64url_; }
 const std::string &Jwt::Alg() { return alg_; }
 const std::string &Jwt::Kid() { return kid_; }
 
 // Returns payload JSON.
-Json::ObjectSharedPtr Jwt::Payload() { return payload_; }
+Json::ObjectSharedPtr Jwt::Payload() {
+  if (!payload_json_ && payload_parsed_) {
+    payload_json_ = Json::Factory::loadFromString(payload_->json());
+  }
+  return payload_json_;
+}
 
-const std::string &Jwt::PayloadStr() { return payload_str_; }
-const std::string &Jwt::PayloadStrBase64Url() { return payload_str_base64url_; }
+const std::string &Jwt::PayloadStr() { return payload_->json(); }
+absl::string_view Jwt::PayloadStrBase64Url() { return payload_str_base64url_; }
+JwtClaimsConstSharedPtr Jwt::PayloadClaims() { return payload_; }
 const std::string &Jwt::Iss() { return iss_; }
 const std::vector<std::string> &Jwt::Aud() { return aud_; }
 const std::string &Jwt::Sub() { return sub_; }
@@ -588,6 +626,56 @@ void Pubkeys::ExtractPubkeyFromJwkEC(Json::ObjectSharedPtr jwk_json) {
   }
 }
 
+void Pubkeys::BuildIndex() {
+  index_.clear();
+  // Jwt only accepts these algorithms.
+  for (const char *alg : {"RS256", "RS384", "RS512", "ES256"}) {
+    AlgKeys &alg_keys = index_[alg];
+    for (const auto &pubkey : keys_) {
+      // The same alg must be used.
+      if (pubkey->alg_specified_ && pubkey->alg_ != alg) {
+        continue;
+      }
+      alg_keys.all_.push_back(pubkey.get());
+      if (pubkey->kid_specified_) {
+        alg_keys.by_kid_[pubkey->kid_];
+      }
+    }
+    // If kid is specified in JWT, JWK with the same kid is used for
+    // verification, as well as JWK without kid.
+    for (const Pubkey *pubkey : alg_keys.all_) {
+      if (pubkey->kid_specified_) {
+        alg_keys.by_kid_[pubkey->kid_].push_back(pubkey);
+        continue;
+      }
+      alg_keys.without_kid_.push_back(pubkey);
+      for (auto &it : alg_keys.by_kid_) {
+        it.second.push_back(pubkey);
+      }
+    }
+  }
+}
+
+const std::vector<const Pubkeys::Pubkey *> &Pubkeys::FindKeys(
+    const std::string &alg, const std::string &kid) const {
+  static const std::vector<const Pubkey *> *no_keys =
+      new std::vector<const Pubkey *>();
+  auto alg_it = index_.find(alg);
+  if (alg_it == index_.end()) {
+    return *no_keys;
+  }
+  const AlgKeys &alg_keys = alg_it->second;
+  // If kid is not specified in JWT, try all JWK.
+  if (kid.empty()) {
+    return alg_keys.all_;
+  }
+  auto kid_it = alg_keys.by_kid_.find(kid);
+  if (kid_it == alg_keys.by_kid_.end()) {
+    return alg_keys.without_kid_;
+  }
+  return kid_it->second;
+}
+
 std::unique_ptr<Pubkeys> Pubkeys::CreateFrom(const std::string &pkey,
                                              Type type) {
   std::unique_ptr<Pubkeys> keys(new Pubkeys());
@@ -601,6 +689,7 @@ std::unique_ptr<Pubkeys> Pubkeys::CreateFrom(const std::string &pkey,
     default:
       PANIC("can not reach here");
   }
+  keys->BuildIndex();
   return keys;
 }
 
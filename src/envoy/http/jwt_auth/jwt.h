@@ -16,12 +16,15 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "envoy/json/json_object.h"
 #include "openssl/ec.h"
 #include "openssl/evp.h"
+#include "src/envoy/http/jwt_auth/jwt_claims.h"
 
 namespace Envoy {
 namespace Http {
@@ -109,7 +112,9 @@ enum class Status {
 
 std::string StatusToString(Status status);
 
-std::string Base64UrlDecode(std::string input);
+// Decodes base64url encoded input, which may be padded, into output. Returns
+// false if input is not valid base64url.
+bool Base64UrlDecode(absl::string_view input, std::string* output);
 
 // Base class to keep the status that represents "OK" or the first failure
 // reason
@@ -165,9 +170,9 @@ class Verifier : public WithStatus {
                           const uint8_t* signed_data, size_t signed_data_len);
   bool VerifySignatureRSA(EVP_PKEY* key, const EVP_MD* md,
                           const std::string& signature,
-                          const std::string& signed_data);
+                          absl::string_view signed_data);
   bool VerifySignatureEC(EC_KEY* key, const std::string& signature,
-                         const std::string& signed_data);
+                         absl::string_view signed_data);
   bool VerifySignatureEC(EC_KEY* key, const uint8_t* signature,
                          size_t signature_len, const uint8_t* signed_data,
                          size_t signed_data_len);
@@ -185,6 +190,8 @@ class Jwt : public WithStatus {
   // You can check if the setup was successfully done by seeing if GetStatus()
   // == Status::OK. When the given JWT has a format error, GetStatus() returns
   // the error detail.
+  // Only the claims used by the filters are extracted, the header and payload
+  // JSON objects are built when Header() or Payload() is called.
   Jwt(const std::string& jwt);
 
   // It returns a pointer to a JSON object of the header of the given JWT.
@@ -195,7 +202,7 @@ class Jwt : public WithStatus {
   // They return a string (or base64url-encoded string) of the header JSON of
   // the given JWT.
   const std::string& HeaderStr();
-  const std::string& HeaderStrBase64Url();
+  absl::string_view HeaderStrBase64Url();
 
   // They return the "alg" (or "kid") value of the header of the given JWT.
   const std::string& Alg();
@@ -212,7 +219,11 @@ class Jwt : public WithStatus {
   // They return a string (or base64url-encoded string) of the payload JSON of
   // the given JWT.
   const std::string& PayloadStr();
-  const std::string& PayloadStrBase64Url();
+  absl::string_view PayloadStrBase64Url();
+
+  // It returns the claims of the payload of the given JWT, which can be
+  // shared with later filters.
+  JwtClaimsConstSharedPtr PayloadClaims();
 
   // It returns the "iss" claim value of the given JWT, or an empty string if
   // "iss" claim does not exist.
@@ -231,19 +242,31 @@ class Jwt : public WithStatus {
   int64_t Exp();
 
  private:
-  Json::ObjectSharedPtr header_;
-  std::string header_str_;
-  std::string header_str_base64url_;
-  Json::ObjectSharedPtr payload_;
-  std::string payload_str_;
-  std::string payload_str_base64url_;
+  // Parses the decoded header and extracts "alg" and "kid".
+  void ParseHeader(std::string header_str);
+  // Parses the decoded payload and extracts the registered claims.
+  void ParsePayload(std::string payload_str);
+
+  // The given JWT, the views below point into it.
+  std::string jwt_;
+  absl::string_view header_str_base64url_;
+  absl::string_view payload_str_base64url_;
+  // The header and the payload with the dot between them.
+  absl::string_view signed_data_;
+  JwtClaims header_;
+  std::shared_ptr<JwtClaims> payload_;
+  // Built on demand by Header() and Payload().
+  Json::ObjectSharedPtr header_json_;
+  Json::ObjectSharedPtr payload_json_;
+  bool header_parsed_ = false;
+  bool payload_parsed_ = false;
   std::string signature_;
   std::string alg_;
   std::string kid_;
   std::string iss_;
   std::vector<std::string> aud_;
   std::string sub_;
-  int64_t exp_;
+  int64_t exp_ = 0;
 
   /*
    * TODO: try not to use friend function
@@ -274,6 +297,9 @@ class Pubkeys : public WithStatus {
   void ExtractPubkeyFromJwkRSA(Json::ObjectSharedPtr jwk_json);
   void ExtractPubkeyFromJwkEC(Json::ObjectSharedPtr jwk_json);
 
+  // Indexes keys_ by the "alg" and "kid" of the JWTs they may verify.
+  void BuildIndex();
+
   class Pubkey {
    public:
     Pubkey(){};
@@ -288,6 +314,22 @@ class Pubkeys : public WithStatus {
   };
   std::vector<std::unique_ptr<Pubkey> > keys_;
 
+  // The keys matching one JWT "alg", in the order of keys_.
+  struct AlgKeys {
+    // Keys for a JWT with the given "kid": the keys with that kid followed
+    // by the keys without kid.
+    std::unordered_map<std::string, std::vector<const Pubkey*> > by_kid_;
+    // Keys for a JWT with an unknown "kid".
+    std::vector<const Pubkey*> without_kid_;
+    // Keys for a JWT without "kid".
+    std::vector<const Pubkey*> all_;
+  };
+  std::unordered_map<std::string, AlgKeys> index_;
+
+  // Returns the keys to verify a JWT with the given "alg" and "kid" with.
+  const std::vector<const Pubkey*>& FindKeys(const std::string& alg,
+                                             const std::string& kid) const;
+
   /*
    * TODO: try not to use friend function
    */
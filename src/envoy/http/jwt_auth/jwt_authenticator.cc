@@ -26,26 +26,11 @@ namespace {
 // The HTTP header to pass verified token payload.
 const LowerCaseString kJwtPayloadKey("sec-istio-auth-userinfo");
 
-// Extract host and path from a URI
-void ExtractUriHostPath(const std::string &uri, std::string *host,
-                        std::string *path) {
-  // Example:
-  // uri  = "https://example.com/certs"
-  // pos  :          ^
-  // pos1 :                     ^
-  // host = "example.com"
-  // path = "/certs"
-  auto pos = uri.find("://");
-  pos = pos == std::string::npos ? 0 : pos + 3;  // Start position of host
-  auto pos1 = uri.find("/", pos);
-  if (pos1 == std::string::npos) {
-    // If uri doesn't have "/", the whole string is treated as host.
-    *host = uri.substr(pos);
-    *path = "/";
-  } else {
-    *host = uri.substr(pos, pos1 - pos);
-    *path = "/" + uri.substr(pos1 + 1);
-  }
+// Get the current time in seconds since the epoch, as in the "exp" claim.
+int64_t UnixTimestamp() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
 }
 
 }  // namespace
@@ -56,7 +41,8 @@ JwtAuthenticator::JwtAuthenticator(Upstream::ClusterManager &cm,
 
 // Verify a JWT token.
 void JwtAuthenticator::Verify(HeaderMap &headers,
-                              JwtAuthenticator::Callbacks *callback) {
+                              JwtAuthenticator::Callbacks *callback,
+                              StreamInfo::FilterState *filter_state) {
   headers_ = &headers;
   callback_ = callback;
 
@@ -82,7 +68,7 @@ void JwtAuthenticator::Verify(HeaderMap &headers,
 
   ENVOY_LOG(debug, "Jwt authentication starts");
   std::vector<std::unique_ptr<JwtTokenExtractor::Token>> tokens;
-  store_.token_extractor().Extract(headers, &tokens);
+  store_.token_extractor().Extract(headers, &tokens, filter_state);
   if (tokens.size() == 0) {
     if (OkToBypass()) {
       DoneWithStatus(Status::OK);
@@ -95,18 +81,19 @@ void JwtAuthenticator::Verify(HeaderMap &headers,
   // Only take the first one now.
   token_.swap(tokens[0]);
 
-  jwt_.reset(new Jwt(token_->token()));
+  token_digest_ = TokenCache::Digest(token_->token());
+  if (VerifyCachedToken()) {
+    return;
+  }
+
+  jwt_ = std::make_shared<Jwt>(token_->token());
   if (jwt_->GetStatus() != Status::OK) {
     DoneWithStatus(jwt_->GetStatus());
     return;
   }
 
   // Check "exp" claim.
-  const auto unix_timestamp =
-      std::chrono::duration_cast<std::chrono::seconds>(
-          std::chrono::system_clock::now().time_since_epoch())
-          .count();
-  if (jwt_->Exp() < unix_timestamp) {
+  if (jwt_->Exp() < UnixTimestamp()) {
     DoneWithStatus(Status::JWT_EXPIRED);
     return;
   }
@@ -190,6 +177,9 @@ void JwtAuthenticator::onFailure(AsyncClient::FailureReason) {
 }
 
 void JwtAuthenticator::onDestroy() {
+  if (verify_canceled_) {
+    *verify_canceled_ = true;
+  }
   if (request_) {
     request_->cancel();
     request_ = nullptr;
@@ -210,17 +200,78 @@ void JwtAuthenticator::OnFetchPubkeyDone(const std::string &pubkey) {
 
 // Verify with a specific public key.
 void JwtAuthenticator::VerifyKey(const PubkeyCacheItem &issuer_item) {
+  uint64_t pubkey_version = issuer_item.pubkey_version();
+  VerifyPool *verify_pool = store_.verify_pool();
+  if (verify_pool) {
+    // The pubkey cache items live as long as the store, but the keys may be
+    // replaced while the pool verifies the token.
+    verify_canceled_ = std::make_shared<bool>(false);
+    if (verify_pool->Verify(
+            jwt_, issuer_item.shared_pubkey(), store_.dispatcher(),
+            [this, canceled = verify_canceled_, &issuer_item,
+             pubkey_version](Status status) {
+              if (!*canceled) {
+                verify_canceled_.reset();
+                OnVerifyDone(issuer_item, pubkey_version, status);
+              }
+            })) {
+      return;
+    }
+    verify_canceled_.reset();
+  }
+
   JwtAuth::Verifier v;
-  if (!v.Verify(*jwt_, *issuer_item.pubkey())) {
-    DoneWithStatus(v.GetStatus());
+  OnVerifyDone(issuer_item, pubkey_version,
+               v.Verify(*jwt_, *issuer_item.pubkey()) ? Status::OK
+                                                      : v.GetStatus());
+}
+
+void JwtAuthenticator::OnVerifyDone(const PubkeyCacheItem &issuer_item,
+                                    uint64_t pubkey_version,
+                                    const Status &status) {
+  if (status != Status::OK) {
+    DoneWithStatus(status);
     return;
   }
 
+  // A token verified with keys replaced since is not found in the cache.
+  store_.token_cache().Insert(
+      token_digest_, VerifiedToken{jwt_->Iss(), jwt_->PayloadClaims(),
+                                   jwt_->Exp(), pubkey_version});
+  AcceptToken(issuer_item, jwt_->PayloadClaims());
+}
+
+bool JwtAuthenticator::VerifyCachedToken() {
+  VerifiedToken cached;
+  if (!store_.token_cache().Lookup(token_digest_, &cached)) {
+    return false;
+  }
+  // The entry is only good while the token is not expired and the keys it
+  // was verified with are still current, otherwise the token goes through
+  // the full verification, which also reports why it fails.
+  auto issuer = store_.pubkey_cache().LookupByIssuer(cached.issuer);
+  if (cached.exp < UnixTimestamp() || issuer == nullptr || issuer->Expired() ||
+      issuer->pubkey_version() != cached.pubkey_version) {
+    store_.token_cache().Remove(token_digest_);
+    return false;
+  }
+  // The same token may be extracted from a location the issuer doesn't allow.
+  if (!token_->IsIssuerAllowed(cached.issuer)) {
+    return false;
+  }
+  ENVOY_LOG(debug, "Jwt for issuer {} was verified before", cached.issuer);
+  AcceptToken(*issuer, cached.payload);
+  return true;
+}
+
+void JwtAuthenticator::AcceptToken(const PubkeyCacheItem &issuer_item,
+                                   JwtClaimsConstSharedPtr payload) {
   // TODO: can we save as proto or json object directly?
   // Use the issuer as the entry key for simplicity. The forward_payload_header
   // field can be removed or replace by a boolean (to make `save` is
   // conditional)
-  callback_->savePayload(issuer_item.jwt_config().issuer(), jwt_->PayloadStr());
+  callback_->savePayload(issuer_item.jwt_config().issuer(), payload->json());
+  callback_->saveClaims(issuer_item.jwt_config().issuer(), payload);
 
   if (!issuer_item.jwt_config().forward()) {
     // Remove JWT from headers.
@@ -37,8 +37,15 @@ class JwtAuthenticator : public Logger::Loggable<Logger::Id::filter>,
     virtual void onDone(const Status& status) PURE;
     virtual void savePayload(const std::string& key,
                              const std::string& payload) PURE;
+    // Called with the parsed payload after savePayload(), so that later
+    // filters can use it without parsing the payload again.
+    virtual void saveClaims(const std::string& key,
+                            JwtClaimsConstSharedPtr claims) PURE;
   };
-  void Verify(HeaderMap& headers, Callbacks* callback);
+  // The filter state of the request, if given, is used to share the work
+  // with other filters.
+  void Verify(HeaderMap& headers, Callbacks* callback,
+              StreamInfo::FilterState* filter_state = nullptr);
 
   // Called when the object is about to be destroyed.
   void onDestroy();
@@ -53,9 +60,20 @@ class JwtAuthenticator : public Logger::Loggable<Logger::Id::filter>,
   void onSuccess(MessagePtr&& response);
   void onFailure(AsyncClient::FailureReason);
 
-  // Verify with a specific public key.
+  // Verify with a specific public key, on the verify pool if there is one.
   void VerifyKey(const PubkeyCacheItem& issuer);
 
+  // Handle the signature verification done event.
+  void OnVerifyDone(const PubkeyCacheItem& issuer, uint64_t pubkey_version,
+                    const Status& status);
+
+  // Accept the token if it was verified before, return true if it was.
+  bool VerifyCachedToken();
+
+  // Save the payload of a verified token and finish with OK.
+  void AcceptToken(const PubkeyCacheItem& issuer,
+                   JwtClaimsConstSharedPtr payload);
+
   // Handle the public key fetch done event.
   void OnFetchPubkeyDone(const std::string& pubkey);
 
@@ -69,10 +87,12 @@ class JwtAuthenticator : public Logger::Loggable<Logger::Id::filter>,
   Upstream::ClusterManager& cm_;
   // The cache object.
   JwtAuthStore& store_;
-  // The JWT object.
-  std::unique_ptr<JwtAuth::Jwt> jwt_;
+  // The JWT object, shared with the verify pool while it is verified there.
+  std::shared_ptr<JwtAuth::Jwt> jwt_;
   // The token data
   std::unique_ptr<JwtTokenExtractor::Token> token_;
+  // The digest of the token, the key of the token cache.
+  std::string token_digest_;
 
   // The HTTP request headers
   HeaderMap* headers_{};
@@ -83,6 +103,8 @@ class JwtAuthenticator : public Logger::Loggable<Logger::Id::filter>,
   std::string uri_;
   // The pending remote request so it can be canceled.
   AsyncClient::Request* request_{};
+  // Set when this is destroyed while the verify pool verifies the token.
+  std::shared_ptr<bool> verify_canceled_;
 };
 
 }  // namespace JwtAuth
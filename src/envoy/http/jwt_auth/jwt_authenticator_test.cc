@@ -15,9 +15,12 @@
 
 #include "src/envoy/http/jwt_auth/jwt_authenticator.h"
 
+#include <future>
+
 #include "common/http/message_impl.h"
 #include "common/json/json_loader.h"
 #include "gtest/gtest.h"
+#include "test/mocks/event/mocks.h"
 #include "test/mocks/upstream/mocks.h"
 #include "test/test_common/utility.h"
 
@@ -333,6 +336,8 @@ class MockJwtAuthenticatorCallbacks : public JwtAuthenticator::Callbacks {
   MOCK_METHOD1(onDone, void(const Status &status));
   MOCK_METHOD2(savePayload,
                void(const std::string &key, const std::string &payload));
+  MOCK_METHOD2(saveClaims,
+               void(const std::string &key, JwtClaimsConstSharedPtr claims));
 };
 
 class JwtAuthenticatorTest : public ::testing::Test {
@@ -404,6 +409,153 @@ TEST_F(JwtAuthenticatorTest, TestOkJWTandCache) {
   EXPECT_EQ(mock_pubkey.called_count(), 1);
 }
 
+TEST_F(JwtAuthenticatorTest, TestVerifiedTokenCache) {
+  MockUpstream mock_pubkey(mock_cm_, kPublicKey);
+
+  std::vector<JwtClaimsConstSharedPtr> saved_claims;
+  for (int i = 0; i < 2; i++) {
+    auto headers = TestHeaderMapImpl{{"Authorization", "Bearer " + kGoodToken}};
+    MockJwtAuthenticatorCallbacks mock_cb;
+    EXPECT_CALL(mock_cb, onDone(_)).WillOnce(Invoke([](const Status &status) {
+      ASSERT_EQ(status, Status::OK);
+    }));
+    EXPECT_CALL(mock_cb, savePayload(kJwtIssuer, kGoodTokenPayload));
+    EXPECT_CALL(mock_cb, saveClaims(kJwtIssuer, _))
+        .WillOnce(Invoke(
+            [&saved_claims](const std::string &,
+                            JwtClaimsConstSharedPtr claims) {
+              saved_claims.push_back(claims);
+            }));
+    auth_->Verify(headers, &mock_cb);
+    EXPECT_FALSE(headers.Authorization());
+  }
+  EXPECT_EQ(store_->token_cache().Size(), 1);
+  // The cached token shares the claims parsed when it was verified.
+  ASSERT_EQ(saved_claims.size(), 2);
+  EXPECT_EQ(saved_claims[0], saved_claims[1]);
+  EXPECT_EQ(saved_claims[0]->json(), kGoodTokenPayload);
+
+  // Renewing the same keys keeps the cached entry.
+  auto issuer = store_->pubkey_cache().LookupByIssuer(kJwtIssuer);
+  uint64_t pubkey_version = issuer->pubkey_version();
+  issuer->SetRemotePubkeys(issuer->shared_pubkey());
+  EXPECT_EQ(issuer->pubkey_version(), pubkey_version);
+
+  // Rotate the JWKS to keys which don't match the token signature, the cached
+  // entry must not be used anymore.
+  std::string rotated_pubkey = kPublicKey;
+  std::size_t pos = rotated_pubkey.find("up97uqrF9MWOPaPkwSaBeuAPLOr9");
+  while (pos != std::string::npos) {
+    rotated_pubkey.replace(pos, 4, "vp97");
+    pos = rotated_pubkey.find("up97uqrF9MWOPaPkwSaBeuAPLOr9");
+  }
+  ASSERT_EQ(store_->pubkey_cache()
+                .LookupByIssuer(kJwtIssuer)
+                ->SetRemoteJwks(rotated_pubkey),
+            Status::OK);
+
+  auto headers = TestHeaderMapImpl{{"Authorization", "Bearer " + kGoodToken}};
+  EXPECT_CALL(mock_cb_, onDone(_)).WillOnce(Invoke([](const Status &status) {
+    ASSERT_EQ(status, Status::JWT_INVALID_SIGNATURE);
+  }));
+  auth_->Verify(headers, &mock_cb_);
+  EXPECT_EQ(store_->token_cache().Size(), 0);
+  EXPECT_EQ(mock_pubkey.called_count(), 1);
+}
+
+class JwtAuthenticatorVerifyPoolTest : public JwtAuthenticatorTest {
+ public:
+  // Verify signatures on a pool with one thread, at most max_queued tokens
+  // wait for it.
+  void SetupVerifyPool(size_t max_queued) {
+    pool_ = std::make_shared<VerifyPool>(api_->threadFactory(), 1, max_queued);
+    store_.reset(new JwtAuthStore(config_ptr_, pool_.get(), &dispatcher_));
+    auth_.reset(new JwtAuthenticator(mock_cm_, *store_));
+  }
+
+  // Wait for the callback the pool posts to the dispatcher.
+  Event::PostCb WaitForPostedCallback() { return posted_.get_future().get(); }
+
+  void SetUp() {
+    JwtAuthenticatorTest::SetUp();
+    ON_CALL(dispatcher_, post(_))
+        .WillByDefault(Invoke(
+            [this](Event::PostCb callback) { posted_.set_value(callback); }));
+  }
+
+  // Join the pool threads before the dispatcher is destroyed.
+  void TearDown() {
+    auth_.reset();
+    store_.reset();
+    pool_.reset();
+  }
+
+  Api::ApiPtr api_{Api::createApiForTest()};
+  VerifyPoolSharedPtr pool_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  std::promise<Event::PostCb> posted_;
+};
+
+TEST_F(JwtAuthenticatorVerifyPoolTest, TestOkJWT) {
+  SetupVerifyPool(1);
+  MockUpstream mock_pubkey(mock_cm_, kPublicKey);
+
+  auto headers = TestHeaderMapImpl{{"Authorization", "Bearer " + kGoodToken}};
+  EXPECT_CALL(mock_cb_, onDone(_)).Times(0);
+  auth_->Verify(headers, &mock_cb_);
+  Event::PostCb callback = WaitForPostedCallback();
+  ::testing::Mock::VerifyAndClearExpectations(&mock_cb_);
+
+  // The stream resumes when the result is run on the worker thread.
+  EXPECT_CALL(mock_cb_, onDone(_)).WillOnce(Invoke([](const Status &status) {
+    ASSERT_EQ(status, Status::OK);
+  }));
+  EXPECT_CALL(mock_cb_, savePayload(kJwtIssuer, kGoodTokenPayload));
+  callback();
+  EXPECT_FALSE(headers.Authorization());
+  EXPECT_EQ(store_->token_cache().Size(), 1);
+}
+
+TEST_F(JwtAuthenticatorVerifyPoolTest, TestInvalidSignature) {
+  SetupVerifyPool(1);
+  std::string token = kGoodToken;
+  token.back() = token.back() == 'A' ? 'B' : 'A';
+  MockUpstream mock_pubkey(mock_cm_, kPublicKey);
+
+  auto headers = TestHeaderMapImpl{{"Authorization", "Bearer " + token}};
+  auth_->Verify(headers, &mock_cb_);
+  Event::PostCb callback = WaitForPostedCallback();
+
+  EXPECT_CALL(mock_cb_, onDone(_)).WillOnce(Invoke([](const Status &status) {
+    ASSERT_EQ(status, Status::JWT_INVALID_SIGNATURE);
+  }));
+  callback();
+  EXPECT_EQ(store_->token_cache().Size(), 0);
+}
+
+TEST_F(JwtAuthenticatorVerifyPoolTest, TestDestroyedWhileVerifying) {
+  SetupVerifyPool(1);
+  MockUpstream mock_pubkey(mock_cm_, kPublicKey);
+
+  auto headers = TestHeaderMapImpl{{"Authorization", "Bearer " + kGoodToken}};
+  EXPECT_CALL(mock_cb_, onDone(_)).Times(0);
+  auth_->Verify(headers, &mock_cb_);
+  auth_->onDestroy();
+  WaitForPostedCallback()();
+}
+
+TEST_F(JwtAuthenticatorVerifyPoolTest, TestQueueFullVerifiesInline) {
+  SetupVerifyPool(0);
+  MockUpstream mock_pubkey(mock_cm_, kPublicKey);
+
+  auto headers = TestHeaderMapImpl{{"Authorization", "Bearer " + kGoodToken}};
+  EXPECT_CALL(dispatcher_, post(_)).Times(0);
+  EXPECT_CALL(mock_cb_, onDone(_)).WillOnce(Invoke([](const Status &status) {
+    ASSERT_EQ(status, Status::OK);
+  }));
+  auth_->Verify(headers, &mock_cb_);
+}
+
 TEST_F(JwtAuthenticatorTest, TestOkJWTPubkeyNoAlg) {
   // Test OK pubkey with no "alg" claim.
   std::string alg_claim = "  \"alg\": \"RS256\",";
@@ -0,0 +1,424 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/jwt_auth/jwt_claims.h"
+
+#include <limits>
+
+#include "common/common/macros.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+namespace {
+
+// Deepest nesting of arrays and objects accepted in a claim value.
+constexpr int kMaxDepth = 64;
+
+int HexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+void AppendUtf8(uint32_t code_point, std::string* out) {
+  if (code_point < 0x80) {
+    out->push_back(code_point);
+  } else if (code_point < 0x800) {
+    out->push_back(0xC0 | (code_point >> 6));
+    out->push_back(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    out->push_back(0xE0 | (code_point >> 12));
+    out->push_back(0x80 | ((code_point >> 6) & 0x3F));
+    out->push_back(0x80 | (code_point & 0x3F));
+  } else {
+    out->push_back(0xF0 | (code_point >> 18));
+    out->push_back(0x80 | ((code_point >> 12) & 0x3F));
+    out->push_back(0x80 | ((code_point >> 6) & 0x3F));
+    out->push_back(0x80 | (code_point & 0x3F));
+  }
+}
+
+}  // namespace
+
+// A recursive descent JSON parser which records the top-level members of an
+// object as claims and only validates nested values.
+class JwtClaims::Parser {
+ public:
+  Parser(JwtClaims& claims) : claims_(claims), json_(claims.json_) {}
+
+  bool ParseObject() {
+    if (!Consume('{')) {
+      return false;
+    }
+    if (Consume('}')) {
+      return AtEnd();
+    }
+    do {
+      Claim claim{};
+      if (!ParseString(&claim.name) || !Consume(':') ||
+          !ParseClaimValue(&claim)) {
+        return false;
+      }
+      claims_.claims_.push_back(claim);
+    } while (Consume(','));
+    return Consume('}') && AtEnd();
+  }
+
+ private:
+  void SkipWhitespace() {
+    while (pos_ < json_.size() &&
+           (json_[pos_] == ' ' || json_[pos_] == '\t' || json_[pos_] == '\n' ||
+            json_[pos_] == '\r')) {
+      pos_++;
+    }
+  }
+
+  // Skips whitespace and c, returns false if the next character is not c.
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (pos_ < json_.size() && json_[pos_] == c) {
+      pos_++;
+      return true;
+    }
+    return false;
+  }
+
+  bool AtEnd() {
+    SkipWhitespace();
+    return pos_ == json_.size();
+  }
+
+  bool ParseClaimValue(Claim* claim) {
+    SkipWhitespace();
+    claim->type = Type::OTHER;
+    claim->strings_begin = claim->strings_end = claims_.strings_.size();
+    if (pos_ == json_.size()) {
+      return false;
+    }
+    switch (json_[pos_]) {
+      case '"': {
+        absl::string_view value;
+        if (!ParseString(&value)) {
+          return false;
+        }
+        claims_.strings_.push_back(value);
+        claim->type = Type::STRING;
+        break;
+      }
+      case '[': {
+        size_t begin = pos_;
+        if (ParseStringArray()) {
+          claim->type = Type::STRING_ARRAY;
+          break;
+        }
+        // Not an array of strings, validate it as any value.
+        claims_.strings_.resize(claim->strings_begin);
+        pos_ = begin;
+        if (!SkipValue(0)) {
+          return false;
+        }
+        break;
+      }
+      default: {
+        size_t begin = pos_;
+        if (!SkipValue(0)) {
+          return false;
+        }
+        int64_t integer;
+        if (ParseInteger(json_.substr(begin, pos_ - begin), &integer)) {
+          claim->type = Type::INTEGER;
+          claim->integer = integer;
+        }
+        break;
+      }
+    }
+    claim->strings_end = claims_.strings_.size();
+    return true;
+  }
+
+  // Parses an array of strings, returns false if the array holds other values
+  // or is not valid.
+  bool ParseStringArray() {
+    if (!Consume('[')) {
+      return false;
+    }
+    if (Consume(']')) {
+      return true;
+    }
+    do {
+      absl::string_view value;
+      if (!ParseString(&value)) {
+        return false;
+      }
+      claims_.strings_.push_back(value);
+    } while (Consume(','));
+    return Consume(']');
+  }
+
+  bool SkipValue(int depth) {
+    if (depth > kMaxDepth) {
+      return false;
+    }
+    SkipWhitespace();
+    if (pos_ == json_.size()) {
+      return false;
+    }
+    switch (json_[pos_]) {
+      case '"': {
+        absl::string_view value;
+        return ParseString(&value);
+      }
+      case '[':
+        pos_++;
+        if (Consume(']')) {
+          return true;
+        }
+        do {
+          if (!SkipValue(depth + 1)) {
+            return false;
+          }
+        } while (Consume(','));
+        return Consume(']');
+      case '{':
+        pos_++;
+        if (Consume('}')) {
+          return true;
+        }
+        do {
+          absl::string_view name;
+          if (!ParseString(&name) || !Consume(':') || !SkipValue(depth + 1)) {
+            return false;
+          }
+        } while (Consume(','));
+        return Consume('}');
+      case 't':
+        return SkipLiteral("true");
+      case 'f':
+        return SkipLiteral("false");
+      case 'n':
+        return SkipLiteral("null");
+      default:
+        return SkipNumber();
+    }
+  }
+
+  bool SkipLiteral(absl::string_view literal) {
+    if (json_.substr(pos_, literal.size()) != literal) {
+      return false;
+    }
+    pos_ += literal.size();
+    return true;
+  }
+
+  bool SkipDigits() {
+    size_t begin = pos_;
+    while (pos_ < json_.size() && json_[pos_] >= '0' && json_[pos_] <= '9') {
+      pos_++;
+    }
+    return pos_ > begin;
+  }
+
+  bool SkipNumber() {
+    if (pos_ < json_.size() && json_[pos_] == '-') {
+      pos_++;
+    }
+    if (pos_ < json_.size() && json_[pos_] == '0') {
+      pos_++;
+    } else if (!SkipDigits()) {
+      return false;
+    }
+    if (pos_ < json_.size() && json_[pos_] == '.') {
+      pos_++;
+      if (!SkipDigits()) {
+        return false;
+      }
+    }
+    if (pos_ < json_.size() && (json_[pos_] == 'e' || json_[pos_] == 'E')) {
+      pos_++;
+      if (pos_ < json_.size() && (json_[pos_] == '+' || json_[pos_] == '-')) {
+        pos_++;
+      }
+      if (!SkipDigits()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Converts a valid JSON number without fraction and exponent.
+  static bool ParseInteger(absl::string_view number, int64_t* value) {
+    bool negative = !number.empty() && number[0] == '-';
+    if (negative) {
+      number.remove_prefix(1);
+    }
+    uint64_t limit = negative
+                         ? uint64_t(std::numeric_limits<int64_t>::max()) + 1
+                         : std::numeric_limits<int64_t>::max();
+    uint64_t result = 0;
+    for (char c : number) {
+      if (c < '0' || c > '9' || result > (limit - (c - '0')) / 10) {
+        return false;
+      }
+      result = result * 10 + (c - '0');
+    }
+    *value = negative ? -static_cast<int64_t>(result - 1) - 1 : result;
+    return true;
+  }
+
+  // Parses a string at the current position. The result points into the JSON
+  // unless the string has escape sequences.
+  bool ParseString(absl::string_view* value) {
+    if (!Consume('"')) {
+      return false;
+    }
+    size_t begin = pos_;
+    while (pos_ < json_.size() && json_[pos_] != '"' && json_[pos_] != '\\') {
+      if (static_cast<unsigned char>(json_[pos_]) < 0x20) {
+        return false;
+      }
+      pos_++;
+    }
+    if (pos_ == json_.size()) {
+      return false;
+    }
+    if (json_[pos_] == '"') {
+      *value = json_.substr(begin, pos_ - begin);
+      pos_++;
+      return true;
+    }
+
+    std::string unescaped(json_.substr(begin, pos_ - begin));
+    while (pos_ < json_.size() && json_[pos_] != '"') {
+      char c = json_[pos_++];
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return false;
+      }
+      if (c != '\\') {
+        unescaped.push_back(c);
+        continue;
+      }
+      if (pos_ == json_.size()) {
+        return false;
+      }
+      switch (json_[pos_++]) {
+        case '"':
+          unescaped.push_back('"');
+          break;
+        case '\\':
+          unescaped.push_back('\\');
+          break;
+        case '/':
+          unescaped.push_back('/');
+          break;
+        case 'b':
+          unescaped.push_back('\b');
+          break;
+        case 'f':
+          unescaped.push_back('\f');
+          break;
+        case 'n':
+          unescaped.push_back('\n');
+          break;
+        case 'r':
+          unescaped.push_back('\r');
+          break;
+        case 't':
+          unescaped.push_back('\t');
+          break;
+        case 'u': {
+          uint32_t code_point;
+          if (!ParseHex4(&code_point)) {
+            return false;
+          }
+          if (code_point >= 0xD800 && code_point < 0xDC00) {
+            // A high surrogate has to be followed by a low one.
+            uint32_t low;
+            if (!SkipLiteral("\\u") || !ParseHex4(&low) || low < 0xDC00 ||
+                low >= 0xE000) {
+              return false;
+            }
+            code_point =
+                0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+          } else if (code_point >= 0xDC00 && code_point < 0xE000) {
+            return false;
+          }
+          AppendUtf8(code_point, &unescaped);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+    if (pos_ == json_.size()) {
+      return false;
+    }
+    pos_++;
+    claims_.unescaped_.push_back(std::move(unescaped));
+    *value = claims_.unescaped_.back();
+    return true;
+  }
+
+  bool ParseHex4(uint32_t* value) {
+    if (json_.size() - pos_ < 4) {
+      return false;
+    }
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+      int digit = HexDigit(json_[pos_++]);
+      if (digit < 0) {
+        return false;
+      }
+      *value = (*value << 4) | digit;
+    }
+    return true;
+  }
+
+  JwtClaims& claims_;
+  const absl::string_view json_;
+  size_t pos_ = 0;
+};
+
+bool JwtClaims::Parse(std::string json) {
+  json_ = std::move(json);
+  claims_.clear();
+  strings_.clear();
+  unescaped_.clear();
+  return Parser(*this).ParseObject();
+}
+
+const JwtClaims::Claim* JwtClaims::Find(absl::string_view name) const {
+  for (const Claim& claim : claims_) {
+    if (claim.name == name) {
+      return &claim;
+    }
+  }
+  return nullptr;
+}
+
+const std::string& VerifiedJwtClaims::key() {
+  CONSTRUCT_ON_FIRST_USE(std::string, "istio.jwt_auth.verified_claims");
+}
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,113 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "envoy/stream_info/filter_state.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+
+// The top-level claims of a JWT payload, extracted in a single pass over the
+// JSON without building a DOM. Strings are views into the JSON, only strings
+// with escape sequences are copied.
+//
+// Usage example:
+//   JwtClaims claims;
+//   if (claims.Parse(payload_json)) {
+//     const JwtClaims::Claim* iss = claims.Find("iss");
+//     ...
+//   }
+class JwtClaims {
+ public:
+  enum class Type {
+    // A string, with one item in Strings().
+    STRING,
+    // An array of strings, possibly empty.
+    STRING_ARRAY,
+    // An integral number which fits in int64_t.
+    INTEGER,
+    // Any other value, only checked to be valid JSON.
+    OTHER,
+  };
+
+  struct Claim {
+    absl::string_view name;
+    Type type;
+    // The value of an INTEGER claim.
+    int64_t integer;
+    // The range of the values of a STRING or STRING_ARRAY claim in strings_.
+    size_t strings_begin;
+    size_t strings_end;
+  };
+
+  JwtClaims() {}
+  // The claims point into the object.
+  JwtClaims(const JwtClaims&) = delete;
+  JwtClaims& operator=(const JwtClaims&) = delete;
+
+  // Parses json, which has to be a JSON object, and replaces the claims
+  // parsed before. Returns false if json is not a valid JSON object.
+  bool Parse(std::string json);
+
+  // The parsed JSON.
+  const std::string& json() const { return json_; }
+
+  // All claims, in the order of the JSON.
+  const std::vector<Claim>& claims() const { return claims_; }
+
+  // Returns the first claim with the given name, or nullptr.
+  const Claim* Find(absl::string_view name) const;
+
+  // The values of a STRING or STRING_ARRAY claim.
+  absl::Span<const absl::string_view> Strings(const Claim& claim) const {
+    return absl::MakeConstSpan(strings_.data() + claim.strings_begin,
+                               claim.strings_end - claim.strings_begin);
+  }
+
+ private:
+  class Parser;
+
+  std::string json_;
+  std::vector<Claim> claims_;
+  std::vector<absl::string_view> strings_;
+  // Unescaped copies of strings with escape sequences.
+  std::deque<std::string> unescaped_;
+};
+
+typedef std::shared_ptr<const JwtClaims> JwtClaimsConstSharedPtr;
+
+// The claims of the JWTs verified for a request, keyed by issuer. The jwt_auth
+// filter keeps them in the filter state, so the authn filter does not need to
+// parse the payloads again.
+class VerifiedJwtClaims : public StreamInfo::FilterState::Object {
+ public:
+  static const std::string& key();
+
+  std::map<std::string, JwtClaimsConstSharedPtr> by_issuer;
+};
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,113 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/jwt_auth/jwt_claims.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+namespace {
+
+TEST(JwtClaimsTest, TestClaimTypes) {
+  JwtClaims claims;
+  ASSERT_TRUE(claims.Parse(R"(
+    {
+      "iss": "https://example.com",
+      "aud": ["aud1", "aud2"],
+      "exp": 1501281058,
+      "nbf": 1.5e9,
+      "empty": [],
+      "mixed": [1, "a"],
+      "nested": {"a": [1, {"b": null}], "c": true}
+    }
+  )"));
+  ASSERT_EQ(claims.claims().size(), 7);
+
+  const JwtClaims::Claim* iss = claims.Find("iss");
+  ASSERT_TRUE(iss);
+  EXPECT_EQ(iss->type, JwtClaims::Type::STRING);
+  EXPECT_EQ(claims.Strings(*iss)[0], "https://example.com");
+
+  const JwtClaims::Claim* aud = claims.Find("aud");
+  ASSERT_TRUE(aud);
+  EXPECT_EQ(aud->type, JwtClaims::Type::STRING_ARRAY);
+  ASSERT_EQ(claims.Strings(*aud).size(), 2);
+  EXPECT_EQ(claims.Strings(*aud)[1], "aud2");
+
+  const JwtClaims::Claim* exp = claims.Find("exp");
+  ASSERT_TRUE(exp);
+  EXPECT_EQ(exp->type, JwtClaims::Type::INTEGER);
+  EXPECT_EQ(exp->integer, 1501281058);
+
+  EXPECT_EQ(claims.Find("nbf")->type, JwtClaims::Type::OTHER);
+  EXPECT_EQ(claims.Find("empty")->type, JwtClaims::Type::STRING_ARRAY);
+  EXPECT_EQ(claims.Strings(*claims.Find("empty")).size(), 0);
+  EXPECT_EQ(claims.Find("mixed")->type, JwtClaims::Type::OTHER);
+  EXPECT_EQ(claims.Find("nested")->type, JwtClaims::Type::OTHER);
+  EXPECT_FALSE(claims.Find("sub"));
+}
+
+TEST(JwtClaimsTest, TestIntegerRange) {
+  JwtClaims claims;
+  ASSERT_TRUE(claims.Parse(
+      R"({"min": -9223372036854775808, "over": 9223372036854775808})"));
+  EXPECT_EQ(claims.Find("min")->type, JwtClaims::Type::INTEGER);
+  EXPECT_EQ(claims.Find("min")->integer, INT64_MIN);
+  EXPECT_EQ(claims.Find("over")->type, JwtClaims::Type::OTHER);
+}
+
+TEST(JwtClaimsTest, TestEscapes) {
+  JwtClaims claims;
+  ASSERT_TRUE(claims.Parse(
+      R"({"s\/b": "a\"b\\c\né😀", "plain": "x"})"));
+  const JwtClaims::Claim* sub = claims.Find("s/b");
+  ASSERT_TRUE(sub);
+  EXPECT_EQ(claims.Strings(*sub)[0], "a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80");
+
+  // Strings without escapes point into the JSON.
+  absl::string_view plain = claims.Strings(*claims.Find("plain"))[0];
+  EXPECT_GE(plain.data(), claims.json().data());
+  EXPECT_LT(plain.data(), claims.json().data() + claims.json().size());
+}
+
+TEST(JwtClaimsTest, TestReparse) {
+  JwtClaims claims;
+  ASSERT_TRUE(claims.Parse(R"({"iss": "a", "sub": "b"})"));
+  ASSERT_TRUE(claims.Parse("{}"));
+  EXPECT_TRUE(claims.claims().empty());
+  EXPECT_EQ(claims.json(), "{}");
+}
+
+TEST(JwtClaimsTest, TestInvalidJson) {
+  JwtClaims claims;
+  for (const char* json :
+       {"", "foobar", "[]", "\"iss\"", "{", R"({"a"})", R"({"a":})",
+        R"({"a":1,})", R"({"a":01})", R"({"a":1.})", R"({"a":-})",
+        R"({"a":tru})", R"({"a":[1,]})", R"({"a":1} {})", R"({"a":"\x"})",
+        R"({"a":"\ud800"})", "{\"a\":\"x\ty\"}"}) {
+    EXPECT_FALSE(claims.Parse(json)) << json;
+  }
+
+  // Nesting is limited.
+  EXPECT_FALSE(claims.Parse("{\"a\":" + std::string(100, '[') +
+                            std::string(100, ']') + "}"));
+}
+
+}  // namespace
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
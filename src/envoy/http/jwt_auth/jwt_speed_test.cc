@@ -0,0 +1,150 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "common/common/base64.h"
+#include "openssl/bn.h"
+#include "openssl/rsa.h"
+#include "src/envoy/http/jwt_auth/jwt.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+namespace {
+
+// Largest JWKS in the benchmarks, as seen while several keys are rotated.
+constexpr int kMaxKeys = 16;
+
+std::string Base64UrlEncode(const std::string& str) {
+  return Base64Url::encode(str.data(), str.size());
+}
+
+std::string BigNumToBase64Url(const BIGNUM* bn) {
+  std::string bytes(BN_num_bytes(bn), '\0');
+  BN_bn2bin(bn, reinterpret_cast<uint8_t*>(&bytes[0]));
+  return Base64UrlEncode(bytes);
+}
+
+// RSA keys shared by all benchmarks, generating them is slow.
+const std::vector<bssl::UniquePtr<EVP_PKEY>>& Keys() {
+  static auto* keys = [] {
+    auto* keys = new std::vector<bssl::UniquePtr<EVP_PKEY>>();
+    bssl::UniquePtr<BIGNUM> e(BN_new());
+    BN_set_word(e.get(), RSA_F4);
+    for (int i = 0; i < kMaxKeys; i++) {
+      bssl::UniquePtr<RSA> rsa(RSA_new());
+      RSA_generate_key_ex(rsa.get(), 2048, e.get(), nullptr);
+      keys->emplace_back(EVP_PKEY_new());
+      EVP_PKEY_set1_RSA(keys->back().get(), rsa.get());
+    }
+    return keys;
+  }();
+  return *keys;
+}
+
+// Returns a JWKS with the first num_keys keys, with "kid" set to their index.
+std::string Jwks(int num_keys) {
+  std::string jwks = "{\"keys\": [";
+  for (int i = 0; i < num_keys; i++) {
+    const RSA* rsa = EVP_PKEY_get0_RSA(Keys()[i].get());
+    const BIGNUM *n, *e;
+    RSA_get0_key(rsa, &n, &e, nullptr);
+    if (i > 0) {
+      jwks += ",";
+    }
+    jwks += "{\"kty\": \"RSA\", \"alg\": \"RS256\", \"kid\": \"" +
+            std::to_string(i) + "\", \"n\": \"" + BigNumToBase64Url(n) +
+            "\", \"e\": \"" + BigNumToBase64Url(e) + "\"}";
+  }
+  return jwks + "]}";
+}
+
+// Returns a JWT signed by the key with the given index.
+std::string SignedJwt(int key, bool with_kid) {
+  std::string header = "{\"alg\": \"RS256\"";
+  if (with_kid) {
+    header += ", \"kid\": \"" + std::to_string(key) + "\"";
+  }
+  header += "}";
+  std::string signed_data =
+      Base64UrlEncode(header) + "." +
+      Base64UrlEncode(
+          "{\"iss\": \"https://example.com\", \"sub\": \"test@example.com\"}");
+
+  bssl::UniquePtr<EVP_MD_CTX> md_ctx(EVP_MD_CTX_create());
+  size_t signature_len;
+  EVP_DigestSignInit(md_ctx.get(), nullptr, EVP_sha256(), nullptr,
+                     Keys()[key].get());
+  EVP_DigestSignUpdate(md_ctx.get(), signed_data.data(), signed_data.size());
+  EVP_DigestSignFinal(md_ctx.get(), nullptr, &signature_len);
+  std::string signature(signature_len, '\0');
+  EVP_DigestSignFinal(md_ctx.get(), reinterpret_cast<uint8_t*>(&signature[0]),
+                      &signature_len);
+  signature.resize(signature_len);
+  return signed_data + "." + Base64UrlEncode(signature);
+}
+
+}  // namespace
+
+// Verifies a JWT signed by the last key of a JWKS with range(0) keys. The JWT
+// has a "kid" if range(1) is set, otherwise every key is tried in turn.
+static void BM_VerifyJwks(benchmark::State& state) {
+  int num_keys = state.range(0);
+  auto pubkeys = Pubkeys::CreateFrom(Jwks(num_keys), Pubkeys::JWKS);
+  Jwt jwt(SignedJwt(num_keys - 1, state.range(1)));
+  for (auto _ : state) {
+    Verifier v;
+    if (!v.Verify(jwt, *pubkeys)) {
+      state.SkipWithError(StatusToString(v.GetStatus()).c_str());
+      break;
+    }
+  }
+}
+BENCHMARK(BM_VerifyJwks)->RangeMultiplier(4)->Ranges({{1, kMaxKeys}, {0, 1}});
+
+// A JWT whose "kid" is not in the JWKS is rejected without verifying.
+static void BM_VerifyJwksUnknownKid(benchmark::State& state) {
+  auto pubkeys = Pubkeys::CreateFrom(Jwks(state.range(0)), Pubkeys::JWKS);
+  Jwt jwt(SignedJwt(kMaxKeys - 1, true));
+  for (auto _ : state) {
+    Verifier v;
+    benchmark::DoNotOptimize(v.Verify(jwt, *pubkeys));
+  }
+}
+BENCHMARK(BM_VerifyJwksUnknownKid)->RangeMultiplier(4)->Range(1, kMaxKeys / 2);
+
+// Parsing a JWT extracts the claims without building JSON objects.
+static void BM_ParseJwt(benchmark::State& state) {
+  std::string token = SignedJwt(0, true);
+  for (auto _ : state) {
+    Jwt jwt(token);
+    benchmark::DoNotOptimize(jwt.Exp());
+  }
+}
+BENCHMARK(BM_ParseJwt);
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs
+// them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 #include <unordered_map>
 
 #include "common/common/logger.h"
@@ -62,6 +63,41 @@ std::string ReadDataStore(
 
 }  // namespace
 
+// Extract host and path from a URI
+inline void ExtractUriHostPath(const std::string& uri, std::string* host,
+                               std::string* path) {
+  // Example:
+  // uri  = "https://example.com/certs"
+  // pos  :          ^
+  // pos1 :                     ^
+  // host = "example.com"
+  // path = "/certs"
+  auto pos = uri.find("://");
+  pos = pos == std::string::npos ? 0 : pos + 3;  // Start position of host
+  auto pos1 = uri.find("/", pos);
+  if (pos1 == std::string::npos) {
+    // If uri doesn't have "/", the whole string is treated as host.
+    *host = uri.substr(pos);
+    *path = "/";
+  } else {
+    *host = uri.substr(pos, pos1 - pos);
+    *path = "/" + uri.substr(pos1 + 1);
+  }
+}
+
+// Get how long fetched remote JWKS are used for an issuer.
+inline std::chrono::steady_clock::duration RemoteJwksCacheDuration(
+    const ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::JwtRule&
+        jwt_config) {
+  if (jwt_config.has_remote_jwks() &&
+      jwt_config.remote_jwks().has_cache_duration()) {
+    const auto& duration = jwt_config.remote_jwks().cache_duration();
+    return std::chrono::seconds(duration.seconds()) +
+           std::chrono::nanoseconds(duration.nanos());
+  }
+  return std::chrono::seconds(kPubkeyCacheExpirationSec);
+}
+
 // Struct to hold an issuer cache item.
 class PubkeyCacheItem : public Logger::Loggable<Logger::Id::filter> {
  public:
@@ -104,6 +140,13 @@ class PubkeyCacheItem : public Logger::Loggable<Logger::Id::filter> {
   // Get the pubkey object.
   const Pubkeys* pubkey() const { return pubkey_.get(); }
 
+  // Get the pubkey object to use it on other threads.
+  std::shared_ptr<const Pubkeys> shared_pubkey() const { return pubkey_; }
+
+  // Get the version of the pubkey object, it changes whenever the pubkey is
+  // replaced.
+  uint64_t pubkey_version() const { return pubkey_version_; }
+
   // Check if an audience is allowed.
   bool IsAudienceAllowed(const std::vector<std::string>& jwt_audiences) {
     if (audiences_.empty()) {
@@ -121,19 +164,22 @@ class PubkeyCacheItem : public Logger::Loggable<Logger::Id::filter> {
     return SetKey(pubkey_str, GetRemoteJwksExpirationTime());
   }
 
+  // Set remote JWKS parsed elsewhere, i.e. by the JwksRefresher. It passes
+  // the same object while the JWKS is unchanged, which only renews the
+  // expiration so the tokens verified with it stay cached.
+  void SetRemotePubkeys(std::shared_ptr<const Pubkeys> pubkey) {
+    if (pubkey != pubkey_) {
+      pubkey_ = std::move(pubkey);
+      pubkey_version_++;
+    }
+    expiration_time_ = GetRemoteJwksExpirationTime();
+  }
+
  private:
   // Get the expiration time for remote JWKS
   std::chrono::steady_clock::time_point GetRemoteJwksExpirationTime() const {
-    auto expire = std::chrono::steady_clock::now();
-    if (jwt_config_.has_remote_jwks() &&
-        jwt_config_.remote_jwks().has_cache_duration()) {
-      const auto& duration = jwt_config_.remote_jwks().cache_duration();
-      expire += std::chrono::seconds(duration.seconds()) +
-                std::chrono::nanoseconds(duration.nanos());
-    } else {
-      expire += std::chrono::seconds(kPubkeyCacheExpirationSec);
-    }
-    return expire;
+    return std::chrono::steady_clock::now() +
+           RemoteJwksCacheDuration(jwt_config_);
   }
 
   // Set a pubkey as string.
@@ -144,6 +190,7 @@ class PubkeyCacheItem : public Logger::Loggable<Logger::Id::filter> {
       return pubkey->GetStatus();
     }
     pubkey_ = std::move(pubkey);
+    pubkey_version_++;
     expiration_time_ = expire;
     return Status::OK;
   }
@@ -179,8 +226,10 @@ class PubkeyCacheItem : public Logger::Loggable<Logger::Id::filter> {
       jwt_config_;
   // Use set for fast lookup
   std::set<std::string> audiences_;
-  // The generated pubkey object.
-  std::unique_ptr<Pubkeys> pubkey_;
+  // The generated pubkey object, it may be shared with other threads.
+  std::shared_ptr<const Pubkeys> pubkey_;
+  // The number of times pubkey_ was set.
+  uint64_t pubkey_version_{0};
   // The pubkey expiration time.
   std::chrono::steady_clock::time_point expiration_time_;
 };
@@ -0,0 +1,86 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "include/istio/utils/simple_lru_cache.h"
+#include "include/istio/utils/simple_lru_cache_inl.h"
+#include "openssl/sha.h"
+#include "src/envoy/http/jwt_auth/jwt_claims.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+
+// What is needed to accept a verified JWT again without verifying it.
+struct VerifiedToken {
+  // The "iss" claim.
+  std::string issuer;
+  // The claims of the decoded payload JSON.
+  JwtClaimsConstSharedPtr payload;
+  // The "exp" claim, in seconds since the epoch.
+  int64_t exp;
+  // The pubkey version of the issuer the signature was verified with.
+  uint64_t pubkey_version;
+};
+
+// A bounded LRU cache of verified JWTs keyed by the SHA256 digest of the
+// token, so the signature of a token is only verified once while the token
+// and the keys of its issuer stay valid. It is per-thread like JwtAuthStore
+// and not thread-safe.
+class TokenCache {
+ public:
+  TokenCache(int64_t max_entries) : cache_(new LRUCache(max_entries)) {}
+
+  ~TokenCache() { cache_->RemoveAll(); }
+
+  // Get the key of a token.
+  static std::string Digest(const std::string& token) {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const uint8_t*>(token.data()), token.size(),
+           digest);
+    return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+  }
+
+  // Copy the entry of digest to token, return false if there is none.
+  bool Lookup(const std::string& digest, VerifiedToken* token) {
+    LRUCache::ScopedLookup lookup(cache_.get(), digest);
+    if (!lookup.Found()) {
+      return false;
+    }
+    *token = *lookup.value();
+    return true;
+  }
+
+  void Insert(const std::string& digest, const VerifiedToken& token) {
+    cache_->Insert(digest, new VerifiedToken(token), 1);
+  }
+
+  void Remove(const std::string& digest) { cache_->Remove(digest); }
+
+  // Get the number of cached tokens.
+  int64_t Size() const { return cache_->Size(); }
+
+ private:
+  using LRUCache = ::istio::utils::SimpleLRUCache<std::string, VerifiedToken>;
+  std::unique_ptr<LRUCache> cache_;
+};
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
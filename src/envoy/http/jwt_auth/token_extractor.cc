@@ -18,6 +18,7 @@
 #include "absl/strings/match.h"
 #include "common/common/utility.h"
 #include "common/http/utility.h"
+#include "src/envoy/utils/query_params.h"
 
 using ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::
     JwtAuthentication;
@@ -33,6 +34,35 @@ const std::string kBearerPrefix = "Bearer ";
 // The query parameter name to get JWT token.
 const std::string kParamAccessToken = "access_token";
 
+// The configured headers, with the issuers which specified them.
+typedef std::vector<
+    const std::pair<const LowerCaseString, std::set<std::string>> *>
+    HeaderList;
+
+// The first of the configured headers found in the request headers.
+struct HeaderMatch {
+  const HeaderList &headers;
+  // The index in headers of the header found, headers.size() if none.
+  size_t index;
+  const HeaderEntry *entry;
+};
+
+HeaderMap::Iterate MatchHeader(const HeaderEntry &header, void *context) {
+  auto *match = static_cast<HeaderMatch *>(context);
+  absl::string_view key = header.key().getStringView();
+  // Only the headers configured before the one already found are checked,
+  // so the first entry of a header is kept.
+  for (size_t i = 0; i < match->index; i++) {
+    if (key == match->headers[i]->first.get()) {
+      match->index = i;
+      match->entry = &header;
+      break;
+    }
+  }
+  return match->index == 0 ? HeaderMap::Iterate::Break
+                           : HeaderMap::Iterate::Continue;
+}
+
 }  // namespace
 
 JwtTokenExtractor::JwtTokenExtractor(const JwtAuthentication &config) {
@@ -61,11 +91,15 @@ JwtTokenExtractor::JwtTokenExtractor(const JwtAuthentication &config) {
       param_issuers.insert(jwt.issuer());
     }
   }
+  for (const auto &header_it : header_maps_) {
+    header_list_.push_back(&header_it);
+  }
 }
 
 void JwtTokenExtractor::Extract(
     const HeaderMap &headers,
-    std::vector<std::unique_ptr<JwtTokenExtractor::Token>> *tokens) const {
+    std::vector<std::unique_ptr<JwtTokenExtractor::Token>> *tokens,
+    StreamInfo::FilterState *filter_state) const {
   if (!authorization_issuers_.empty()) {
     const HeaderEntry *entry = headers.Authorization();
     if (entry) {
@@ -81,36 +115,45 @@ void JwtTokenExtractor::Extract(
     }
   }
 
-  // Check header first
-  for (const auto &header_it : header_maps_) {
-    const HeaderEntry *entry = headers.get(header_it.first);
-    if (entry) {
-      std::string token;
-      absl::string_view val = entry->value().getStringView();
-      size_t pos = val.find(' ');
-      if (pos != absl::string_view::npos) {
-        // If the header value has prefix, trim the prefix.
-        token = std::string(val.substr(pos + 1));
-      } else {
-        token = std::string(val);
-      }
-
-      tokens->emplace_back(
-          new Token(token, header_it.second, false, &header_it.first));
-      // Only take the first one.
-      return;
+  // Check header first, in one pass over the headers instead of a lookup per
+  // configured header.
+  HeaderMatch match{header_list_, header_list_.size(), nullptr};
+  if (!header_list_.empty()) {
+    headers.iterate(MatchHeader, &match);
+  }
+  if (match.entry) {
+    const auto &header_it = *header_list_[match.index];
+    std::string token;
+    absl::string_view val = match.entry->value().getStringView();
+    size_t pos = val.find(' ');
+    if (pos != absl::string_view::npos) {
+      // If the header value has prefix, trim the prefix.
+      token = std::string(val.substr(pos + 1));
+    } else {
+      token = std::string(val);
     }
+
+    tokens->emplace_back(
+        new Token(token, header_it.second, false, &header_it.first));
+    // Only take the first one.
+    return;
   }
 
   if (param_maps_.empty() || headers.Path() == nullptr) {
     return;
   }
 
-  const auto &params = Utility::parseQueryString(
-      std::string(headers.Path()->value().getStringView()));
+  absl::string_view path = headers.Path()->value().getStringView();
+  Utility::QueryParams parsed_params;
+  const Utility::QueryParams *params = &parsed_params;
+  if (filter_state != nullptr) {
+    params = &Utils::QueryParams::get(path, *filter_state);
+  } else {
+    parsed_params = Utility::parseQueryString(path);
+  }
   for (const auto &param_it : param_maps_) {
-    const auto &it = params.find(param_it.first);
-    if (it != params.end()) {
+    const auto &it = params->find(param_it.first);
+    if (it != params->end()) {
       tokens->emplace_back(
           new Token(it->second, param_it.second, false, nullptr));
       // Only take the first one.
@@ -18,6 +18,7 @@
 #include "common/common/logger.h"
 #include "envoy/config/filter/http/jwt_auth/v2alpha1/config.pb.h"
 #include "envoy/http/header_map.h"
+#include "envoy/stream_info/filter_state.h"
 
 namespace Envoy {
 namespace Http {
@@ -79,8 +80,11 @@ class JwtTokenExtractor : public Logger::Loggable<Logger::Id::filter> {
 
   // Return the extracted JWT tokens.
   // Only extract one token for now.
+  // If filter_state is given, the query parameters are shared with the other
+  // filters through it.
   void Extract(const HeaderMap& headers,
-               std::vector<std::unique_ptr<Token>>* tokens) const;
+               std::vector<std::unique_ptr<Token>>* tokens,
+               StreamInfo::FilterState* filter_state = nullptr) const;
 
  private:
   struct LowerCaseStringCmp {
@@ -90,8 +94,12 @@ class JwtTokenExtractor : public Logger::Loggable<Logger::Id::filter> {
     }
   };
   // The map of header to set of issuers
-  std::map<LowerCaseString, std::set<std::string>, LowerCaseStringCmp>
-      header_maps_;
+  typedef std::map<LowerCaseString, std::set<std::string>, LowerCaseStringCmp>
+      HeaderMaps;
+  HeaderMaps header_maps_;
+  // The entries of header_maps_ in order, to find them in one pass over the
+  // request headers.
+  std::vector<const HeaderMaps::value_type*> header_list_;
   // The map of parameters to set of issuers.
   std::map<std::string, std::set<std::string>> param_maps_;
   // Special handling of Authorization header.
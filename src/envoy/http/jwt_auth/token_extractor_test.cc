@@ -15,7 +15,9 @@
 
 #include "src/envoy/http/jwt_auth/token_extractor.h"
 
+#include "common/stream_info/filter_state_impl.h"
 #include "gtest/gtest.h"
+#include "src/envoy/utils/query_params.h"
 #include "test/test_common/utility.h"
 
 using ::istio::envoy::config::filter::http::jwt_auth::v2alpha1::
@@ -64,6 +66,30 @@ const char kExampleConfig[] = R"(
 }
 )";
 
+// A config with two custom headers.
+const char kTwoHeadersConfig[] = R"(
+{
+   "rules": [
+      {
+         "issuer": "issuer1",
+         "from_headers": [
+             {
+                "name": "token-header-b"
+             }
+         ]
+      },
+      {
+         "issuer": "issuer2",
+         "from_headers": [
+             {
+                "name": "token-header-a"
+             }
+         ]
+      }
+   ]
+}
+)";
+
 }  //  namespace
 
 class JwtTokenExtractorTest : public ::testing::Test {
@@ -185,6 +211,46 @@ TEST_F(JwtTokenExtractorTest, TestMultipleTokens) {
   EXPECT_EQ(tokens[0]->token(), "header_token");
 }
 
+TEST_F(JwtTokenExtractorTest, TestCustomHeadersOrder) {
+  SetupConfig(kTwoHeadersConfig);
+  // The headers are checked in the order of their names, whatever their
+  // order in the request.
+  auto headers = TestHeaderMapImpl{{"token-header-b", "token_b"},
+                                   {"token-header-a", "token_a"},
+                                   {"token-header-a", "token_a2"}};
+  std::vector<std::unique_ptr<JwtTokenExtractor::Token>> tokens;
+  extractor_->Extract(headers, &tokens);
+  EXPECT_EQ(tokens.size(), 1);
+  EXPECT_EQ(tokens[0]->token(), "token_a");
+  EXPECT_TRUE(tokens[0]->IsIssuerAllowed("issuer2"));
+  EXPECT_FALSE(tokens[0]->IsIssuerAllowed("issuer1"));
+
+  headers = TestHeaderMapImpl{{"other-header", "other"},
+                              {"token-header-b", "token_b"}};
+  tokens.clear();
+  extractor_->Extract(headers, &tokens);
+  EXPECT_EQ(tokens.size(), 1);
+  EXPECT_EQ(tokens[0]->token(), "token_b");
+  EXPECT_TRUE(tokens[0]->IsIssuerAllowed("issuer1"));
+}
+
+TEST_F(JwtTokenExtractorTest, TestParamTokenSharesQueryParams) {
+  auto headers = TestHeaderMapImpl{{":path", "/path?token_param=jwt_token"}};
+  StreamInfo::FilterStateImpl filter_state;
+  std::vector<std::unique_ptr<JwtTokenExtractor::Token>> tokens;
+  extractor_->Extract(headers, &tokens, &filter_state);
+  EXPECT_EQ(tokens.size(), 1);
+  EXPECT_EQ(tokens[0]->token(), "jwt_token");
+
+  // The parsed query parameters are saved for the other filters.
+  EXPECT_TRUE(filter_state.hasData<Utils::QueryParams>(
+      Utils::QueryParams::key()));
+  EXPECT_EQ(
+      Utils::QueryParams::get("/path?token_param=jwt_token", filter_state)
+          .at("token_param"),
+      "jwt_token");
+}
+
 }  // namespace JwtAuth
 }  // namespace Http
 }  // namespace Envoy
@@ -0,0 +1,85 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/jwt_auth/verify_pool.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+
+VerifyPool::VerifyPool(Thread::ThreadFactory& thread_factory,
+                       size_t num_threads, size_t max_queued)
+    : max_queued_(max_queued) {
+  for (size_t i = 0; i < num_threads; i++) {
+    threads_.push_back(thread_factory.createThread([this]() { Run(); }));
+  }
+}
+
+VerifyPool::~VerifyPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+    queue_.clear();
+  }
+  cond_.notify_all();
+  for (auto& thread : threads_) {
+    thread->join();
+  }
+}
+
+bool VerifyPool::Verify(std::shared_ptr<const Jwt> jwt,
+                        std::shared_ptr<const Pubkeys> pubkeys,
+                        Event::Dispatcher& dispatcher, DoneCb done) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (threads_.empty() || queue_.size() >= max_queued_) {
+      ENVOY_LOG(debug, "Jwt verify queue is full, verifying inline");
+      return false;
+    }
+    queue_.push_back(
+        Job{std::move(jwt), std::move(pubkeys), &dispatcher, std::move(done)});
+  }
+  cond_.notify_one();
+  return true;
+}
+
+void VerifyPool::Run() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return shutdown_ || !queue_.empty(); });
+      if (shutdown_) {
+        return;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    Verifier verifier;
+    Status status = verifier.Verify(*job.jwt, *job.pubkeys)
+                        ? Status::OK
+                        : verifier.GetStatus();
+    // The token and keys are released here, only the result goes back.
+    job.jwt.reset();
+    job.pubkeys.reset();
+    job.dispatcher->post(
+        [done = std::move(job.done), status]() { done(status); });
+  }
+}
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
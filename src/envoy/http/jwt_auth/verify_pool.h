@@ -0,0 +1,82 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/common/logger.h"
+#include "envoy/event/dispatcher.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/thread/thread.h"
+#include "src/envoy/http/jwt_auth/jwt.h"
+
+namespace Envoy {
+namespace Http {
+namespace JwtAuth {
+
+// A small pool of threads verifying JWT signatures off the worker threads,
+// so a burst of tokens signed with large keys doesn't stall the other
+// streams of a worker. The result is posted back to the dispatcher of the
+// worker which asked for it. One pool is shared by the whole process.
+class VerifyPool : public Singleton::Instance,
+                   public Logger::Loggable<Logger::Id::filter> {
+ public:
+  // Called on the worker thread with Status::OK if the signature is valid,
+  // otherwise with the failure reason.
+  using DoneCb = std::function<void(Status status)>;
+
+  // At most max_queued verifications wait for a thread, Verify() fails when
+  // more are queued.
+  VerifyPool(Thread::ThreadFactory& thread_factory, size_t num_threads,
+             size_t max_queued);
+  // Drops the queued verifications and waits for the running ones.
+  ~VerifyPool();
+
+  // Queues the verification of jwt with pubkeys. Returns false, without
+  // calling done, if the queue is full, then the caller verifies inline.
+  bool Verify(std::shared_ptr<const Jwt> jwt,
+              std::shared_ptr<const Pubkeys> pubkeys,
+              Event::Dispatcher& dispatcher, DoneCb done);
+
+ private:
+  struct Job {
+    std::shared_ptr<const Jwt> jwt;
+    std::shared_ptr<const Pubkeys> pubkeys;
+    Event::Dispatcher* dispatcher{};
+    DoneCb done;
+  };
+
+  // The loop of each thread.
+  void Run();
+
+  const size_t max_queued_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Job> queue_;
+  bool shutdown_{false};
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
+typedef std::shared_ptr<VerifyPool> VerifyPoolSharedPtr;
+
+}  // namespace JwtAuth
+}  // namespace Http
+}  // namespace Envoy
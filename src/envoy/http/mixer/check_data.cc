@@ -20,7 +20,9 @@
 #include "src/envoy/http/jwt_auth/jwt.h"
 #include "src/envoy/http/jwt_auth/jwt_authenticator.h"
 #include "src/envoy/utils/authn.h"
+#include "src/envoy/utils/connection_identity.h"
 #include "src/envoy/utils/header_update.h"
+#include "src/envoy/utils/query_params.h"
 #include "src/envoy/utils/utils.h"
 
 using HttpCheckData = ::istio::control::http::CheckData;
@@ -33,20 +35,109 @@ namespace {
 const LowerCaseString kRefererHeaderKey("referer");
 
 // Set of headers excluded from request.headers attribute.
-const std::set<std::string> RequestHeaderExclusives = {
+const Utils::HeaderSet RequestHeaderExclusives = {
     Utils::HeaderUpdate::IstioAttributeHeader().get(),
 };
 
+// request.headers read from the header map. As in Utils::ExtractHeaders(),
+// the last of repeated headers wins.
+class DeferredHeaders : public ::istio::utils::DeferredStringMap {
+ public:
+  DeferredHeaders(const HeaderMap& headers) : headers_(headers) {}
+
+  bool Find(const std::string& key, std::string* value) const override {
+    if (RequestHeaderExclusives.contains(key)) {
+      return false;
+    }
+    struct Context {
+      const std::string& key;
+      std::string* value;
+      bool found;
+    };
+    Context ctx{key, value, false};
+    headers_.iterate(
+        [](const HeaderEntry& header, void* context) -> HeaderMap::Iterate {
+          Context* ctx = static_cast<Context*>(context);
+          if (header.key().getStringView() == ctx->key) {
+            *ctx->value = std::string(header.value().getStringView());
+            ctx->found = true;
+          }
+          return HeaderMap::Iterate::Continue;
+        },
+        &ctx);
+    return ctx.found;
+  }
+
+  void Build(::istio::mixer::v1::Attributes_StringMap* map) const override {
+    Utils::ExtractHeaders(headers_, RequestHeaderExclusives, map);
+  }
+
+ private:
+  const HeaderMap& headers_;
+};
+
+// request.query_params shared through the filter state.
+class DeferredQueryParams : public ::istio::utils::DeferredStringMap {
+ public:
+  DeferredQueryParams(const HeaderMap& headers,
+                      StreamInfo::FilterState& filter_state)
+      : headers_(headers), filter_state_(filter_state) {}
+
+  bool Find(const std::string& key, std::string* value) const override {
+    const Utility::QueryParams* params = query_params();
+    if (params == nullptr) {
+      return false;
+    }
+    const auto it = params->find(key);
+    if (it == params->end()) {
+      return false;
+    }
+    *value = it->second;
+    return true;
+  }
+
+  void Build(::istio::mixer::v1::Attributes_StringMap* map) const override {
+    const Utility::QueryParams* params = query_params();
+    if (params != nullptr) {
+      map->mutable_entries()->insert(params->begin(), params->end());
+    }
+  }
+
+ private:
+  const Utility::QueryParams* query_params() const {
+    if (!headers_.Path()) {
+      return nullptr;
+    }
+    return &Utils::QueryParams::get(headers_.Path()->value().getStringView(),
+                                    filter_state_);
+  }
+
+  const HeaderMap& headers_;
+  StreamInfo::FilterState& filter_state_;
+};
+
 }  // namespace
 
 CheckData::CheckData(const HeaderMap& headers,
                      const envoy::api::v2::core::Metadata& metadata,
-                     const Network::Connection* connection)
-    : headers_(headers), metadata_(metadata), connection_(connection) {
-  if (headers_.Path()) {
-    query_params_ =
-        Utility::parseQueryString(headers_.Path()->value().getStringView());
+                     const Network::Connection* connection,
+                     StreamInfo::FilterState* filter_state)
+    : headers_(headers),
+      metadata_(metadata),
+      connection_(connection),
+      filter_state_(filter_state) {}
+
+const Utility::QueryParams& CheckData::query_params() const {
+  if (query_params_ == nullptr) {
+    absl::string_view path = headers_.Path()->value().getStringView();
+    if (filter_state_ != nullptr) {
+      query_params_ = &Utils::QueryParams::get(path, *filter_state_);
+    } else {
+      parsed_query_params_ = Utility::parseQueryString(path);
+      query_params_ = &parsed_query_params_;
+    }
   }
+  return *query_params_;
 }
 
 bool CheckData::ExtractIstioAttributes(std::string* data) const {
@@ -68,7 +159,8 @@ bool CheckData::GetSourceIpPort(std::string* ip, int* port) const {
 }
 
 bool CheckData::GetPrincipal(bool peer, std::string* user) const {
-  return Utils::GetPrincipal(connection_, peer, user);
+  return connection_ != nullptr &&
+         Utils::ConnectionIdentity::get(*connection_).principal(peer, user);
 }
 
 std::map<std::string, std::string> CheckData::GetRequestHeaders() const {
@@ -77,7 +169,15 @@ std::map<std::string, std::string> CheckData::GetRequestHeaders() const {
   return header_map;
 }
 
-bool CheckData::IsMutualTLS() const { return Utils::IsMutualTLS(connection_); }
+::istio::utils::DeferredStringMapPtr CheckData::GetDeferredRequestHeaders()
+    const {
+  return std::make_unique<DeferredHeaders>(headers_);
+}
+
+bool CheckData::IsMutualTLS() const {
+  return connection_ != nullptr &&
+         Utils::ConnectionIdentity::get(*connection_).mutualTLS();
+}
 
 bool CheckData::GetRequestedServerName(std::string* name) const {
   return Utils::GetRequestedServerName(connection_, name);
@@ -145,8 +245,12 @@ bool CheckData::FindHeaderByName(const std::string& name,
 
 bool CheckData::FindQueryParameter(const std::string& name,
                                    std::string* value) const {
-  const auto& it = query_params_.find(name);
-  if (it != query_params_.end()) {
+  if (!headers_.Path()) {
+    return false;
+  }
+  const auto& params = query_params();
+  const auto& it = params.find(name);
+  if (it != params.end()) {
     *value = it->second;
     return true;
   }
@@ -188,11 +292,18 @@ bool CheckData::GetRequestQueryParams(
   if (!headers_.Path()) {
     return false;
   }
-  *query_params =
-      Utility::parseQueryString(headers_.Path()->value().getStringView());
+  *query_params = query_params();
   return true;
 }
 
+::istio::utils::DeferredStringMapPtr CheckData::GetDeferredRequestQueryParams()
+    const {
+  if (filter_state_ == nullptr) {
+    return nullptr;
+  }
+  return std::make_unique<DeferredQueryParams>(headers_, *filter_state_);
+}
+
 }  // namespace Mixer
 }  // namespace Http
 }  // namespace Envoy
@@ -19,6 +19,7 @@
 #include "common/http/utility.h"
 #include "envoy/api/v2/core/base.pb.h"
 #include "envoy/http/header_map.h"
+#include "envoy/stream_info/filter_state.h"
 #include "google/protobuf/struct.pb.h"
 #include "include/istio/control/http/controller.h"
 #include "src/istio/authn/context.pb.h"
@@ -30,9 +31,12 @@ namespace Mixer {
 class CheckData : public ::istio::control::http::CheckData,
                   public Logger::Loggable<Logger::Id::filter> {
  public:
+  // The query parameters are parsed when first used, and shared with other
+  // filters through filter_state if it is given.
   CheckData(const HeaderMap& headers,
             const envoy::api::v2::core::Metadata& metadata,
-            const Network::Connection* connection);
+            const Network::Connection* connection,
+            StreamInfo::FilterState* filter_state = nullptr);
 
   // Find "x-istio-attributes" headers, if found base64 decode
   // its value and remove it from the headers.
@@ -44,6 +48,9 @@ class CheckData : public ::istio::control::http::CheckData,
 
   std::map<std::string, std::string> GetRequestHeaders() const override;
 
+  ::istio::utils::DeferredStringMapPtr GetDeferredRequestHeaders()
+      const override;
+
   bool IsMutualTLS() const override;
 
   bool GetRequestedServerName(std::string* name) const override;
@@ -67,11 +74,22 @@ class CheckData : public ::istio::control::http::CheckData,
   bool GetRequestQueryParams(
       std::map<std::string, std::string>* query_params) const override;
 
+  // Only deferred with a filter state, which outlives this object.
+  ::istio::utils::DeferredStringMapPtr GetDeferredRequestQueryParams()
+      const override;
+
  private:
+  // Returns the query parameters of the path, which must be present.
+  const Utility::QueryParams& query_params() const;
+
   const HeaderMap& headers_;
   const envoy::api::v2::core::Metadata& metadata_;
   const Network::Connection* connection_;
-  Utility::QueryParams query_params_;
+  StreamInfo::FilterState* filter_state_;
+  // Points to the parsed query parameters once they are needed.
+  mutable const Utility::QueryParams* query_params_{};
+  // The query parameters parsed here if there is no filter state.
+  mutable Utility::QueryParams parsed_query_params_;
 };
 
 }  // namespace Mixer
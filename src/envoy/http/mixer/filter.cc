@@ -24,7 +24,6 @@
 #include "src/envoy/utils/header_update.h"
 
 using ::google::protobuf::util::Status;
-using ::istio::mixer::v1::RouteDirective;
 using ::istio::mixerclient::CheckResponseInfo;
 
 namespace Envoy {
@@ -50,13 +49,12 @@ Filter::Filter(Control& control)
 void Filter::ReadPerRouteConfig(
     const PerRouteServiceConfig& route_cfg,
     ::istio::control::http::Controller::PerRouteConfig* config) {
-  if (!control_.controller()->LookupServiceConfig(route_cfg.hash)) {
-    control_.controller()->AddServiceConfig(route_cfg.hash, route_cfg.config);
-  }
-  config->service_config_id = route_cfg.hash;
+  config->service_config = &route_cfg.config;
+  config->service_config_hash = route_cfg.hash;
 }
 
-FilterHeadersStatus Filter::decodeHeaders(HeaderMap& headers, bool) {
+FilterHeadersStatus Filter::decodeHeaders(HeaderMap& headers,
+                                          bool end_stream) {
   ENVOY_LOG(debug, "Called Mixer::Filter : {}", __func__);
   request_total_size_ += headers.refreshByteSize();
 
@@ -73,13 +71,14 @@ FilterHeadersStatus Filter::decodeHeaders(HeaderMap& headers, bool) {
 
   state_ = Calling;
   initiating_call_ = true;
-  CheckData check_data(headers,
-                       decoder_callbacks_->streamInfo().dynamicMetadata(),
-                       decoder_callbacks_->connection());
+  check_data_ = std::make_unique<CheckData>(
+      headers, decoder_callbacks_->streamInfo().dynamicMetadata(),
+      decoder_callbacks_->connection(),
+      &decoder_callbacks_->streamInfo().filterState());
   Utils::HeaderUpdate header_update(&headers);
   headers_ = &headers;
   handler_->Check(
-      &check_data, &header_update,
+      check_data_.get(), &header_update,
       control_.GetCheckTransport(decoder_callbacks_->activeSpan()),
       [this](const CheckResponseInfo& info) { completeCheck(info); });
   initiating_call_ = false;
@@ -87,6 +86,16 @@ FilterHeadersStatus Filter::decodeHeaders(HeaderMap& headers, bool) {
   if (state_ == Complete) {
     return FilterHeadersStatus::Continue;
   }
+  // The request body streams upstream while the check is pending, if the
+  // service config allows it. The request header operations of the check
+  // are then not applied.
+  if (state_ == Calling && !end_stream &&
+      handler_->StartOptimisticStreaming()) {
+    ENVOY_LOG(debug, "Called Mixer::Filter : {} Streaming", __func__);
+    state_ = Streaming;
+    headers_ = nullptr;
+    return FilterHeadersStatus::Continue;
+  }
   ENVOY_LOG(debug, "Called Mixer::Filter : {} Stop", __func__);
   return FilterHeadersStatus::StopIteration;
 }
@@ -110,39 +119,38 @@ FilterTrailersStatus Filter::decodeTrailers(HeaderMap& trailers) {
   return FilterTrailersStatus::Continue;
 }
 
-void Filter::UpdateHeaders(
-    HeaderMap& headers, const ::google::protobuf::RepeatedPtrField<
-                            ::istio::mixer::v1::HeaderOperation>& operations) {
-  for (auto const iter : operations) {
-    switch (iter.operation()) {
-      case ::istio::mixer::v1::HeaderOperation_Operation_REPLACE:
-        headers.remove(LowerCaseString(iter.name()));
-        headers.addCopy(LowerCaseString(iter.name()), iter.value());
-        break;
-      case ::istio::mixer::v1::HeaderOperation_Operation_REMOVE:
-        headers.remove(LowerCaseString(iter.name()));
-        break;
-      case ::istio::mixer::v1::HeaderOperation_Operation_APPEND:
-        headers.addCopy(LowerCaseString(iter.name()), iter.value());
-        break;
-      default:
-        PANIC("unreachable header operation");
-    }
-  }
-}
-
 FilterHeadersStatus Filter::encodeHeaders(HeaderMap& headers, bool) {
   ENVOY_LOG(debug, "Called Mixer::Filter : {} {}", __func__, state_);
   // Init state is possible if a filter prior to mixerfilter interrupts the
   // filter chain
-  ASSERT(state_ == NotStarted || state_ == Complete || state_ == Responded);
-  if (state_ == Complete) {
+  ASSERT(state_ == NotStarted || state_ == Streaming || state_ == Complete ||
+         state_ == Responded);
+  // The response of a streamed request waits for its check.
+  if (state_ == Streaming) {
+    response_headers_ = &headers;
+    return FilterHeadersStatus::StopIteration;
+  }
+  if (state_ == Complete && header_operations_ != nullptr) {
     // handle response header operations
-    UpdateHeaders(headers, route_directive_.response_header_operations());
+    header_operations_->applyResponse(headers);
   }
   return FilterHeadersStatus::Continue;
 }
 
+FilterDataStatus Filter::encodeData(Buffer::Instance&, bool) {
+  if (state_ == Streaming) {
+    return FilterDataStatus::StopIterationAndBuffer;
+  }
+  return FilterDataStatus::Continue;
+}
+
+FilterTrailersStatus Filter::encodeTrailers(HeaderMap&) {
+  if (state_ == Streaming) {
+    return FilterTrailersStatus::StopIteration;
+  }
+  return FilterTrailersStatus::Continue;
+}
+
 void Filter::setDecoderFilterCallbacks(
     StreamDecoderFilterCallbacks& callbacks) {
   ENVOY_LOG(debug, "Called Mixer::Filter : {}", __func__);
@@ -159,19 +167,37 @@ void Filter::completeCheck(const CheckResponseInfo& info) {
     return;
   }
 
-  route_directive_ = info.routeDirective();
+  // A streamed request is reset if it is denied, it may have reached the
+  // upstream.
+  if (state_ == Streaming &&
+      (!status.ok() || info.routeDirective().direct_response_code() != 0)) {
+    ENVOY_LOG(debug, "Mixer::Filter reset streamed request: {}",
+              status.ToString());
+    state_ = Responded;
+    Utils::CheckResponseInfoToStreamInfo(info,
+                                         decoder_callbacks_->streamInfo());
+    decoder_callbacks_->resetStream();
+    return;
+  }
+  const bool streaming = state_ == Streaming;
+
+  route_directive_ = info.sharedRouteDirective();
+  if (route_directive_) {
+    header_operations_ = &HeaderOperations::get(*route_directive_);
+  }
 
   Utils::CheckResponseInfoToStreamInfo(info, decoder_callbacks_->streamInfo());
 
   // handle direct response from the route directive
-  if (route_directive_.direct_response_code() != 0) {
-    int status_code = route_directive_.direct_response_code();
+  const auto& route_directive = info.routeDirective();
+  if (route_directive.direct_response_code() != 0) {
+    int status_code = route_directive.direct_response_code();
     ENVOY_LOG(debug, "Mixer::Filter direct response {}", status_code);
     state_ = Responded;
     decoder_callbacks_->sendLocalReply(
-        Code(status_code), route_directive_.direct_response_body(),
+        Code(status_code), route_directive.direct_response_body(),
         [this](HeaderMap& headers) {
-          UpdateHeaders(headers, route_directive_.response_header_operations());
+          header_operations_->applyResponse(headers);
         },
         absl::nullopt, RcDetails::get().MixerDirectResponse);
     return;
@@ -190,13 +216,26 @@ void Filter::completeCheck(const CheckResponseInfo& info) {
 
   state_ = Complete;
 
-  // handle request header operations
+  // handle request header operations, the route is only selected again if
+  // they changed a header it may match.
   if (nullptr != headers_) {
-    UpdateHeaders(*headers_, route_directive_.request_header_operations());
-    headers_ = nullptr;
-    if (route_directive_.request_header_operations().size() > 0) {
+    if (header_operations_ != nullptr &&
+        header_operations_->applyRequest(*headers_)) {
       decoder_callbacks_->clearRouteCache();
     }
+    headers_ = nullptr;
+  }
+
+  if (streaming) {
+    // handle the response held for the check
+    if (nullptr != response_headers_) {
+      if (header_operations_ != nullptr) {
+        header_operations_->applyResponse(*response_headers_);
+      }
+      response_headers_ = nullptr;
+      encoder_callbacks_->continueEncoding();
+    }
+    return;
   }
 
   if (!initiating_call_) {
@@ -206,7 +245,7 @@ void Filter::completeCheck(const CheckResponseInfo& info) {
 
 void Filter::onDestroy() {
   ENVOY_LOG(debug, "Called Mixer::Filter : {} state: {}", __func__, state_);
-  if (state_ != Calling && handler_) {
+  if (state_ != Calling && state_ != Streaming && handler_) {
     handler_->ResetCancel();
   }
   state_ = Responded;
@@ -238,13 +277,19 @@ void Filter::log(const HeaderMap* request_headers,
     handler_ = control_.controller()->CreateRequestHandler(config);
   }
 
-  // If check is NOT called, check attributes are not extracted.
-  CheckData check_data(*request_headers, stream_info.dynamicMetadata(),
-                       decoder_callbacks_->connection());
+  // If check is NOT called, check attributes are not extracted. Otherwise
+  // they are already in the handler, and the check data of decodeHeaders()
+  // is passed with the query parameters it has parsed.
+  if (!check_data_) {
+    check_data_ = std::make_unique<CheckData>(
+        *request_headers, stream_info.dynamicMetadata(),
+        decoder_callbacks_->connection(),
+        &decoder_callbacks_->streamInfo().filterState());
+  }
   // response trailer header is not counted to response total size.
   ReportData report_data(request_headers, response_headers, response_trailers,
                          stream_info, request_total_size_);
-  handler_->Report(&check_data, &report_data);
+  handler_->Report(check_data_.get(), &report_data);
 }
 
 }  // namespace Mixer
@@ -18,7 +18,9 @@
 #include "common/common/logger.h"
 #include "envoy/access_log/access_log.h"
 #include "envoy/http/filter.h"
+#include "src/envoy/http/mixer/check_data.h"
 #include "src/envoy/http/mixer/control.h"
+#include "src/envoy/http/mixer/header_operations.h"
 
 namespace Envoy {
 namespace Http {
@@ -29,8 +31,8 @@ struct PerRouteServiceConfig : public Router::RouteSpecificFilterConfig {
   // The per_route service config.
   ::istio::mixer::v1::config::client::ServiceConfig config;
 
-  // Its config hash
-  std::string hash;
+  // Its config hash, computed when the route config is loaded.
+  uint64_t hash;
 };
 
 class Filter : public StreamFilter,
@@ -40,7 +42,8 @@ class Filter : public StreamFilter,
   Filter(Control& control);
 
   // Http::StreamDecoderFilter
-  FilterHeadersStatus decodeHeaders(HeaderMap& headers, bool) override;
+  FilterHeadersStatus decodeHeaders(HeaderMap& headers,
+                                    bool end_stream) override;
   FilterDataStatus decodeData(Buffer::Instance& data, bool end_stream) override;
   FilterTrailersStatus decodeTrailers(HeaderMap& trailers) override;
   void setDecoderFilterCallbacks(
@@ -54,16 +57,15 @@ class Filter : public StreamFilter,
     return FilterHeadersStatus::Continue;
   }
   FilterHeadersStatus encodeHeaders(HeaderMap& headers, bool) override;
-  FilterDataStatus encodeData(Buffer::Instance&, bool) override {
-    return FilterDataStatus::Continue;
-  }
-  FilterTrailersStatus encodeTrailers(HeaderMap&) override {
-    return FilterTrailersStatus::Continue;
-  }
+  FilterDataStatus encodeData(Buffer::Instance&, bool) override;
+  FilterTrailersStatus encodeTrailers(HeaderMap&) override;
   Http::FilterMetadataStatus encodeMetadata(MetadataMap&) override {
     return FilterMetadataStatus::Continue;
   }
-  void setEncoderFilterCallbacks(StreamEncoderFilterCallbacks&) override {}
+  void setEncoderFilterCallbacks(
+      StreamEncoderFilterCallbacks& callbacks) override {
+    encoder_callbacks_ = &callbacks;
+  }
 
   // This is the callback function when Check is done.
   void completeCheck(const ::istio::mixerclient::CheckResponseInfo& info);
@@ -80,23 +82,24 @@ class Filter : public StreamFilter,
       const PerRouteServiceConfig& route_cfg,
       ::istio::control::http::Controller::PerRouteConfig* config);
 
-  // Update header maps
-  void UpdateHeaders(HeaderMap& headers,
-                     const ::google::protobuf::RepeatedPtrField<
-                         ::istio::mixer::v1::HeaderOperation>& operations);
-
   // The control object.
   Control& control_;
+  // The check data of the request, built once and used by both Check and
+  // Report.
+  std::unique_ptr<CheckData> check_data_;
   // The request handler.
   std::unique_ptr<::istio::control::http::RequestHandler> handler_;
 
-  enum State { NotStarted, Calling, Complete, Responded };
+  // Streaming is Calling with the request streaming upstream.
+  enum State { NotStarted, Calling, Streaming, Complete, Responded };
   // The state
   State state_;
   bool initiating_call_;
 
   // Point to the request HTTP headers
   HeaderMap* headers_;
+  // Point to the response HTTP headers held while Streaming.
+  HeaderMap* response_headers_{nullptr};
 
   // Total number of bytes received, including request headers, body, and
   // trailers.
@@ -104,10 +107,13 @@ class Filter : public StreamFilter,
 
   // The stream decoder filter callback.
   StreamDecoderFilterCallbacks* decoder_callbacks_{nullptr};
+  // The stream encoder filter callback.
+  StreamEncoderFilterCallbacks* encoder_callbacks_{nullptr};
 
-  // Returned directive
-  ::istio::mixer::v1::RouteDirective route_directive_{
-      ::istio::mixer::v1::RouteDirective::default_instance()};
+  // Returned directive, nullptr if it is empty.
+  ::istio::mixerclient::SharedRouteDirectivePtr route_directive_;
+  // Its compiled header operations, owned by route_directive_.
+  const HeaderOperations* header_operations_{nullptr};
 };
 
 }  // namespace Mixer
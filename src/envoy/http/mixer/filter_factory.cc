@@ -66,7 +66,7 @@ class MixerConfigFactory : public NamedHttpFilterConfigFactory {
     // TODO: use downcastAndValidate once client_config.proto adds validate
     // rules.
     obj->config = dynamic_cast<const ServiceConfig&>(config);
-    obj->hash = std::to_string(MessageUtil::hash(obj->config));
+    obj->hash = MessageUtil::hash(obj->config);
     return obj;
   }
 
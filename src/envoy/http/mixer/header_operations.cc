@@ -0,0 +1,83 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/mixer/header_operations.h"
+
+#include "common/common/assert.h"
+
+using ::istio::mixer::v1::HeaderOperation;
+using ::istio::mixer::v1::RouteDirective;
+using ::istio::mixerclient::SharedRouteDirective;
+
+namespace Envoy {
+namespace Http {
+namespace Mixer {
+
+HeaderOperations::HeaderOperations(const RouteDirective& directive)
+    : request_(compile(directive.request_header_operations())),
+      response_(compile(directive.response_header_operations())) {}
+
+const HeaderOperations& HeaderOperations::get(
+    const SharedRouteDirective& directive) {
+  if (directive.compiled() == nullptr) {
+    directive.set_compiled(
+        std::make_unique<HeaderOperations>(directive.directive()));
+  }
+  return static_cast<const HeaderOperations&>(*directive.compiled());
+}
+
+std::vector<HeaderOperations::Operation> HeaderOperations::compile(
+    const ::google::protobuf::RepeatedPtrField<HeaderOperation>& operations) {
+  std::vector<Operation> compiled;
+  compiled.reserve(operations.size());
+  for (const auto& operation : operations) {
+    compiled.push_back(Operation{operation.operation(),
+                                 LowerCaseString(operation.name()),
+                                 operation.value()});
+  }
+  return compiled;
+}
+
+bool HeaderOperations::apply(const std::vector<Operation>& operations,
+                             HeaderMap& headers) {
+  bool changed = false;
+  for (const auto& operation : operations) {
+    const HeaderEntry* entry = headers.get(operation.name);
+    switch (operation.operation) {
+      case HeaderOperation::REPLACE:
+        changed = changed || entry == nullptr ||
+                  entry->value().getStringView() != operation.value;
+        headers.remove(operation.name);
+        headers.addCopy(operation.name, operation.value);
+        break;
+      case HeaderOperation::REMOVE:
+        changed = changed || entry != nullptr;
+        headers.remove(operation.name);
+        break;
+      case HeaderOperation::APPEND:
+        // An inline header gets the value appended to its first value.
+        changed = true;
+        headers.addCopy(operation.name, operation.value);
+        break;
+      default:
+        PANIC("unreachable header operation");
+    }
+  }
+  return changed;
+}
+
+}  // namespace Mixer
+}  // namespace Http
+}  // namespace Envoy
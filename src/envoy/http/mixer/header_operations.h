@@ -0,0 +1,68 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "envoy/http/header_map.h"
+#include "include/istio/mixerclient/check_response.h"
+
+namespace Envoy {
+namespace Http {
+namespace Mixer {
+
+// The header operations of a route directive, with their header names
+// built once. They are cached with the check cache entry of the directive,
+// so the cache hits reuse them.
+class HeaderOperations : public ::istio::mixerclient::CompiledRouteDirective {
+ public:
+  HeaderOperations(const ::istio::mixer::v1::RouteDirective& directive);
+
+  // Returns the compiled operations of directive, compiling them first if
+  // it is the first use.
+  static const HeaderOperations& get(
+      const ::istio::mixerclient::SharedRouteDirective& directive);
+
+  // Applies the request header operations. Returns true if they changed the
+  // value seen by the route matching of a header, i.e. its first value.
+  bool applyRequest(HeaderMap& headers) const {
+    return apply(request_, headers);
+  }
+
+  void applyResponse(HeaderMap& headers) const { apply(response_, headers); }
+
+ private:
+  struct Operation {
+    ::istio::mixer::v1::HeaderOperation::Operation operation;
+    LowerCaseString name;
+    std::string value;
+  };
+
+  static std::vector<Operation> compile(
+      const ::google::protobuf::RepeatedPtrField<
+          ::istio::mixer::v1::HeaderOperation>& operations);
+
+  static bool apply(const std::vector<Operation>& operations,
+                    HeaderMap& headers);
+
+  const std::vector<Operation> request_;
+  const std::vector<Operation> response_;
+};
+
+}  // namespace Mixer
+}  // namespace Http
+}  // namespace Envoy
@@ -0,0 +1,94 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/http/mixer/header_operations.h"
+
+#include "gtest/gtest.h"
+#include "test/test_common/utility.h"
+
+using ::istio::mixer::v1::HeaderOperation;
+using ::istio::mixer::v1::RouteDirective;
+using ::istio::mixerclient::SharedRouteDirective;
+
+namespace Envoy {
+namespace Http {
+namespace Mixer {
+namespace {
+
+void AddOperation(HeaderOperation* operation, HeaderOperation::Operation type,
+                  const std::string& name, const std::string& value) {
+  operation->set_operation(type);
+  operation->set_name(name);
+  operation->set_value(value);
+}
+
+TEST(HeaderOperationsTest, CompiledOnce) {
+  RouteDirective directive;
+  AddOperation(directive.add_request_header_operations(),
+               HeaderOperation::REPLACE, "X-Foo", "bar");
+  const SharedRouteDirective shared(directive);
+
+  const HeaderOperations& operations = HeaderOperations::get(shared);
+  EXPECT_EQ(&operations, shared.compiled());
+  EXPECT_EQ(&operations, &HeaderOperations::get(shared));
+}
+
+TEST(HeaderOperationsTest, ApplyRequest) {
+  RouteDirective directive;
+  AddOperation(directive.add_request_header_operations(),
+               HeaderOperation::REPLACE, "X-Foo", "bar");
+  AddOperation(directive.add_request_header_operations(),
+               HeaderOperation::REMOVE, "x-remove", "");
+  AddOperation(directive.add_request_header_operations(),
+               HeaderOperation::APPEND, "x-append", "1");
+  const HeaderOperations operations(directive);
+
+  TestHeaderMapImpl headers{{"x-foo", "old"}, {"x-foo", "older"},
+                            {"x-remove", "1"}};
+  EXPECT_TRUE(operations.applyRequest(headers));
+  EXPECT_EQ(headers, TestHeaderMapImpl({{"x-foo", "bar"}, {"x-append", "1"}}));
+}
+
+TEST(HeaderOperationsTest, UnchangedRequest) {
+  RouteDirective directive;
+  AddOperation(directive.add_request_header_operations(),
+               HeaderOperation::REPLACE, "x-foo", "bar");
+  AddOperation(directive.add_request_header_operations(),
+               HeaderOperation::REMOVE, "x-remove", "");
+  const HeaderOperations operations(directive);
+
+  // The route is not cleared for a header already set, or already absent.
+  TestHeaderMapImpl headers{{"x-foo", "bar"}};
+  EXPECT_FALSE(operations.applyRequest(headers));
+  EXPECT_EQ(headers, TestHeaderMapImpl({{"x-foo", "bar"}}));
+}
+
+TEST(HeaderOperationsTest, ApplyResponse) {
+  RouteDirective directive;
+  AddOperation(directive.add_request_header_operations(),
+               HeaderOperation::APPEND, "x-request", "1");
+  AddOperation(directive.add_response_header_operations(),
+               HeaderOperation::APPEND, "x-response", "1");
+  const HeaderOperations operations(directive);
+
+  TestHeaderMapImpl headers;
+  operations.applyResponse(headers);
+  EXPECT_EQ(headers, TestHeaderMapImpl({{"x-response", "1"}}));
+}
+
+}  // namespace
+}  // namespace Mixer
+}  // namespace Http
+}  // namespace Envoy
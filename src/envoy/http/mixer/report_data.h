@@ -33,7 +33,7 @@ const std::string kRbacPermissivePolicyIDField = "shadow_effective_policy_id";
 const std::string kRbacPermissiveEngineResultField = "shadow_engine_result";
 
 // Set of headers excluded from response.headers attribute.
-const std::set<std::string> ResponseHeaderExclusives = {};
+const Utils::HeaderSet ResponseHeaderExclusives = {};
 
 bool ExtractGrpcStatus(const HeaderMap *headers,
                        ::istio::control::http::ReportData::GrpcStatus *status) {
@@ -95,12 +95,30 @@ class ReportData : public ::istio::control::http::ReportData,
     return header_map;
   }
 
+  bool ExtractResponseHeaders(
+      ::istio::mixer::v1::Attributes_StringMap *headers) const override {
+    if (response_headers_) {
+      Utils::ExtractHeaders(*response_headers_, ResponseHeaderExclusives,
+                            headers);
+    }
+    if (trailers_) {
+      Utils::ExtractHeaders(*trailers_, ResponseHeaderExclusives, headers);
+    }
+    return true;
+  }
+
   void GetTracingHeaders(
       std::map<std::string, std::string> &tracing_headers) const override {
     Utils::FindHeaders(*request_headers_, Utils::TracingHeaderSet,
                        tracing_headers);
   }
 
+  bool ExtractTracingHeaders(
+      ::istio::mixer::v1::Attributes_StringMap *headers) const override {
+    Utils::FindHeaders(*request_headers_, Utils::TracingHeaderSet, headers);
+    return true;
+  }
+
   void GetReportInfo(
       ::istio::control::http::ReportData::ReportInfo *data) const override {
     data->request_body_size = info_.bytesReceived();
@@ -17,6 +17,7 @@
 
 #include "common/common/enum_to_int.h"
 #include "extensions/filters/network/well_known_names.h"
+#include "src/envoy/utils/connection_identity.h"
 #include "src/envoy/utils/utils.h"
 
 using ::google::protobuf::util::Status;
@@ -195,11 +196,13 @@ bool Filter::GetSourceIpPort(std::string *str_ip, int *port) const {
 }
 
 bool Filter::GetPrincipal(bool peer, std::string *user) const {
-  return Utils::GetPrincipal(&filter_callbacks_->connection(), peer, user);
+  return Utils::ConnectionIdentity::get(filter_callbacks_->connection())
+      .principal(peer, user);
 }
 
 bool Filter::IsMutualTLS() const {
-  return Utils::IsMutualTLS(&filter_callbacks_->connection());
+  return Utils::ConnectionIdentity::get(filter_callbacks_->connection())
+      .mutualTLS();
 }
 
 bool Filter::GetRequestedServerName(std::string *name) const {
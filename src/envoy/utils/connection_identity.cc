@@ -0,0 +1,77 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/utils/connection_identity.h"
+
+#include "common/common/macros.h"
+#include "src/envoy/utils/utils.h"
+
+namespace Envoy {
+namespace Utils {
+
+const std::string& ConnectionIdentity::key() {
+  CONSTRUCT_ON_FIRST_USE(std::string, "istio.connection_identity");
+}
+
+const ConnectionIdentity& ConnectionIdentity::get(
+    const Network::Connection& connection) {
+  // Only the filter state of the connection is modified, the connection
+  // itself is const for the callers.
+  StreamInfo::FilterState& filter_state =
+      const_cast<Network::Connection&>(connection).streamInfo().filterState();
+  if (!filter_state.hasData<ConnectionIdentity>(key())) {
+    filter_state.setData(
+        key(),
+        std::unique_ptr<ConnectionIdentity>(new ConnectionIdentity(connection)),
+        StreamInfo::FilterState::StateType::ReadOnly);
+  }
+  return filter_state.getDataReadOnly<ConnectionIdentity>(key());
+}
+
+ConnectionIdentity::ConnectionIdentity(const Network::Connection& connection)
+    : peer_(extract(connection, true)),
+      local_(extract(connection, false)),
+      mutual_tls_(IsMutualTLS(&connection)) {}
+
+ConnectionIdentity::Certificate ConnectionIdentity::extract(
+    const Network::Connection& connection, bool peer) {
+  Certificate certificate;
+  certificate.has_principal =
+      GetPrincipal(&connection, peer, &certificate.principal);
+  certificate.has_trust_domain =
+      certificate.has_principal &&
+      GetTrustDomain(&connection, peer, &certificate.trust_domain);
+  return certificate;
+}
+
+bool ConnectionIdentity::principal(bool peer, std::string* principal) const {
+  const Certificate& certificate = peer ? peer_ : local_;
+  if (certificate.has_principal) {
+    *principal = certificate.principal;
+  }
+  return certificate.has_principal;
+}
+
+bool ConnectionIdentity::trustDomain(bool peer,
+                                     std::string* trust_domain) const {
+  const Certificate& certificate = peer ? peer_ : local_;
+  if (certificate.has_trust_domain) {
+    *trust_domain = certificate.trust_domain;
+  }
+  return certificate.has_trust_domain;
+}
+
+}  // namespace Utils
+}  // namespace Envoy
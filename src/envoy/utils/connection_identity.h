@@ -0,0 +1,67 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "envoy/network/connection.h"
+#include "envoy/stream_info/filter_state.h"
+
+namespace Envoy {
+namespace Utils {
+
+// The identities of the peer and local certificates of a connection. They
+// are extracted once per connection and kept in its filter state, instead of
+// for every request of the connection.
+class ConnectionIdentity : public StreamInfo::FilterState::Object {
+ public:
+  // The filter state key.
+  static const std::string& key();
+
+  // Returns the identity of connection, extracted the first time it is asked
+  // for, which must be after the TLS handshake, e.g. when data is received.
+  static const ConnectionIdentity& get(const Network::Connection& connection);
+
+  // Same as Utils::GetPrincipal().
+  bool principal(bool peer, std::string* principal) const;
+
+  // Same as Utils::GetTrustDomain().
+  bool trustDomain(bool peer, std::string* trust_domain) const;
+
+  // Same as Utils::IsMutualTLS().
+  bool mutualTLS() const { return mutual_tls_; }
+
+ private:
+  explicit ConnectionIdentity(const Network::Connection& connection);
+
+  // The identity of one side of the connection.
+  struct Certificate {
+    bool has_principal;
+    std::string principal;
+    bool has_trust_domain;
+    std::string trust_domain;
+  };
+
+  static Certificate extract(const Network::Connection& connection,
+                             bool peer);
+
+  const Certificate peer_;
+  const Certificate local_;
+  const bool mutual_tls_;
+};
+
+}  // namespace Utils
+}  // namespace Envoy
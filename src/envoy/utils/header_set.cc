@@ -0,0 +1,104 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/utils/header_set.h"
+
+#include <algorithm>
+#include <set>
+
+#include "common/common/assert.h"
+#include "common/common/hash.h"
+
+namespace Envoy {
+namespace Utils {
+namespace {
+
+// The seeds tried for a bucket before the table is grown.
+constexpr uint64_t kMaxSeeds = 1024;
+
+}  // namespace
+
+HeaderSet::HeaderSet(const std::vector<std::string>& names) {
+  const std::set<std::string> unique(names.begin(), names.end());
+  size_ = unique.size();
+  if (size_ == 0) {
+    return;
+  }
+  ASSERT(unique.count("") == 0);
+
+  // About two names per bucket, and a table at most half full.
+  seeds_.assign((size_ + 1) / 2, 0);
+  std::vector<std::vector<std::string>> buckets(seeds_.size());
+  for (const auto& name : unique) {
+    buckets[bucket(name)].push_back(name);
+  }
+  std::vector<size_t> order(buckets.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  // The largest buckets are placed first, while the table is empty.
+  std::stable_sort(order.begin(), order.end(), [&buckets](size_t a, size_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  size_t table_size = 1;
+  while (table_size < 2 * size_) {
+    table_size <<= 1;
+  }
+  for (;; table_size <<= 1) {
+    table_.assign(table_size, std::string());
+    bool placed = true;
+    for (size_t b : order) {
+      placed = false;
+      for (uint64_t seed = 0; !placed && seed < kMaxSeeds; ++seed) {
+        seeds_[b] = seed;
+        std::vector<size_t> slots;
+        for (const auto& name : buckets[b]) {
+          const size_t slot = index(name);
+          if (!table_[slot].empty() ||
+              std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+            break;
+          }
+          slots.push_back(slot);
+        }
+        if (slots.size() == buckets[b].size()) {
+          for (size_t i = 0; i < slots.size(); ++i) {
+            table_[slots[i]] = buckets[b][i];
+          }
+          placed = true;
+        }
+      }
+      if (!placed) {
+        break;
+      }
+    }
+    if (placed) {
+      return;
+    }
+  }
+}
+
+size_t HeaderSet::bucket(absl::string_view name) const {
+  return HashUtil::xxHash64(name) % seeds_.size();
+}
+
+size_t HeaderSet::index(absl::string_view name) const {
+  // The table size is a power of two.
+  return HashUtil::xxHash64(name, seeds_[bucket(name)] + 1) &
+         (table_.size() - 1);
+}
+
+}  // namespace Utils
+}  // namespace Envoy
@@ -0,0 +1,61 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Utils {
+
+// A fixed set of header names, e.g. the headers excluded from an attribute.
+// It is a perfect hash table built with hash and displace: the names are
+// hashed into buckets, and each bucket gets a seed so that its names do not
+// collide with the others in the table. A lookup is two hashes and at most
+// one comparison, without copying the name.
+class HeaderSet {
+ public:
+  explicit HeaderSet(const std::vector<std::string>& names);
+  HeaderSet(std::initializer_list<std::string> names)
+      : HeaderSet(std::vector<std::string>(names)) {}
+
+  bool contains(absl::string_view name) const {
+    if (size_ == 0) {
+      return false;
+    }
+    const std::string& slot = table_[index(name)];
+    return !slot.empty() && slot == name;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  size_t bucket(absl::string_view name) const;
+  size_t index(absl::string_view name) const;
+
+  // The seed of each bucket.
+  std::vector<uint64_t> seeds_;
+  // The names by their index, an empty string is an empty slot.
+  std::vector<std::string> table_;
+  size_t size_{};
+};
+
+}  // namespace Utils
+}  // namespace Envoy
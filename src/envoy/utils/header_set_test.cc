@@ -0,0 +1,61 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/utils/header_set.h"
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Utils {
+namespace {
+
+TEST(HeaderSetTest, Empty) {
+  const HeaderSet set = {};
+  EXPECT_TRUE(set.empty());
+  EXPECT_FALSE(set.contains("x-b3-traceid"));
+  EXPECT_FALSE(set.contains(""));
+}
+
+TEST(HeaderSetTest, Contains) {
+  const HeaderSet set = {"x-b3-traceid", "x-b3-spanid", "x-b3-parentspanid",
+                         "x-b3-sampled", "x-b3-spanid"};
+  EXPECT_EQ(set.size(), 4);
+  EXPECT_TRUE(set.contains("x-b3-traceid"));
+  EXPECT_TRUE(set.contains("x-b3-spanid"));
+  EXPECT_TRUE(set.contains("x-b3-parentspanid"));
+  EXPECT_TRUE(set.contains("x-b3-sampled"));
+  EXPECT_FALSE(set.contains("x-b3-flags"));
+  EXPECT_FALSE(set.contains("X-B3-TRACEID"));
+  EXPECT_FALSE(set.contains(""));
+}
+
+TEST(HeaderSetTest, ManyNames) {
+  // Enough names for buckets with colliding names.
+  std::vector<std::string> names;
+  for (int i = 0; i < 200; ++i) {
+    names.push_back(absl::StrCat("x-header-", i));
+  }
+  const HeaderSet set(names);
+  EXPECT_EQ(set.size(), names.size());
+  for (const auto& name : names) {
+    EXPECT_TRUE(set.contains(name));
+    EXPECT_FALSE(set.contains(name + "-other"));
+  }
+}
+
+}  // namespace
+}  // namespace Utils
+}  // namespace Envoy
@@ -46,6 +46,17 @@ class HeaderUpdate : public ::istio::control::http::HeaderUpdate,
     headers_->setReferenceKey(kIstioAttributeHeader, base64);
   }
 
+  bool EncodeIstioAttributes(const std::string& data,
+                             std::string* value) const override {
+    *value = Base64::encode(data.c_str(), data.size());
+    return true;
+  }
+
+  void AddEncodedIstioAttributes(const std::string& value) override {
+    ENVOY_LOG(debug, "Mixer forward attributes set: {}", value);
+    headers_->setReferenceKey(kIstioAttributeHeader, value);
+  }
+
   static const Http::LowerCaseString& IstioAttributeHeader() {
     return kIstioAttributeHeader;
   }
@@ -0,0 +1,42 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/utils/query_params.h"
+
+#include "common/common/macros.h"
+
+namespace Envoy {
+namespace Utils {
+
+const std::string& QueryParams::key() {
+  CONSTRUCT_ON_FIRST_USE(std::string, "istio.query_params");
+}
+
+const Http::Utility::QueryParams& QueryParams::get(
+    absl::string_view path, StreamInfo::FilterState& filter_state) {
+  if (!filter_state.hasData<QueryParams>(key())) {
+    filter_state.setData(key(), std::make_unique<QueryParams>(),
+                         StreamInfo::FilterState::StateType::Mutable);
+  }
+  QueryParams& query_params = filter_state.getDataMutable<QueryParams>(key());
+  if (query_params.path_ != path) {
+    query_params.path_ = std::string(path);
+    query_params.params_ = Http::Utility::parseQueryString(path);
+  }
+  return query_params.params_;
+}
+
+}  // namespace Utils
+}  // namespace Envoy
@@ -0,0 +1,47 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "common/http/utility.h"
+#include "envoy/stream_info/filter_state.h"
+
+namespace Envoy {
+namespace Utils {
+
+// The query parameters of a request path, kept in the filter state so that
+// the filters of a request parse them at most once.
+class QueryParams : public StreamInfo::FilterState::Object {
+ public:
+  // The filter state key.
+  static const std::string& key();
+
+  // Returns the query parameters of path. They are parsed and saved in
+  // filter_state if it has none yet, or only has those of another path,
+  // e.g. before it was rewritten.
+  static const Http::Utility::QueryParams& get(
+      absl::string_view path, StreamInfo::FilterState& filter_state);
+
+ private:
+  // The path the parameters were parsed from.
+  std::string path_;
+  Http::Utility::QueryParams params_;
+};
+
+}  // namespace Utils
+}  // namespace Envoy
@@ -0,0 +1,48 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/envoy/utils/query_params.h"
+
+#include "common/stream_info/filter_state_impl.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Utils {
+namespace {
+
+TEST(QueryParamsTest, ParsedOncePerPath) {
+  StreamInfo::FilterStateImpl filter_state;
+  const auto& params = QueryParams::get("/foo?a=1&b=2", filter_state);
+  EXPECT_EQ(2, params.size());
+  EXPECT_EQ("1", params.at("a"));
+  EXPECT_TRUE(filter_state.hasData<QueryParams>(QueryParams::key()));
+
+  // The same path returns the saved parameters.
+  EXPECT_EQ(&params, &QueryParams::get("/foo?a=1&b=2", filter_state));
+}
+
+TEST(QueryParamsTest, ParsedAgainForOtherPath) {
+  StreamInfo::FilterStateImpl filter_state;
+  EXPECT_EQ(1, QueryParams::get("/foo?a=1", filter_state).size());
+
+  const auto& params = QueryParams::get("/bar?c=3", filter_state);
+  EXPECT_EQ(1, params.size());
+  EXPECT_EQ("3", params.at("c"));
+  EXPECT_TRUE(QueryParams::get("/bar", filter_state).empty());
+}
+
+}  // namespace
+}  // namespace Utils
+}  // namespace Envoy
@@ -92,6 +92,12 @@ void MixerStatsObject::CheckAndUpdateStats(
   CHECK_AND_UPDATE_STATS(total_remote_report_send_errors_);
   CHECK_AND_UPDATE_STATS(total_remote_report_other_errors_);
 
+  CHECK_AND_UPDATE_STATS(total_header_bytes_saved_);
+
+  CHECK_AND_UPDATE_STATS(total_optimistic_streams_);
+  CHECK_AND_UPDATE_STATS(total_optimistic_stream_resets_);
+  CHECK_AND_UPDATE_STATS(total_optimistic_streaming_saved_ms_);
+
   // Copy new_stats to old_stats_ for next stats update.
   old_stats_ = new_stats;
 }
@@ -57,7 +57,11 @@ namespace Utils {
   COUNTER(total_remote_report_successes)      \
   COUNTER(total_remote_report_timeouts)       \
   COUNTER(total_remote_report_send_errors)    \
-  COUNTER(total_remote_report_other_errors)
+  COUNTER(total_remote_report_other_errors)   \
+  COUNTER(total_header_bytes_saved)           \
+  COUNTER(total_optimistic_streams)           \
+  COUNTER(total_optimistic_stream_resets)     \
+  COUNTER(total_optimistic_streaming_saved_ms)
 // clang-format on
 
 /**
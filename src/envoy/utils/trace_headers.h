@@ -17,6 +17,8 @@
 
 #include <string>
 
+#include "src/envoy/utils/header_set.h"
+
 namespace Envoy {
 namespace Utils {
 
@@ -26,7 +28,7 @@ const std::string kSpanID = "x-b3-spanid";
 const std::string kParentSpanID = "x-b3-parentspanid";
 const std::string kSampled = "x-b3-sampled";
 
-const std::set<std::string> TracingHeaderSet = {
+const HeaderSet TracingHeaderSet = {
     kTraceID,
     kSpanID,
     kParentSpanID,
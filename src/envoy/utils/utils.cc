@@ -57,56 +57,56 @@ bool getCertSAN(const Network::Connection* connection, bool peer,
 bool hasSPIFFEPrefix(const std::string& san) {
   return absl::StartsWith(san, kSPIFFEPrefix);
 }
-}  // namespace
 
-void ExtractHeaders(const Http::HeaderMap& header_map,
-                    const std::set<std::string>& exclusives,
-                    std::map<std::string, std::string>& headers) {
+// Adds the headers for which the set contains the header name or not,
+// depending on included, to the map. The last of repeated headers wins.
+template <class Map>
+void CopyHeaders(const Http::HeaderMap& header_map, const HeaderSet& set,
+                 bool included, Map& headers) {
   struct Context {
-    Context(const std::set<std::string>& exclusives,
-            std::map<std::string, std::string>& headers)
-        : exclusives(exclusives), headers(headers) {}
-    const std::set<std::string>& exclusives;
-    std::map<std::string, std::string>& headers;
+    Context(const HeaderSet& set, bool included, Map& headers)
+        : set(set), included(included), headers(headers) {}
+    const HeaderSet& set;
+    const bool included;
+    Map& headers;
   };
-  Context ctx(exclusives, headers);
+  Context ctx(set, included, headers);
   header_map.iterate(
       [](const Http::HeaderEntry& header,
          void* context) -> Http::HeaderMap::Iterate {
         Context* ctx = static_cast<Context*>(context);
-        auto key = std::string(header.key().getStringView());
-        auto value = std::string(header.value().getStringView());
-        if (ctx->exclusives.count(key) == 0) {
-          ctx->headers[key] = value;
+        absl::string_view key = header.key().getStringView();
+        if (ctx->set.contains(key) == ctx->included) {
+          ctx->headers[std::string(key)] =
+              std::string(header.value().getStringView());
         }
         return Http::HeaderMap::Iterate::Continue;
       },
       &ctx);
 }
 
-void FindHeaders(const Http::HeaderMap& header_map,
-                 const std::set<std::string>& inclusives,
+}  // namespace
+
+void ExtractHeaders(const Http::HeaderMap& header_map,
+                    const HeaderSet& exclusives,
+                    std::map<std::string, std::string>& headers) {
+  CopyHeaders(header_map, exclusives, false, headers);
+}
+
+void ExtractHeaders(const Http::HeaderMap& header_map,
+                    const HeaderSet& exclusives,
+                    ::istio::mixer::v1::Attributes_StringMap* headers) {
+  CopyHeaders(header_map, exclusives, false, *headers->mutable_entries());
+}
+
+void FindHeaders(const Http::HeaderMap& header_map, const HeaderSet& inclusives,
                  std::map<std::string, std::string>& headers) {
-  struct Context {
-    Context(const std::set<std::string>& inclusives,
-            std::map<std::string, std::string>& headers)
-        : inclusives(inclusives), headers(headers) {}
-    const std::set<std::string>& inclusives;
-    std::map<std::string, std::string>& headers;
-  };
-  Context ctx(inclusives, headers);
-  header_map.iterate(
-      [](const Http::HeaderEntry& header,
-         void* context) -> Http::HeaderMap::Iterate {
-        Context* ctx = static_cast<Context*>(context);
-        auto key = std::string(header.key().getStringView());
-        auto value = std::string(header.value().getStringView());
-        if (ctx->inclusives.count(key) != 0) {
-          ctx->headers[key] = value;
-        }
-        return Http::HeaderMap::Iterate::Continue;
-      },
-      &ctx);
+  CopyHeaders(header_map, inclusives, true, headers);
+}
+
+void FindHeaders(const Http::HeaderMap& header_map, const HeaderSet& inclusives,
+                 ::istio::mixer::v1::Attributes_StringMap* headers) {
+  CopyHeaders(header_map, inclusives, true, *headers->mutable_entries());
 }
 
 bool GetIpPort(const Network::Address::Ip* ip, std::string* str_ip, int* port) {
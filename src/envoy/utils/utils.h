@@ -22,21 +22,32 @@
 #include "envoy/network/connection.h"
 #include "google/protobuf/util/json_util.h"
 #include "include/istio/mixerclient/check_response.h"
+#include "mixer/v1/attributes.pb.h"
+#include "src/envoy/utils/header_set.h"
 
 namespace Envoy {
 namespace Utils {
 
 // Extract HTTP headers into a string map
 void ExtractHeaders(const Http::HeaderMap& header_map,
-                    const std::set<std::string>& exclusives,
+                    const HeaderSet& exclusives,
                     std::map<std::string, std::string>& headers);
 
+// Same as above, but adds the headers directly to a string map attribute,
+// which saves copying them through a std::map.
+void ExtractHeaders(const Http::HeaderMap& header_map,
+                    const HeaderSet& exclusives,
+                    ::istio::mixer::v1::Attributes_StringMap* headers);
+
 // Find the given headers from the header map and extract them out to the string
 // map.
-void FindHeaders(const Http::HeaderMap& header_map,
-                 const std::set<std::string>& inclusives,
+void FindHeaders(const Http::HeaderMap& header_map, const HeaderSet& inclusives,
                  std::map<std::string, std::string>& headers);
 
+// Same as above, but adds the headers directly to a string map attribute.
+void FindHeaders(const Http::HeaderMap& header_map, const HeaderSet& inclusives,
+                 ::istio::mixer::v1::Attributes_StringMap* headers);
+
 // Get ip and port from Envoy ip.
 bool GetIpPort(const Network::Address::Ip* ip, std::string* str_ip, int* port);
 
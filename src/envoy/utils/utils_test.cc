@@ -16,6 +16,7 @@
 #include "src/envoy/utils/utils.h"
 
 #include "gmock/gmock.h"
+#include "src/envoy/utils/connection_identity.h"
 #include "mixer/v1/config/client/client_config.pb.h"
 #include "src/istio/mixerclient/check_context.h"
 #include "test/mocks/network/mocks.h"
@@ -29,6 +30,7 @@ using Envoy::Utils::CheckResponseInfoToStreamInfo;
 using Envoy::Utils::ParseJsonMessage;
 using testing::NiceMock;
 using testing::Return;
+using testing::ReturnRef;
 
 class UtilsTest : public testing::TestWithParam<bool> {
  public:
@@ -118,6 +120,30 @@ TEST(UtilsTest, CheckResponseInfoToStreamInfo) {
   CheckResponseInfoToStreamInfo(check_response, mock_stream_info);
 }
 
+TEST(UtilsTest, ExtractHeadersToStringMap) {
+  Envoy::Http::TestHeaderMapImpl headers{{"x-b3-traceid", "abc"},
+                                         {"x-istio-attributes", "data"},
+                                         {"foo", "1"},
+                                         {"foo", "2"}};
+  const Envoy::Utils::HeaderSet exclusives = {"x-istio-attributes"};
+
+  std::map<std::string, std::string> expected;
+  Envoy::Utils::ExtractHeaders(headers, exclusives, expected);
+  ::istio::mixer::v1::Attributes_StringMap string_map;
+  Envoy::Utils::ExtractHeaders(headers, exclusives, &string_map);
+  EXPECT_EQ(std::map<std::string, std::string>(string_map.entries().begin(),
+                                               string_map.entries().end()),
+            expected);
+  EXPECT_EQ(string_map.entries().size(), 2);
+  EXPECT_EQ(string_map.entries().at("foo"), "2");
+
+  ::istio::mixer::v1::Attributes_StringMap tracing;
+  Envoy::Utils::FindHeaders(headers, {"x-b3-traceid", "x-b3-spanid"},
+                            &tracing);
+  EXPECT_EQ(tracing.entries().size(), 1);
+  EXPECT_EQ(tracing.entries().at("x-b3-traceid"), "abc");
+}
+
 TEST_P(UtilsTest, GetPrincipal) {
   std::vector<std::string> sans{"spiffe://foo/bar", "bad"};
   testGetPrincipal(sans, "foo/bar", true);
@@ -153,6 +179,30 @@ TEST_P(UtilsTest, GetTrustDomainNoSlash) {
   testGetTrustDomain(sans, "", false);
 }
 
+TEST_P(UtilsTest, ConnectionIdentity) {
+  NiceMock<Envoy::StreamInfo::MockStreamInfo> stream_info;
+  ON_CALL(connection_, streamInfo()).WillByDefault(ReturnRef(stream_info));
+  setMockSan({"spiffe://td/bar"});
+
+  const auto& identity = Envoy::Utils::ConnectionIdentity::get(connection_);
+  std::string principal, trust_domain;
+  EXPECT_TRUE(identity.principal(peer_, &principal));
+  EXPECT_EQ(principal, "td/bar");
+  EXPECT_TRUE(identity.trustDomain(peer_, &trust_domain));
+  EXPECT_EQ(trust_domain, "td");
+  EXPECT_FALSE(identity.principal(!peer_, &principal));
+  EXPECT_FALSE(identity.trustDomain(!peer_, &trust_domain));
+  EXPECT_TRUE(
+      stream_info.filterState().hasData<Envoy::Utils::ConnectionIdentity>(
+          Envoy::Utils::ConnectionIdentity::key()));
+
+  // The identity is extracted once per connection.
+  setMockSan({"spiffe://other/baz"});
+  EXPECT_EQ(&identity, &Envoy::Utils::ConnectionIdentity::get(connection_));
+  EXPECT_TRUE(identity.principal(peer_, &principal));
+  EXPECT_EQ(principal, "td/bar");
+}
+
 INSTANTIATE_TEST_SUITE_P(
     UtilsTestPrincipalAndTrustDomain, UtilsTest, testing::Values(true, false),
     [](const testing::TestParamInfo<UtilsTest::ParamType>& info) {
@@ -33,12 +33,44 @@ namespace {
 const std::set<std::string> kGrpcContentTypes{
     "application/grpc", "application/grpc+proto", "application/grpc+json"};
 
+// Adds entries to the string map attribute name with extract, which
+// returns false if it is not supported. The attribute is not added if it
+// has no entries.
+template <class Extract>
+bool ExtractStringMap(const std::string &name, Attributes *attributes,
+                      Extract extract) {
+  auto &attribute_map = *attributes->mutable_attributes();
+  Attributes_StringMap *map =
+      attribute_map[name].mutable_string_map_value();
+  const bool extracted = extract(map);
+  if (map->entries().empty()) {
+    attribute_map.erase(name);
+  }
+  return extracted;
+}
+
 }  // namespace
 
 void AttributesBuilder::ExtractRequestHeaderAttributes(CheckData *check_data) {
   utils::AttributesBuilder builder(attributes_);
-  std::map<std::string, std::string> headers = check_data->GetRequestHeaders();
-  builder.AddStringMap(utils::AttributeName::kRequestHeaders, headers);
+  utils::DeferredStringMapPtr deferred_headers;
+  if (shared_attributes_ != nullptr) {
+    deferred_headers = check_data->GetDeferredRequestHeaders();
+  }
+  if (deferred_headers) {
+    if (request_header_projection_) {
+      deferred_headers =
+          request_header_projection_->Apply(std::move(deferred_headers));
+    }
+    shared_attributes_->AddDeferredStringMap(
+        utils::AttributeName::kRequestHeaders, std::move(deferred_headers));
+  } else {
+    std::map<std::string, std::string> headers =
+        check_data->GetRequestHeaders();
+    builder.AddStringMap(utils::AttributeName::kRequestHeaders, headers);
+    ProjectStringMap(utils::AttributeName::kRequestHeaders,
+                     request_header_projection_);
+  }
 
   struct TopLevelAttr {
     CheckData::HeaderType header_type;
@@ -73,6 +105,16 @@ void AttributesBuilder::ExtractRequestHeaderAttributes(CheckData *check_data) {
     builder.AddString(utils::AttributeName::kRequestUrlPath, query_path);
   }
 
+  utils::DeferredStringMapPtr deferred_query_params;
+  if (shared_attributes_ != nullptr) {
+    deferred_query_params = check_data->GetDeferredRequestQueryParams();
+  }
+  if (deferred_query_params) {
+    shared_attributes_->AddDeferredStringMap(
+        utils::AttributeName::kRequestQueryParams,
+        std::move(deferred_query_params));
+    return;
+  }
   std::map<std::string, std::string> query_map;
   if (check_data->GetRequestQueryParams(&query_map) && query_map.size() > 0) {
     builder.AddStringMap(utils::AttributeName::kRequestQueryParams, query_map);
@@ -126,36 +168,34 @@ void AttributesBuilder::ExtractAuthAttributes(CheckData *check_data) {
   }
 }
 
-void AttributesBuilder::ExtractForwardedAttributes(CheckData *check_data) {
+void AttributesBuilder::ExtractForwardedAttributes(
+    CheckData *check_data, ForwardedAttributesCache *cache) {
   std::string forwarded_data;
   if (!check_data->ExtractIstioAttributes(&forwarded_data)) {
     return;
   }
 
-  Attributes v2_format;
-  if (!v2_format.ParseFromString(forwarded_data)) {
+  std::shared_ptr<const std::vector<std::string>> values;
+  if (cache != nullptr) {
+    values = cache->Decode(forwarded_data);
+  } else {
+    auto decoded = std::make_shared<std::vector<std::string>>();
+    if (DecodeForwardedAttributes(forwarded_data, ForwardedAttributeNames(),
+                                  decoded.get())) {
+      values = decoded;
+    }
+  }
+  if (!values) {
     return;
   }
 
-  static const std::set<std::string> kForwardWhitelist = {
-      utils::AttributeName::kSourceUID,
-      utils::AttributeName::kSourceNamespace,
-      utils::AttributeName::kDestinationServiceName,
-      utils::AttributeName::kDestinationServiceUID,
-      utils::AttributeName::kDestinationServiceHost,
-      utils::AttributeName::kDestinationServiceNamespace,
-  };
-
-  auto fwd = v2_format.attributes();
+  const auto &names = ForwardedAttributeNames();
   utils::AttributesBuilder builder(attributes_);
-  for (const auto &attribute : kForwardWhitelist) {
-    const auto &iter = fwd.find(attribute);
-    if (iter != fwd.end() && !iter->second.string_value().empty()) {
-      builder.AddString(attribute, iter->second.string_value());
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (!(*values)[i].empty()) {
+      builder.AddString(names[i], (*values)[i]);
     }
   }
-
-  return;
 }
 
 void AttributesBuilder::ExtractCheckAttributes(CheckData *check_data) {
@@ -201,6 +241,22 @@ void AttributesBuilder::ForwardAttributes(const Attributes &forward_attributes,
   header_update->AddIstioAttributes(str);
 }
 
+void AttributesBuilder::ProjectStringMap(const std::string &name,
+                                         const HeaderProjection *projection) {
+  if (projection == nullptr) {
+    return;
+  }
+  auto &attributes = *attributes_->mutable_attributes();
+  const auto it = attributes.find(name);
+  if (it == attributes.end()) {
+    return;
+  }
+  projection->Apply(it->second.mutable_string_map_value());
+  if (it->second.string_map_value().entries().empty()) {
+    attributes.erase(it);
+  }
+}
+
 void AttributesBuilder::ExtractReportAttributes(
     const ::google::protobuf::util::Status &status, ReportData *report_data) {
   utils::AttributesBuilder builder(attributes_);
@@ -222,14 +278,33 @@ void AttributesBuilder::ExtractReportAttributes(
     builder.AddString(utils::AttributeName::kDestinationUID, uid);
   }
 
-  std::map<std::string, std::string> headers =
-      report_data->GetResponseHeaders();
-  builder.AddStringMap(utils::AttributeName::kResponseHeaders, headers);
+  // The headers are added to the attributes directly if the report data
+  // supports it. An existing response.headers is only replaced by some
+  // headers, so it keeps the std::map path.
+  if (builder.HasAttribute(utils::AttributeName::kResponseHeaders) ||
+      !ExtractStringMap(utils::AttributeName::kResponseHeaders, attributes_,
+                        [report_data](Attributes_StringMap *headers) {
+                          return report_data->ExtractResponseHeaders(headers);
+                        })) {
+    std::map<std::string, std::string> headers =
+        report_data->GetResponseHeaders();
+    builder.AddStringMap(utils::AttributeName::kResponseHeaders, headers);
+  }
 
-  std::map<std::string, std::string> tracing_headers;
-  report_data->GetTracingHeaders(tracing_headers);
-  builder.InsertStringMap(utils::AttributeName::kRequestHeaders,
-                          tracing_headers);
+  // Tracing headers are inserted into request.headers.
+  if (!ExtractStringMap(utils::AttributeName::kRequestHeaders, attributes_,
+                        [report_data](Attributes_StringMap *headers) {
+                          return report_data->ExtractTracingHeaders(headers);
+                        })) {
+    std::map<std::string, std::string> tracing_headers;
+    report_data->GetTracingHeaders(tracing_headers);
+    builder.InsertStringMap(utils::AttributeName::kRequestHeaders,
+                            tracing_headers);
+  }
+  ProjectStringMap(utils::AttributeName::kResponseHeaders,
+                   response_header_projection_);
+  ProjectStringMap(utils::AttributeName::kRequestHeaders,
+                   request_header_projection_);
 
   builder.AddTimestamp(utils::AttributeName::kResponseTime,
                        std::chrono::system_clock::now());
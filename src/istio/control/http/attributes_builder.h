@@ -19,6 +19,9 @@
 #include "include/istio/control/http/check_data.h"
 #include "include/istio/control/http/report_data.h"
 #include "mixer/v1/attributes.pb.h"
+#include "src/istio/control/http/forwarded_attributes.h"
+#include "src/istio/control/http/header_projection.h"
+#include "src/istio/mixerclient/shared_attributes.h"
 
 namespace istio {
 namespace control {
@@ -28,10 +31,26 @@ namespace http {
 class AttributesBuilder {
  public:
   AttributesBuilder(istio::mixer::v1::Attributes* attributes)
-      : attributes_(attributes) {}
+      : attributes_(attributes), shared_attributes_(nullptr) {}
 
-  // Extract forwarded attributes from HTTP header.
-  void ExtractForwardedAttributes(CheckData* check_data);
+  // Request headers and queries are deferred when the check data supports
+  // it, the other attributes are added to the partial attributes.
+  AttributesBuilder(istio::mixerclient::SharedAttributes* shared_attributes)
+      : attributes_(shared_attributes->partial_attributes()),
+        shared_attributes_(shared_attributes) {}
+
+  // Only capture the allowed request and response headers, if the
+  // projection is not nullptr.
+  void SetHeaderProjections(const HeaderProjection* request,
+                            const HeaderProjection* response) {
+    request_header_projection_ = request;
+    response_header_projection_ = response;
+  }
+
+  // Extract forwarded attributes from HTTP header. The decoded attributes
+  // are looked up in the cache, if it is not nullptr.
+  void ExtractForwardedAttributes(CheckData* check_data,
+                                  ForwardedAttributesCache* cache = nullptr);
   // Forward attributes to upstream proxy.
   static void ForwardAttributes(
       const ::istio::mixer::v1::Attributes& attributes,
@@ -54,7 +73,14 @@ class AttributesBuilder {
   // not available.
   void ExtractAuthAttributes(CheckData* check_data);
 
+  // Apply the projection to the string map attribute name.
+  void ProjectStringMap(const std::string& name,
+                        const HeaderProjection* projection);
+
   istio::mixer::v1::Attributes* attributes_;
+  istio::mixerclient::SharedAttributes* shared_attributes_;
+  const HeaderProjection* request_header_projection_{};
+  const HeaderProjection* response_header_projection_{};
 };
 
 }  // namespace http
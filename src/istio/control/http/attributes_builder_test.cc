@@ -904,6 +904,91 @@ TEST(AttributesBuilderTest, TestReportAttributesWithDestIP) {
   EXPECT_THAT(attributes, EqualsAttribute(expected_attributes));
 }
 
+// The report data which adds the headers directly to the attributes.
+class ExtractingReportData : public ::testing::NiceMock<MockReportData> {
+ public:
+  bool ExtractResponseHeaders(Attributes_StringMap *headers) const override {
+    (*headers->mutable_entries())["server"] = "my-server";
+    return true;
+  }
+
+  bool ExtractTracingHeaders(Attributes_StringMap *headers) const override {
+    (*headers->mutable_entries())["x-b3-traceid"] = "abc";
+    return true;
+  }
+};
+
+TEST(AttributesBuilderTest, TestReportAttributesExtractHeaders) {
+  ExtractingReportData mock_data;
+  ::google::protobuf::Map<std::string, ::google::protobuf::Struct>
+      filter_metadata;
+  EXPECT_CALL(mock_data, GetResponseHeaders()).Times(0);
+  EXPECT_CALL(mock_data, GetTracingHeaders(_)).Times(0);
+  EXPECT_CALL(mock_data, GetDynamicFilterState())
+      .WillOnce(ReturnRef(filter_metadata));
+
+  istio::mixer::v1::Attributes attributes;
+  utils::AttributesBuilder(&attributes)
+      .AddStringMap(utils::AttributeName::kRequestHeaders,
+                    {{"x-b3-traceid", "old"}, {"user-agent", "chrome"}});
+  AttributesBuilder builder(&attributes);
+  builder.ExtractReportAttributes(::google::protobuf::util::Status::OK,
+                                  &mock_data);
+
+  const auto &response_headers =
+      attributes.attributes()
+          .at(utils::AttributeName::kResponseHeaders)
+          .string_map_value()
+          .entries();
+  EXPECT_EQ(response_headers.size(), 1);
+  EXPECT_EQ(response_headers.at("server"), "my-server");
+
+  // Tracing headers are inserted into the request headers.
+  const auto &request_headers = attributes.attributes()
+                                    .at(utils::AttributeName::kRequestHeaders)
+                                    .string_map_value()
+                                    .entries();
+  EXPECT_EQ(request_headers.size(), 2);
+  EXPECT_EQ(request_headers.at("x-b3-traceid"), "abc");
+  EXPECT_EQ(request_headers.at("user-agent"), "chrome");
+}
+
+TEST(AttributesBuilderTest, TestHeaderProjections) {
+  ExtractingReportData mock_data;
+  ::google::protobuf::Map<std::string, ::google::protobuf::Struct>
+      filter_metadata;
+  EXPECT_CALL(mock_data, GetDynamicFilterState())
+      .WillOnce(ReturnRef(filter_metadata));
+
+  uint64_t bytes_saved = 0;
+  HeaderProjection request_projection("User-Agent, x-b3-traceid",
+                                      &bytes_saved);
+  HeaderProjection response_projection("content-type", &bytes_saved);
+
+  istio::mixer::v1::Attributes attributes;
+  utils::AttributesBuilder(&attributes)
+      .AddStringMap(utils::AttributeName::kRequestHeaders,
+                    {{"user-agent", "chrome"}, {"cookie", "session=1"}});
+  AttributesBuilder builder(&attributes);
+  builder.SetHeaderProjections(&request_projection, &response_projection);
+  builder.ExtractReportAttributes(::google::protobuf::util::Status::OK,
+                                  &mock_data);
+
+  // No response header is allowed, the attribute is dropped.
+  EXPECT_EQ(attributes.attributes().count(
+                utils::AttributeName::kResponseHeaders),
+            0);
+  const auto &request_headers = attributes.attributes()
+                                    .at(utils::AttributeName::kRequestHeaders)
+                                    .string_map_value()
+                                    .entries();
+  EXPECT_EQ(request_headers.size(), 2);
+  EXPECT_EQ(request_headers.at("user-agent"), "chrome");
+  EXPECT_EQ(request_headers.at("x-b3-traceid"), "abc");
+  // "server: my-server" and "cookie: session=1" are dropped.
+  EXPECT_EQ(bytes_saved, 30);
+}
+
 }  // namespace
 }  // namespace http
 }  // namespace control
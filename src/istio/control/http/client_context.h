@@ -20,6 +20,7 @@
 #include "include/istio/utils/local_attributes.h"
 #include "mixer/v1/attributes.pb.h"
 #include "src/istio/control/client_context_base.h"
+#include "src/istio/control/http/forwarded_attributes.h"
 
 namespace istio {
 namespace control {
@@ -55,12 +56,51 @@ class ClientContext : public ClientContextBase {
   // Get the service config cache size
   int service_config_cache_size() const { return service_config_cache_size_; }
 
+  // The bytes of the headers dropped by the header projections.
+  uint64_t* header_bytes_saved() { return &header_bytes_saved_; }
+
+  // The decoded attributes forwarded by the downstream proxies.
+  ForwardedAttributesCache* forwarded_attributes_cache() {
+    return &forwarded_attributes_cache_;
+  }
+
+  // Count a request streamed while its Check call is pending, when the
+  // call is done.
+  void AddOptimisticStream(bool reset, uint64_t saved_ms) {
+    ++optimistic_streams_;
+    if (reset) {
+      ++optimistic_stream_resets_;
+    }
+    optimistic_streaming_saved_ms_ += saved_ms;
+  }
+
+  // Get statistics, with the bytes saved by the header projections and the
+  // optimistic streaming counters.
+  void GetStatistics(::istio::mixerclient::Statistics* stat) const {
+    ClientContextBase::GetStatistics(stat);
+    stat->total_header_bytes_saved_ = header_bytes_saved_;
+    stat->total_optimistic_streams_ = optimistic_streams_;
+    stat->total_optimistic_stream_resets_ = optimistic_stream_resets_;
+    stat->total_optimistic_streaming_saved_ms_ = optimistic_streaming_saved_ms_;
+  }
+
  private:
   // The http client config.
   const ::istio::mixer::v1::config::client::HttpClientConfig& config_;
 
   // The service config cache size
   int service_config_cache_size_;
+
+  // The bytes of the headers dropped by the header projections.
+  uint64_t header_bytes_saved_{0};
+
+  // The optimistic streaming counters.
+  uint64_t optimistic_streams_{0};
+  uint64_t optimistic_stream_resets_{0};
+  uint64_t optimistic_streaming_saved_ms_{0};
+
+  // The decoded attributes forwarded by the downstream proxies.
+  ForwardedAttributesCache forwarded_attributes_cache_;
 };
 
 }  // namespace http
@@ -36,9 +36,13 @@ ControllerImpl::ControllerImpl(std::shared_ptr<ClientContext> client_context)
     cache_size = kServiceContextCacheSize;
   }
   service_context_cache_.reset(new LRUCache(cache_size));
+  route_service_context_cache_.reset(new RouteLRUCache(cache_size));
 }
 
-ControllerImpl::~ControllerImpl() { service_context_cache_->RemoveAll(); }
+ControllerImpl::~ControllerImpl() {
+  service_context_cache_->RemoveAll();
+  route_service_context_cache_->RemoveAll();
+}
 
 bool ControllerImpl::LookupServiceConfig(const std::string& service_config_id) {
   LRUCache::ScopedLookup lookup(service_context_cache_.get(),
@@ -67,6 +71,22 @@ void ControllerImpl::GetStatistics(Statistics* stat) const {
 
 std::shared_ptr<ServiceContext> ControllerImpl::GetServiceContext(
     const PerRouteConfig& config) {
+  if (config.service_config != nullptr) {
+    {
+      RouteLRUCache::ScopedLookup lookup(route_service_context_cache_.get(),
+                                         config.service_config_hash);
+      if (lookup.Found()) {
+        return lookup.value()->service_context;
+      }
+    }
+    CacheElem* cache_elem = new CacheElem;
+    cache_elem->service_context = std::make_shared<ServiceContext>(
+        client_context_, config.service_config);
+    route_service_context_cache_->Insert(config.service_config_hash,
+                                         cache_elem, 1);
+    return cache_elem->service_context;
+  }
+
   if (!config.service_config_id.empty()) {
     LRUCache::ScopedLookup lookup(service_context_cache_.get(),
                                   config.service_config_id);
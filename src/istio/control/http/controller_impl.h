@@ -73,6 +73,11 @@ class ControllerImpl : public Controller {
   };
   using LRUCache = ::istio::utils::SimpleLRUCache<std::string, CacheElem>;
   std::unique_ptr<LRUCache> service_context_cache_;
+
+  // The service contexts of the per-route service configs passed by ID, in
+  // the same kind of LRU cache but with integer keys.
+  using RouteLRUCache = ::istio::utils::SimpleLRUCache<uint64_t, CacheElem>;
+  std::unique_ptr<RouteLRUCache> route_service_context_cache_;
 };
 
 }  // namespace http
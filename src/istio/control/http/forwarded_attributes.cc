@@ -0,0 +1,170 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/istio/control/http/forwarded_attributes.h"
+
+#include <functional>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "include/istio/utils/attribute_names.h"
+#include "mixer/v1/attributes.pb.h"
+
+using ::google::protobuf::io::CodedInputStream;
+using ::google::protobuf::internal::WireFormatLite;
+using ::istio::mixer::v1::Attributes;
+using ::istio::mixer::v1::Attributes_AttributeValue;
+
+namespace istio {
+namespace control {
+namespace http {
+namespace {
+
+// The field numbers of a map entry.
+const int kMapKeyFieldNumber = 1;
+const int kMapValueFieldNumber = 2;
+
+// Returns true if tag is a length delimited field_number.
+bool IsLengthDelimited(uint32_t tag, int field_number) {
+  return tag == WireFormatLite::MakeTag(
+                    field_number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+}
+
+// Reads an AttributeValue. *is_string is true if its value is a string,
+// which is the last of the oneof fields set.
+bool ReadAttributeValue(CodedInputStream *input, bool *is_string,
+                        std::string *string_value) {
+  *is_string = false;
+  string_value->clear();
+  while (uint32_t tag = input->ReadTag()) {
+    if (IsLengthDelimited(tag,
+                          Attributes_AttributeValue::kStringValueFieldNumber)) {
+      if (!WireFormatLite::ReadString(input, string_value)) {
+        return false;
+      }
+      *is_string = true;
+      continue;
+    }
+    // Another field of the value oneof replaces the string.
+    *is_string = false;
+    if (!WireFormatLite::SkipField(input, tag)) {
+      return false;
+    }
+  }
+  return input->ConsumedEntireMessage();
+}
+
+// Reads an entry of the attributes map.
+bool ReadAttributeEntry(CodedInputStream *input, std::string *name,
+                        bool *is_string, std::string *string_value) {
+  name->clear();
+  *is_string = false;
+  string_value->clear();
+  while (uint32_t tag = input->ReadTag()) {
+    if (IsLengthDelimited(tag, kMapKeyFieldNumber)) {
+      if (!WireFormatLite::ReadString(input, name)) {
+        return false;
+      }
+    } else if (IsLengthDelimited(tag, kMapValueFieldNumber)) {
+      uint32_t length;
+      if (!input->ReadVarint32(&length)) {
+        return false;
+      }
+      const auto limit = input->PushLimit(length);
+      if (!ReadAttributeValue(input, is_string, string_value)) {
+        return false;
+      }
+      input->PopLimit(limit);
+    } else if (!WireFormatLite::SkipField(input, tag)) {
+      return false;
+    }
+  }
+  return input->ConsumedEntireMessage();
+}
+
+}  // namespace
+
+const std::vector<std::string> &ForwardedAttributeNames() {
+  static const std::vector<std::string> kForwardWhitelist = {
+      utils::AttributeName::kSourceUID,
+      utils::AttributeName::kSourceNamespace,
+      utils::AttributeName::kDestinationServiceName,
+      utils::AttributeName::kDestinationServiceUID,
+      utils::AttributeName::kDestinationServiceHost,
+      utils::AttributeName::kDestinationServiceNamespace,
+  };
+  return kForwardWhitelist;
+}
+
+bool DecodeForwardedAttributes(const std::string &data,
+                               const std::vector<std::string> &names,
+                               std::vector<std::string> *values) {
+  values->assign(names.size(), std::string());
+  CodedInputStream input(reinterpret_cast<const uint8_t *>(data.data()),
+                         data.size());
+  std::string name;
+  bool is_string;
+  std::string string_value;
+  while (uint32_t tag = input.ReadTag()) {
+    if (!IsLengthDelimited(tag, Attributes::kAttributesFieldNumber)) {
+      if (!WireFormatLite::SkipField(&input, tag)) {
+        return false;
+      }
+      continue;
+    }
+    uint32_t length;
+    if (!input.ReadVarint32(&length)) {
+      return false;
+    }
+    const auto limit = input.PushLimit(length);
+    if (!ReadAttributeEntry(&input, &name, &is_string, &string_value)) {
+      return false;
+    }
+    input.PopLimit(limit);
+    // As when the map is parsed, the last entry of a name wins.
+    for (size_t i = 0; i < names.size(); ++i) {
+      if (names[i] == name) {
+        (*values)[i] = is_string ? string_value : std::string();
+        break;
+      }
+    }
+  }
+  return input.ConsumedEntireMessage();
+}
+
+ForwardedAttributesCache::ForwardedAttributesCache(int64_t max_entries)
+    : cache_(new LRUCache(max_entries)) {}
+
+std::shared_ptr<const std::vector<std::string>>
+ForwardedAttributesCache::Decode(const std::string &data) {
+  const std::size_t digest = std::hash<std::string>{}(data);
+  {
+    LRUCache::ScopedLookup lookup(cache_.get(), digest);
+    if (lookup.Found() && lookup.value()->data == data) {
+      return lookup.value()->values;
+    }
+  }
+  auto values = std::make_shared<std::vector<std::string>>();
+  if (!DecodeForwardedAttributes(data, ForwardedAttributeNames(),
+                                 values.get())) {
+    return nullptr;
+  }
+  cache_->Insert(digest, new Entry{data, values}, 1);
+  return values;
+}
+
+}  // namespace http
+}  // namespace control
+}  // namespace istio
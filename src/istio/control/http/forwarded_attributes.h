@@ -0,0 +1,78 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ISTIO_CONTROL_HTTP_FORWARDED_ATTRIBUTES_H
+#define ISTIO_CONTROL_HTTP_FORWARDED_ATTRIBUTES_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "include/istio/utils/simple_lru_cache.h"
+#include "include/istio/utils/simple_lru_cache_inl.h"
+
+namespace istio {
+namespace control {
+namespace http {
+
+// Number of decoded forwarded attributes a cache keeps.
+const int64_t kForwardedAttributesCacheSize = 100;
+
+// The attributes accepted from x-istio-attributes HTTP header.
+const std::vector<std::string> &ForwardedAttributeNames();
+
+// Decodes the string attributes of names from a serialized Attributes
+// message, without parsing the other attributes into a proto. values[i] is
+// the value of names[i], or empty if it is absent or not a string. Returns
+// false if data does not parse as Attributes.
+bool DecodeForwardedAttributes(const std::string &data,
+                               const std::vector<std::string> &names,
+                               std::vector<std::string> *values);
+
+// A bounded LRU cache of decoded forwarded attributes, keyed by the digest
+// of the serialized attributes. The attributes a proxy forwards are static
+// per route, so few values are seen. It is not thread-safe, there is one
+// per worker.
+class ForwardedAttributesCache {
+ public:
+  ForwardedAttributesCache(int64_t max_entries = kForwardedAttributesCacheSize);
+
+  ~ForwardedAttributesCache() { cache_->RemoveAll(); }
+
+  // Returns the values of ForwardedAttributeNames() in data, or nullptr if
+  // data does not parse.
+  std::shared_ptr<const std::vector<std::string>> Decode(
+      const std::string &data);
+
+  // Gets the number of cached values.
+  int64_t Size() const { return cache_->Size(); }
+
+ private:
+  // Keeps the data to tell digest collisions apart, and holds a shared_ptr
+  // so a hit stays valid if the entry is evicted.
+  struct Entry {
+    std::string data;
+    std::shared_ptr<const std::vector<std::string>> values;
+  };
+  using LRUCache = ::istio::utils::SimpleLRUCache<std::size_t, Entry>;
+
+  std::unique_ptr<LRUCache> cache_;
+};
+
+}  // namespace http
+}  // namespace control
+}  // namespace istio
+
+#endif  // ISTIO_CONTROL_HTTP_FORWARDED_ATTRIBUTES_H
@@ -0,0 +1,113 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/istio/control/http/forwarded_attributes.h"
+
+#include "gtest/gtest.h"
+#include "include/istio/utils/attribute_names.h"
+#include "mixer/v1/attributes.pb.h"
+
+using ::istio::mixer::v1::Attributes;
+
+namespace istio {
+namespace control {
+namespace http {
+namespace {
+
+const std::vector<std::string> kNames = {"a", "b", "c"};
+
+std::string Serialize(const Attributes &attributes) {
+  std::string data;
+  attributes.SerializeToString(&data);
+  return data;
+}
+
+TEST(ForwardedAttributesTest, DecodeStringAttributes) {
+  Attributes attributes;
+  auto &map = *attributes.mutable_attributes();
+  map["a"].set_string_value("a-value");
+  map["b"].set_int64_value(1);
+  map["other"].set_string_value("other-value");
+
+  std::vector<std::string> values;
+  EXPECT_TRUE(DecodeForwardedAttributes(Serialize(attributes), kNames,
+                                        &values));
+  EXPECT_EQ(values, std::vector<std::string>({"a-value", "", ""}));
+}
+
+TEST(ForwardedAttributesTest, DecodeLastEntryWins) {
+  Attributes first;
+  (*first.mutable_attributes())["a"].set_string_value("first");
+  (*first.mutable_attributes())["b"].set_string_value("first");
+  Attributes second;
+  (*second.mutable_attributes())["a"].set_string_value("second");
+  (*second.mutable_attributes())["b"].set_bool_value(true);
+
+  // Concatenated messages are merged, as by ParseFromString.
+  const std::string data = Serialize(first) + Serialize(second);
+  Attributes parsed;
+  ASSERT_TRUE(parsed.ParseFromString(data));
+
+  std::vector<std::string> values;
+  EXPECT_TRUE(DecodeForwardedAttributes(data, kNames, &values));
+  EXPECT_EQ(values[0], parsed.attributes().at("a").string_value());
+  EXPECT_EQ(values[1], parsed.attributes().at("b").string_value());
+  EXPECT_EQ(values, std::vector<std::string>({"second", "", ""}));
+}
+
+TEST(ForwardedAttributesTest, DecodeMalformed) {
+  Attributes attributes;
+  (*attributes.mutable_attributes())["a"].set_string_value("a-value");
+  const std::string data = Serialize(attributes);
+
+  std::vector<std::string> values;
+  EXPECT_FALSE(DecodeForwardedAttributes(data.substr(0, data.size() - 1),
+                                         kNames, &values));
+  EXPECT_FALSE(DecodeForwardedAttributes("\xff", kNames, &values));
+  EXPECT_TRUE(DecodeForwardedAttributes("", kNames, &values));
+  EXPECT_EQ(values, std::vector<std::string>(3));
+}
+
+TEST(ForwardedAttributesTest, Cache) {
+  Attributes attributes;
+  (*attributes.mutable_attributes())[utils::AttributeName::kSourceUID]
+      .set_string_value("uid");
+  const std::string data = Serialize(attributes);
+
+  ForwardedAttributesCache cache(1);
+  auto values = cache.Decode(data);
+  ASSERT_TRUE(values != nullptr);
+  EXPECT_EQ((*values)[0], "uid");
+  EXPECT_EQ(cache.Decode(data), values);
+  EXPECT_EQ(cache.Size(), 1);
+
+  // Malformed data is not cached.
+  EXPECT_EQ(cache.Decode("\xff"), nullptr);
+  EXPECT_EQ(cache.Size(), 1);
+
+  // The oldest value is evicted, and stays valid.
+  (*attributes.mutable_attributes())[utils::AttributeName::kSourceUID]
+      .set_string_value("other-uid");
+  auto other = cache.Decode(Serialize(attributes));
+  EXPECT_EQ((*other)[0], "other-uid");
+  EXPECT_EQ(cache.Size(), 1);
+  EXPECT_EQ((*values)[0], "uid");
+  EXPECT_NE(cache.Decode(data), values);
+}
+
+}  // namespace
+}  // namespace http
+}  // namespace control
+}  // namespace istio
@@ -0,0 +1,87 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/istio/control/http/header_projection.h"
+
+#include <cctype>
+
+using ::istio::mixer::v1::Attributes_StringMap;
+using ::istio::utils::DeferredStringMap;
+using ::istio::utils::DeferredStringMapPtr;
+
+namespace istio {
+namespace control {
+namespace http {
+namespace {
+
+// A deferred map with the allowed headers only.
+class ProjectedStringMap : public DeferredStringMap {
+ public:
+  ProjectedStringMap(DeferredStringMapPtr map,
+                     const HeaderProjection &projection)
+      : map_(std::move(map)), projection_(projection) {}
+
+  bool Find(const std::string &key, std::string *value) const override {
+    return projection_.Allows(key) && map_->Find(key, value);
+  }
+
+  void Build(Attributes_StringMap *map) const override {
+    map_->Build(map);
+    projection_.Apply(map);
+  }
+
+ private:
+  DeferredStringMapPtr map_;
+  const HeaderProjection &projection_;
+};
+
+}  // namespace
+
+HeaderProjection::HeaderProjection(const std::string &names,
+                                   uint64_t *bytes_saved)
+    : bytes_saved_(bytes_saved) {
+  std::string name;
+  for (size_t i = 0; i <= names.size(); ++i) {
+    if (i == names.size() || names[i] == ',') {
+      if (!name.empty()) {
+        names_.insert(name);
+        name.clear();
+      }
+    } else if (!isspace(names[i])) {
+      // Header names are lower case in the attributes.
+      name.push_back(tolower(names[i]));
+    }
+  }
+}
+
+void HeaderProjection::Apply(Attributes_StringMap *map) const {
+  auto *entries = map->mutable_entries();
+  for (auto it = entries->begin(); it != entries->end();) {
+    if (Allows(it->first)) {
+      ++it;
+    } else {
+      *bytes_saved_ += it->first.size() + it->second.size();
+      it = entries->erase(it);
+    }
+  }
+}
+
+DeferredStringMapPtr HeaderProjection::Apply(DeferredStringMapPtr map) const {
+  return DeferredStringMapPtr(new ProjectedStringMap(std::move(map), *this));
+}
+
+}  // namespace http
+}  // namespace control
+}  // namespace istio
@@ -0,0 +1,60 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ISTIO_CONTROL_HTTP_HEADER_PROJECTION_H
+#define ISTIO_CONTROL_HTTP_HEADER_PROJECTION_H
+
+#include <cstdint>
+#include <set>
+#include <string>
+
+#include "include/istio/utils/deferred_string_map.h"
+#include "mixer/v1/attributes.pb.h"
+
+namespace istio {
+namespace control {
+namespace http {
+
+// An allow-list of the headers captured in request.headers or
+// response.headers. The other headers are dropped, and their bytes are
+// added to a counter of the bytes saved.
+class HeaderProjection {
+ public:
+  // names is a comma separated list of header names. bytes_saved must
+  // outlive this object.
+  HeaderProjection(const std::string &names, uint64_t *bytes_saved);
+
+  bool Allows(const std::string &name) const {
+    return names_.count(name) > 0;
+  }
+
+  // Removes the headers which are not allowed from map.
+  void Apply(::istio::mixer::v1::Attributes_StringMap *map) const;
+
+  // Returns a deferred map which only has the allowed headers of map. This
+  // object must outlive it.
+  ::istio::utils::DeferredStringMapPtr Apply(
+      ::istio::utils::DeferredStringMapPtr map) const;
+
+ private:
+  std::set<std::string> names_;
+  uint64_t *bytes_saved_;
+};
+
+}  // namespace http
+}  // namespace control
+}  // namespace istio
+
+#endif  // ISTIO_CONTROL_HTTP_HEADER_PROJECTION_H
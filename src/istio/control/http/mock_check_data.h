@@ -56,6 +56,9 @@ class MockHeaderUpdate : public HeaderUpdate {
  public:
   MOCK_METHOD0(RemoveIstioAttributes, void());
   MOCK_METHOD1(AddIstioAttributes, void(const std::string &data));
+  MOCK_CONST_METHOD2(EncodeIstioAttributes,
+                     bool(const std::string &data, std::string *value));
+  MOCK_METHOD1(AddEncodedIstioAttributes, void(const std::string &value));
 };
 
 }  // namespace http
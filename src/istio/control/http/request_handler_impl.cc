@@ -44,8 +44,10 @@ void RequestHandlerImpl::AddForwardAttributes(CheckData* check_data) {
   forward_attributes_added_ = true;
 
   if (!service_context_->ignore_forwarded_attributes()) {
-    AttributesBuilder builder(attributes_->attributes());
-    builder.ExtractForwardedAttributes(check_data);
+    AttributesBuilder builder(attributes_->partial_attributes());
+    builder.ExtractForwardedAttributes(
+        check_data,
+        service_context_->client_context()->forwarded_attributes_cache());
   }
 }
 
@@ -57,13 +59,25 @@ void RequestHandlerImpl::AddCheckAttributes(CheckData* check_data) {
 
   if (service_context_->enable_mixer_check() ||
       service_context_->enable_mixer_report()) {
-    service_context_->AddStaticAttributes(attributes_->attributes());
+    service_context_->AddStaticAttributes(attributes_->partial_attributes());
 
-    AttributesBuilder builder(attributes_->attributes());
+    AttributesBuilder builder(attributes_.get());
+    builder.SetHeaderProjections(
+        service_context_->request_header_projection(),
+        service_context_->response_header_projection());
     builder.ExtractCheckAttributes(check_data);
   }
 }
 
+void RequestHandlerImpl::BuildDeferredAttributes() {
+  // The deferred attributes read the request headers, which the filters
+  // after this one may change, so they are built now if the report needs
+  // them.
+  if (service_context_->enable_mixer_report()) {
+    attributes_->attributes();
+  }
+}
+
 void RequestHandlerImpl::Check(CheckData* check_data,
                                HeaderUpdate* header_update,
                                const TransportCheckFunc& transport,
@@ -74,6 +88,7 @@ void RequestHandlerImpl::Check(CheckData* check_data,
   AddForwardAttributes(check_data);
   header_update->RemoveIstioAttributes();
   service_context_->InjectForwardedAttributes(header_update);
+  BuildDeferredAttributes();
 
   if (!service_context_->enable_mixer_check()) {
     check_context_->setFinalStatus(Status::OK, false);
@@ -81,11 +96,44 @@ void RequestHandlerImpl::Check(CheckData* check_data,
     return;
   }
 
-  service_context_->AddQuotas(attributes_->attributes(),
-                              check_context_->quotaRequirements());
+  if (service_context_->has_quotas()) {
+    service_context_->AddQuotas(attributes_->attributes(),
+                                check_context_->quotaRequirements());
+  }
+
+  if (!service_context_->optimistic_streaming()) {
+    service_context_->client_context()->SendCheck(transport, on_done,
+                                                  check_context_);
+    return;
+  }
+
+  // Count the time the request streamed, if it did, once the call is done.
+  // The handler outlives the call, which is cancelled when it is destroyed.
+  service_context_->client_context()->SendCheck(
+      transport,
+      [this, on_done](const CheckResponseInfo& info) {
+        if (optimistic_streaming_) {
+          const auto saved = std::chrono::steady_clock::now() -
+                             optimistic_streaming_start_;
+          service_context_->client_context()->AddOptimisticStream(
+              !info.status().ok() ||
+                  info.routeDirective().direct_response_code() != 0,
+              std::chrono::duration_cast<std::chrono::milliseconds>(saved)
+                  .count());
+          optimistic_streaming_ = false;
+        }
+        on_done(info);
+      },
+      check_context_);
+}
 
-  service_context_->client_context()->SendCheck(transport, on_done,
-                                                check_context_);
+bool RequestHandlerImpl::StartOptimisticStreaming() {
+  if (!service_context_->optimistic_streaming()) {
+    return false;
+  }
+  optimistic_streaming_ = true;
+  optimistic_streaming_start_ = std::chrono::steady_clock::now();
+  return true;
 }
 
 void RequestHandlerImpl::ResetCancel() {
@@ -110,7 +158,9 @@ void RequestHandlerImpl::Report(CheckData* check_data,
   AddForwardAttributes(check_data);
   AddCheckAttributes(check_data);
 
-  AttributesBuilder builder(attributes_->attributes());
+  AttributesBuilder builder(attributes_->partial_attributes());
+  builder.SetHeaderProjections(service_context_->request_header_projection(),
+                               service_context_->response_header_projection());
   builder.ExtractReportAttributes(check_context_->status(), report_data);
 
   service_context_->client_context()->SendReport(attributes_);
@@ -16,6 +16,8 @@
 #ifndef ISTIO_CONTROL_HTTP_REQUEST_HANDLER_IMPL_H
 #define ISTIO_CONTROL_HTTP_REQUEST_HANDLER_IMPL_H
 
+#include <chrono>
+
 #include "include/istio/control/http/request_handler.h"
 #include "src/istio/control/http/client_context.h"
 #include "src/istio/control/http/service_context.h"
@@ -30,7 +32,9 @@ class RequestHandlerImpl : public RequestHandler {
  public:
   RequestHandlerImpl(std::shared_ptr<ServiceContext> service_context);
 
-  virtual ~RequestHandlerImpl() = default;
+  // The deferred attributes which are not built yet are dropped, the
+  // request they read may be gone.
+  virtual ~RequestHandlerImpl() { attributes_->DropDeferred(); }
 
   // Makes a Check call.
   void Check(CheckData* check_data, HeaderUpdate* header_update,
@@ -41,6 +45,8 @@ class RequestHandlerImpl : public RequestHandler {
 
   void CancelCheck() override;
 
+  bool StartOptimisticStreaming() override;
+
   // Make a Report call.
   void Report(CheckData* check_data, ReportData* report_data) override;
 
@@ -49,6 +55,8 @@ class RequestHandlerImpl : public RequestHandler {
   void AddForwardAttributes(CheckData* check_data);
   // Add check attributes, allow re-entry
   void AddCheckAttributes(CheckData* check_data);
+  // Build the deferred attributes if the report needs them.
+  void BuildDeferredAttributes();
 
   // memory for telemetry reports and policy checks.  Telemetry only needs the
   // shared attributes.
@@ -60,6 +68,11 @@ class RequestHandlerImpl : public RequestHandler {
 
   bool check_attributes_added_{false};
   bool forward_attributes_added_{false};
+
+  // Whether the request streams while the Check call is pending, and since
+  // when.
+  bool optimistic_streaming_{false};
+  std::chrono::steady_clock::time_point optimistic_streaming_start_;
 };
 
 }  // namespace http
@@ -35,9 +35,12 @@ using ::istio::mixerclient::DoneFunc;
 using ::istio::mixerclient::MixerClient;
 using ::istio::mixerclient::TransportCheckFunc;
 using ::istio::quota_config::Requirement;
+using ::istio::utils::DeferredStringMap;
+using ::istio::utils::DeferredStringMapPtr;
 using ::istio::utils::LocalAttributes;
 
 using ::testing::_;
+using ::testing::AnyNumber;
 using ::testing::Invoke;
 using ::testing::ReturnRef;
 
@@ -229,6 +232,38 @@ class OutboundRequestHandlerImplTest : public RequestHandlerImplTest {
   OutboundRequestHandlerImplTest() : RequestHandlerImplTest(true) {}
 };
 
+// A deferred request.headers which counts how often it is built.
+class CountingHeaders : public DeferredStringMap {
+ public:
+  CountingHeaders(int *build_count) : build_count_(build_count) {}
+
+  bool Find(const std::string &key, std::string *value) const override {
+    if (key != "user-agent") {
+      return false;
+    }
+    *value = "chrome";
+    return true;
+  }
+
+  void Build(::istio::mixer::v1::Attributes_StringMap *map) const override {
+    ++*build_count_;
+    (*map->mutable_entries())["user-agent"] = "chrome";
+  }
+
+ private:
+  int *build_count_;
+};
+
+// The check data which defers request.headers.
+class DeferredCheckData : public ::testing::NiceMock<MockCheckData> {
+ public:
+  DeferredStringMapPtr GetDeferredRequestHeaders() const override {
+    return DeferredStringMapPtr(new CountingHeaders(&build_count));
+  }
+
+  mutable int build_count = 0;
+};
+
 TEST_F(RequestHandlerImplTest, TestServiceConfigManage) {
   EXPECT_FALSE(controller_->LookupServiceConfig("1111"));
   ServiceConfig config;
@@ -247,6 +282,40 @@ TEST_F(RequestHandlerImplTest, TestServiceConfigManage) {
   EXPECT_TRUE(controller_->LookupServiceConfig("4444"));
 }
 
+TEST_F(RequestHandlerImplTest, TestServiceConfigByHash) {
+  ::testing::NiceMock<MockCheckData> mock_data;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+  EXPECT_CALL(*mock_client_, Check(_, _, _))
+      .Times(2)
+      .WillRepeatedly(Invoke([](CheckContextSharedPtr &context,
+                                const TransportCheckFunc &transport,
+                                const CheckDoneFunc &on_done) {
+        auto map = context->attributes()->attributes();
+        EXPECT_EQ(map["route-key"].string_value(), "route-value");
+      }));
+
+  // The service context is created once for the hash, so the forwarded
+  // attributes are only encoded once.
+  EXPECT_CALL(mock_header, EncodeIstioAttributes(_, _))
+      .WillOnce(Invoke([](const std::string &data, std::string *value) {
+        *value = "encoded";
+        return true;
+      }));
+
+  ServiceConfig config;
+  (*config.mutable_mixer_attributes()->mutable_attributes())["route-key"]
+      .set_string_value("route-value");
+  Controller::PerRouteConfig per_route;
+  per_route.service_config = &config;
+  per_route.service_config_hash = 1111;
+
+  for (int i = 0; i < 2; ++i) {
+    auto handler = controller_->CreateRequestHandler(per_route);
+    handler->Check(&mock_data, &mock_header, nullptr, nullptr);
+  }
+  EXPECT_FALSE(controller_->LookupServiceConfig("1111"));
+}
+
 TEST_F(RequestHandlerImplTest, TestHandlerDisabledCheckReport) {
   ::testing::NiceMock<MockCheckData> mock_data;
   ::testing::NiceMock<MockHeaderUpdate> mock_header;
@@ -384,6 +453,32 @@ TEST_F(RequestHandlerImplTest, TestRouteAttributes) {
   handler->Check(&mock_data, &mock_header, nullptr, nullptr);
 }
 
+TEST_F(RequestHandlerImplTest, TestForwardedAttributesEncodedOnce) {
+  ::testing::NiceMock<MockCheckData> mock_data;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+  EXPECT_CALL(*mock_client_, Check(_, _, _)).Times(2);
+
+  // The forwarded attributes of a route are encoded by the first request,
+  // and the encoded value is reused by the next ones.
+  EXPECT_CALL(mock_header, EncodeIstioAttributes(_, _))
+      .WillOnce(Invoke([](const std::string &data, std::string *value) {
+        Attributes forwarded_attr;
+        EXPECT_TRUE(forwarded_attr.ParseFromString(data));
+        auto map = forwarded_attr.attributes();
+        EXPECT_EQ(map["source-key-override"].string_value(), "service-value");
+        *value = "encoded";
+        return true;
+      }));
+  EXPECT_CALL(mock_header, AddEncodedIstioAttributes("encoded")).Times(2);
+  EXPECT_CALL(mock_header, AddIstioAttributes(_)).Times(0);
+
+  Controller::PerRouteConfig config;
+  for (int i = 0; i < 2; ++i) {
+    auto handler = controller_->CreateRequestHandler(config);
+    handler->Check(&mock_data, &mock_header, nullptr, nullptr);
+  }
+}
+
 TEST_F(RequestHandlerImplTest, TestPerRouteQuota) {
   ::testing::NiceMock<MockCheckData> mock_data;
   ::testing::NiceMock<MockHeaderUpdate> mock_header;
@@ -428,6 +523,155 @@ TEST_F(RequestHandlerImplTest, TestHandlerCheck) {
   handler->Check(&mock_data, &mock_header, nullptr, nullptr);
 }
 
+TEST_F(RequestHandlerImplTest, TestHandlerCheckDeferredHeaders) {
+  DeferredCheckData mock_data;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+  EXPECT_CALL(mock_data, GetRequestHeaders()).Times(0);
+
+  // request.headers is deferred, it is not needed to send a check.
+  EXPECT_CALL(*mock_client_, Check(_, _, _))
+      .WillOnce(Invoke([](CheckContextSharedPtr &context,
+                          const TransportCheckFunc &transport,
+                          const CheckDoneFunc &on_done) {
+        auto map = context->attributes()->attributes();
+        EXPECT_EQ(map[utils::AttributeName::kRequestHeaders]
+                      .string_map_value()
+                      .entries()
+                      .at("user-agent"),
+                  "chrome");
+      }));
+
+  ServiceConfig config;
+  config.set_disable_report_calls(true);
+  Controller::PerRouteConfig per_route;
+  ApplyPerRouteConfig(config, &per_route);
+
+  auto handler = controller_->CreateRequestHandler(per_route);
+  handler->Check(&mock_data, &mock_header, nullptr, nullptr);
+  EXPECT_EQ(mock_data.build_count, 1);
+}
+
+TEST_F(RequestHandlerImplTest, TestHandlerCheckDeferredHeadersNotBuilt) {
+  DeferredCheckData mock_data;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+  EXPECT_CALL(mock_data, GetRequestHeaders()).Times(0);
+
+  // The check is answered without reading the attributes, e.g. by the check
+  // cache, and there is no report, so request.headers is never built.
+  EXPECT_CALL(*mock_client_, Check(_, _, _)).Times(1);
+
+  ServiceConfig config;
+  config.set_disable_report_calls(true);
+  Controller::PerRouteConfig per_route;
+  ApplyPerRouteConfig(config, &per_route);
+
+  auto handler = controller_->CreateRequestHandler(per_route);
+  handler->Check(&mock_data, &mock_header, nullptr, nullptr);
+  handler.reset();
+  EXPECT_EQ(mock_data.build_count, 0);
+}
+
+TEST_F(RequestHandlerImplTest, TestHandlerCheckDeferredHeadersReport) {
+  DeferredCheckData mock_data;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+  EXPECT_CALL(*mock_client_, Check(_, _, _)).Times(1);
+
+  ServiceConfig config;
+  Controller::PerRouteConfig per_route;
+  ApplyPerRouteConfig(config, &per_route);
+
+  // The report needs request.headers, it is built before Check() returns
+  // since later filters may change the headers.
+  auto handler = controller_->CreateRequestHandler(per_route);
+  handler->Check(&mock_data, &mock_header, nullptr, nullptr);
+  EXPECT_EQ(mock_data.build_count, 1);
+}
+
+TEST_F(RequestHandlerImplTest, TestHeaderProjection) {
+  DeferredCheckData mock_data;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+
+  // Only x-request-id is captured, and the projection is not an attribute.
+  EXPECT_CALL(*mock_client_, Check(_, _, _))
+      .WillOnce(Invoke([](CheckContextSharedPtr &context,
+                          const TransportCheckFunc &transport,
+                          const CheckDoneFunc &on_done) {
+        const auto &map = context->attributes()->attributes();
+        EXPECT_EQ(map.count(utils::AttributeName::kRequestHeaders), 0);
+        EXPECT_EQ(map.count("istio.request_header_projection"), 0);
+        EXPECT_EQ(map.at("per-route-key").string_value(), "per-route-value");
+      }));
+
+  ServiceConfig config;
+  auto *attributes = config.mutable_mixer_attributes()->mutable_attributes();
+  (*attributes)["istio.request_header_projection"].set_string_value(
+      "x-request-id");
+  (*attributes)["per-route-key"].set_string_value("per-route-value");
+  config.set_disable_report_calls(true);
+  Controller::PerRouteConfig per_route;
+  ApplyPerRouteConfig(config, &per_route);
+
+  auto handler = controller_->CreateRequestHandler(per_route);
+  handler->Check(&mock_data, &mock_header, nullptr, nullptr);
+
+  // The dropped "user-agent: chrome" header is reported as saved.
+  ::istio::mixerclient::Statistics stat;
+  controller_->GetStatistics(&stat);
+  EXPECT_EQ(stat.total_header_bytes_saved_, 16);
+}
+
+TEST_F(RequestHandlerImplTest, TestOptimisticStreaming) {
+  ::testing::NiceMock<MockCheckData> mock_data;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+
+  // The setting is not an attribute.
+  CheckContextSharedPtr check_context;
+  CheckDoneFunc check_done;
+  EXPECT_CALL(*mock_client_, Check(_, _, _))
+      .WillOnce(Invoke([&](CheckContextSharedPtr &context,
+                           const TransportCheckFunc &transport,
+                           const CheckDoneFunc &on_done) {
+        EXPECT_EQ(context->attributes()->attributes().count(
+                      "istio.optimistic_streaming"),
+                  0);
+        check_context = context;
+        check_done = on_done;
+      }));
+
+  ServiceConfig config;
+  (*config.mutable_mixer_attributes()
+        ->mutable_attributes())["istio.optimistic_streaming"]
+      .set_bool_value(true);
+  Controller::PerRouteConfig per_route;
+  ApplyPerRouteConfig(config, &per_route);
+
+  int done_count = 0;
+  auto handler = controller_->CreateRequestHandler(per_route);
+  handler->Check(&mock_data, &mock_header, nullptr,
+                 [&done_count](const CheckResponseInfo &) { ++done_count; });
+  EXPECT_TRUE(handler->StartOptimisticStreaming());
+
+  // The denied request is counted once its check is done.
+  check_context->setFinalStatus(
+      Status(::google::protobuf::util::error::PERMISSION_DENIED, ""), false);
+  check_done(*check_context);
+  EXPECT_EQ(done_count, 1);
+
+  ::istio::mixerclient::Statistics stat;
+  controller_->GetStatistics(&stat);
+  EXPECT_EQ(stat.total_optimistic_streams_, 1);
+  EXPECT_EQ(stat.total_optimistic_stream_resets_, 1);
+}
+
+TEST_F(RequestHandlerImplTest, TestOptimisticStreamingDisabled) {
+  ServiceConfig config;
+  Controller::PerRouteConfig per_route;
+  ApplyPerRouteConfig(config, &per_route);
+
+  auto handler = controller_->CreateRequestHandler(per_route);
+  EXPECT_FALSE(handler->StartOptimisticStreaming());
+}
+
 TEST_F(RequestHandlerImplTest, TestHandlerReport) {
   ::testing::NiceMock<MockCheckData> mock_check;
   ::testing::NiceMock<MockReportData> mock_report;
@@ -451,6 +695,38 @@ TEST_F(RequestHandlerImplTest, TestHandlerReport) {
   handler->Report(&mock_check, &mock_report);
 }
 
+TEST_F(RequestHandlerImplTest, TestHandlerCheckAndReportParseOnce) {
+  ::testing::NiceMock<MockCheckData> mock_check;
+  ::testing::NiceMock<MockHeaderUpdate> mock_header;
+  ::testing::NiceMock<MockReportData> mock_report;
+  ::google::protobuf::Map<std::string, ::google::protobuf::Struct>
+      filter_metadata;
+  ON_CALL(mock_report, GetDynamicFilterState())
+      .WillByDefault(ReturnRef(filter_metadata));
+
+  // The request is parsed once per stream, by Check, and Report reuses the
+  // attributes.
+  EXPECT_CALL(mock_check, ExtractIstioAttributes(_)).Times(1);
+  EXPECT_CALL(mock_check, GetRequestHeaders()).Times(1);
+  EXPECT_CALL(mock_check, GetUrlPath(_)).Times(1);
+  EXPECT_CALL(mock_check, GetRequestQueryParams(_)).Times(1);
+  EXPECT_CALL(mock_check, GetSourceIpPort(_, _)).Times(1);
+  EXPECT_CALL(mock_check, GetPrincipal(_, _)).Times(2);
+  EXPECT_CALL(mock_check, FindHeaderByType(_, _)).Times(AnyNumber());
+  EXPECT_CALL(mock_check, FindHeaderByType(CheckData::HEADER_HOST, _))
+      .Times(1);
+  EXPECT_CALL(*mock_client_, Check(_, _, _)).Times(1);
+  EXPECT_CALL(*mock_client_, Report(_)).Times(1);
+
+  ServiceConfig config;
+  Controller::PerRouteConfig per_route;
+  ApplyPerRouteConfig(config, &per_route);
+
+  auto handler = controller_->CreateRequestHandler(per_route);
+  handler->Check(&mock_check, &mock_header, nullptr, nullptr);
+  handler->Report(&mock_check, &mock_report);
+}
+
 TEST_F(RequestHandlerImplTest, TestHandlerDisabledReport) {
   ::testing::NiceMock<MockCheckData> mock_check;
   ::testing::NiceMock<MockReportData> mock_report;
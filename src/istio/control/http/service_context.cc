@@ -16,7 +16,6 @@
 #include "service_context.h"
 
 #include "include/istio/utils/attribute_names.h"
-#include "src/istio/control/http/attributes_builder.h"
 
 using ::istio::mixer::v1::Attributes;
 using ::istio::mixer::v1::config::client::ServiceConfig;
@@ -24,6 +23,20 @@ using ::istio::mixer::v1::config::client::ServiceConfig;
 namespace istio {
 namespace control {
 namespace http {
+namespace {
+
+// The mixer_attributes of a service config which set the header
+// projections, as comma separated lists of header names. They are not
+// sent to Mixer.
+const char kRequestHeaderProjection[] = "istio.request_header_projection";
+const char kResponseHeaderProjection[] = "istio.response_header_projection";
+
+// The mixer_attribute of a service config which lets the request body
+// stream upstream while the Check call is pending, if its bool_value is
+// true. It is not sent to Mixer.
+const char kOptimisticStreaming[] = "istio.optimistic_streaming";
+
+}  // namespace
 
 ServiceContext::ServiceContext(std::shared_ptr<ClientContext> client_context,
                                const ServiceConfig *config)
@@ -32,6 +45,42 @@ ServiceContext::ServiceContext(std::shared_ptr<ClientContext> client_context,
     service_config_.reset(new ServiceConfig(*config));
   }
   BuildParsers();
+  BuildHeaderProjections();
+  ReadOptimisticStreaming();
+  BuildForwardedAttributes();
+}
+
+void ServiceContext::BuildHeaderProjections() {
+  if (!service_config_ || !service_config_->has_mixer_attributes()) {
+    return;
+  }
+  auto *attributes =
+      service_config_->mutable_mixer_attributes()->mutable_attributes();
+  auto build = [this, attributes](const std::string &name,
+                                  std::unique_ptr<HeaderProjection> *out) {
+    const auto it = attributes->find(name);
+    if (it == attributes->end()) {
+      return;
+    }
+    out->reset(new HeaderProjection(it->second.string_value(),
+                                    client_context_->header_bytes_saved()));
+    attributes->erase(it);
+  };
+  build(kRequestHeaderProjection, &request_header_projection_);
+  build(kResponseHeaderProjection, &response_header_projection_);
+}
+
+void ServiceContext::ReadOptimisticStreaming() {
+  if (!service_config_ || !service_config_->has_mixer_attributes()) {
+    return;
+  }
+  auto *attributes =
+      service_config_->mutable_mixer_attributes()->mutable_attributes();
+  const auto it = attributes->find(kOptimisticStreaming);
+  if (it != attributes->end()) {
+    optimistic_streaming_ = it->second.bool_value();
+    attributes->erase(it);
+  }
 }
 
 void ServiceContext::BuildParsers() {
@@ -58,9 +107,7 @@ void ServiceContext::AddStaticAttributes(
   }
 }
 
-// Inject a header that contains the static forwarded attributes.
-void ServiceContext::InjectForwardedAttributes(
-    HeaderUpdate *header_update) const {
+void ServiceContext::BuildForwardedAttributes() {
   Attributes attributes;
 
   client_context_->AddLocalNodeForwardAttribues(&attributes);
@@ -73,8 +120,23 @@ void ServiceContext::InjectForwardedAttributes(
   }
 
   if (!attributes.attributes().empty()) {
-    AttributesBuilder::ForwardAttributes(attributes, header_update);
+    attributes.SerializeToString(&forwarded_attributes_);
+  }
+}
+
+// Inject a header that contains the static forwarded attributes.
+void ServiceContext::InjectForwardedAttributes(
+    HeaderUpdate *header_update) const {
+  if (forwarded_attributes_.empty()) {
+    return;
+  }
+  if (encoded_forwarded_attributes_.empty() &&
+      !header_update->EncodeIstioAttributes(forwarded_attributes_,
+                                            &encoded_forwarded_attributes_)) {
+    header_update->AddIstioAttributes(forwarded_attributes_);
+    return;
   }
+  header_update->AddEncodedIstioAttributes(encoded_forwarded_attributes_);
 }
 
 // Add quota requirements from quota configs.
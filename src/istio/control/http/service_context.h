@@ -20,6 +20,7 @@
 #include "include/istio/quota_config/config_parser.h"
 #include "mixer/v1/attributes.pb.h"
 #include "src/istio/control/http/client_context.h"
+#include "src/istio/control/http/header_projection.h"
 
 namespace istio {
 namespace control {
@@ -46,6 +47,9 @@ class ServiceContext {
   void AddQuotas(::istio::mixer::v1::Attributes* attributes,
                  std::vector<::istio::quota_config::Requirement>& quotas) const;
 
+  // Returns true if there are quota configs.
+  bool has_quotas() const { return !quota_parsers_.empty(); }
+
   bool enable_mixer_check() const {
     return service_config_ && !service_config_->disable_check_calls();
   }
@@ -57,10 +61,34 @@ class ServiceContext {
     return client_context_->config().ignore_forwarded_attributes();
   }
 
+  // The allow-lists of request and response headers, or nullptr to capture
+  // all headers.
+  const HeaderProjection* request_header_projection() const {
+    return request_header_projection_.get();
+  }
+  const HeaderProjection* response_header_projection() const {
+    return response_header_projection_.get();
+  }
+
+  // Whether the request body may stream upstream while the Check call is
+  // pending.
+  bool optimistic_streaming() const { return optimistic_streaming_; }
+
  private:
   // Pre-process the config data to build parser objects.
   void BuildParsers();
 
+  // Build the header projections, and remove their settings from the
+  // static attributes.
+  void BuildHeaderProjections();
+
+  // Read the optimistic streaming setting, and remove it from the static
+  // attributes.
+  void ReadOptimisticStreaming();
+
+  // Serialize the static forwarded attributes.
+  void BuildForwardedAttributes();
+
   // The client context object.
   std::shared_ptr<ClientContext> client_context_;
 
@@ -68,6 +96,19 @@ class ServiceContext {
   std::vector<std::unique_ptr<::istio::quota_config::ConfigParser>>
       quota_parsers_;
 
+  // The header projections.
+  std::unique_ptr<HeaderProjection> request_header_projection_;
+  std::unique_ptr<HeaderProjection> response_header_projection_;
+
+  // Whether the request body may stream while the Check call is pending.
+  bool optimistic_streaming_{false};
+
+  // The serialized forwarded attributes, empty if none are forwarded.
+  std::string forwarded_attributes_;
+  // Their header value, encoded on first use. A ServiceContext is only used
+  // by one worker thread.
+  mutable std::string encoded_forwarded_attributes_;
+
   // The service config.
   std::unique_ptr<::istio::mixer::v1::config::client::ServiceConfig>
       service_config_;
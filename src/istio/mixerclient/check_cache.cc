@@ -40,7 +40,8 @@ void CheckCache::CacheElem::CacheElem::SetResponse(
       expire_time_ = time_point<system_clock>::max();
     }
     use_count_ = response.precondition().valid_use_count();
-    route_directive_ = response.precondition().route_directive();
+    route_directive_ =
+        ShareRouteDirective(response.precondition().route_directive());
   } else {
     status_ = Status(Code::INVALID_ARGUMENT,
                      "CheckResponse doesn't have PreconditionResult");
@@ -60,6 +61,14 @@ bool CheckCache::CacheElem::CacheElem::IsExpired(Tick time_now) {
   return false;
 }
 
+SharedRouteDirectivePtr CheckCache::ShareRouteDirective(
+    const ::istio::mixer::v1::RouteDirective &directive) {
+  if (directive.ByteSizeLong() == 0) {
+    return nullptr;
+  }
+  return std::make_shared<const SharedRouteDirective>(directive);
+}
+
 CheckCache::CheckResult::CheckResult() : status_(Code::UNAVAILABLE, "") {}
 
 bool CheckCache::CheckResult::IsCacheHit() const {
@@ -78,7 +87,13 @@ CheckCache::~CheckCache() {
 }
 
 void CheckCache::Check(const Attributes &attributes, CheckResult *result) {
-  Status status = Check(attributes, system_clock::now(), result);
+  Check(attributes, nullptr, result);
+}
+
+void CheckCache::Check(const Attributes &attributes,
+                       const utils::DeferredStringMaps *deferred,
+                       CheckResult *result) {
+  Status status = Check(attributes, system_clock::now(), result, deferred);
   if (status.error_code() != Code::NOT_FOUND) {
     result->status_ = status;
   }
@@ -99,7 +114,8 @@ void CheckCache::Check(const Attributes &attributes, CheckResult *result) {
 }
 
 Status CheckCache::Check(const Attributes &attributes, Tick time_now,
-                         CheckResult *result) {
+                         CheckResult *result,
+                         const utils::DeferredStringMaps *deferred) {
   if (!cache_) {
     // By returning NOT_FOUND, caller will send request to server.
     return Status(Code::NOT_FOUND, "");
@@ -109,7 +125,7 @@ Status CheckCache::Check(const Attributes &attributes, Tick time_now,
   for (const auto &it : referenced_map_) {
     const Referenced &reference = it.second;
     utils::HashType signature;
-    if (!reference.Signature(attributes, "", &signature)) {
+    if (!reference.Signature(attributes, deferred, "", &signature)) {
       continue;
     }
 
@@ -25,6 +25,7 @@
 #include <utility>
 
 #include "google/protobuf/stubs/status.h"
+#include "include/istio/mixerclient/check_response.h"
 #include "include/istio/mixerclient/options.h"
 #include "include/istio/utils/simple_lru_cache.h"
 #include "include/istio/utils/simple_lru_cache_inl.h"
@@ -56,6 +57,14 @@ class CheckCache {
     const ::google::protobuf::util::Status& status() const { return status_; }
 
     const ::istio::mixer::v1::RouteDirective& route_directive() const {
+      return route_directive_
+                 ? route_directive_->directive()
+                 : ::istio::mixer::v1::RouteDirective::default_instance();
+    }
+
+    // The route directive, or nullptr if it is empty. On a cache hit, it is
+    // shared with the cache entry.
+    const SharedRouteDirectivePtr& shared_route_directive() const {
       return route_directive_;
     }
 
@@ -66,7 +75,8 @@ class CheckCache {
         status_ = on_response_(status, attributes, response);
       }
       if (response.has_precondition()) {
-        route_directive_ = response.precondition().route_directive();
+        route_directive_ =
+            ShareRouteDirective(response.precondition().route_directive());
       }
     }
 
@@ -76,7 +86,7 @@ class CheckCache {
     ::google::protobuf::util::Status status_;
 
     // Route directive
-    ::istio::mixer::v1::RouteDirective route_directive_;
+    SharedRouteDirectivePtr route_directive_;
 
     // The function to set check response.
     using OnResponseFunc = std::function<::google::protobuf::util::Status(
@@ -89,6 +99,11 @@ class CheckCache {
   void Check(const ::istio::mixer::v1::Attributes& attributes,
              CheckResult* result);
 
+  // Same as above, for attributes whose deferred string maps are not built.
+  // They are only looked up for the referenced entries.
+  void Check(const ::istio::mixer::v1::Attributes& attributes,
+             const utils::DeferredStringMaps* deferred, CheckResult* result);
+
  private:
   friend class CheckCacheTest;
   using Tick = std::chrono::time_point<std::chrono::system_clock>;
@@ -97,7 +112,7 @@ class CheckCache {
   // caller has to send the request to mixer.
   ::google::protobuf::util::Status Check(
       const ::istio::mixer::v1::Attributes& request, Tick time_now,
-      CheckResult* result);
+      CheckResult* result, const utils::DeferredStringMaps* deferred = nullptr);
 
   // Caches a response from a remote mixer call.
   // Return the converted status from response.
@@ -109,6 +124,10 @@ class CheckCache {
   // Usually called at destructor.
   ::google::protobuf::util::Status FlushAll();
 
+  // Returns the directive to share, or nullptr if it is empty.
+  static SharedRouteDirectivePtr ShareRouteDirective(
+      const ::istio::mixer::v1::RouteDirective& directive);
+
   // Convert from grpc status to protobuf status.
   ::google::protobuf::util::Status ConvertRpcStatus(
       const ::google::rpc::Status& status) const;
@@ -132,7 +151,7 @@ class CheckCache {
     ::google::protobuf::util::Status status() const { return status_; }
 
     // getter for the route directive
-    ::istio::mixer::v1::RouteDirective route_directive() const {
+    const SharedRouteDirectivePtr& route_directive() const {
       return route_directive_;
     }
 
@@ -141,8 +160,8 @@ class CheckCache {
     const CheckCache& parent_;
     // The check status for the last check request.
     ::google::protobuf::util::Status status_;
-    // Route directive
-    ::istio::mixer::v1::RouteDirective route_directive_;
+    // Route directive, shared with the cache hits.
+    SharedRouteDirectivePtr route_directive_;
     // Cache item should not be used after it is expired.
     std::chrono::time_point<std::chrono::system_clock> expire_time_;
     // if -1, not to check use_count.
@@ -140,15 +140,38 @@ TEST_F(CheckCacheTest, TestCheckResult) {
   result.SetResponse(Status::OK, attributes_, ok_response);
   EXPECT_OK(result.status());
 
+  // The hits share the route directive of the cache entry.
+  SharedRouteDirectivePtr directive;
   for (int i = 0; i < 100; ++i) {
     CheckCache::CheckResult result;
     cache_->Check(attributes_, &result);
     EXPECT_TRUE(result.IsCacheHit());
     EXPECT_OK(result.status());
     EXPECT_EQ(result.route_directive().direct_response_code(), 302);
+    ASSERT_TRUE(result.shared_route_directive() != nullptr);
+    if (directive == nullptr) {
+      directive = result.shared_route_directive();
+    }
+    EXPECT_EQ(result.shared_route_directive(), directive);
   }
 }
 
+TEST_F(CheckCacheTest, TestEmptyRouteDirective) {
+  CheckCache::CheckResult result;
+  cache_->Check(attributes_, &result);
+
+  CheckResponse ok_response;
+  ok_response.mutable_precondition()->set_valid_use_count(1000);
+  result.SetResponse(Status::OK, attributes_, ok_response);
+  EXPECT_EQ(result.shared_route_directive(), nullptr);
+
+  CheckCache::CheckResult hit;
+  cache_->Check(attributes_, &hit);
+  EXPECT_TRUE(hit.IsCacheHit());
+  EXPECT_EQ(hit.shared_route_directive(), nullptr);
+  EXPECT_EQ(hit.route_directive().direct_response_code(), 0);
+}
+
 TEST_F(CheckCacheTest, TestInvalidResult) {
   CheckCache::CheckResult result;
   cache_->Check(attributes_, &result);
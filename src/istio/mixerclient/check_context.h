@@ -69,7 +69,9 @@ class CheckContext : public CheckResponseInfo {
   }
 
   void checkPolicyCache(CheckCache& policyCache) {
-    policyCache.Check(*shared_attributes_->attributes(), &policy_cache_result_);
+    // The deferred string maps are only built on a cache miss.
+    policyCache.Check(*shared_attributes_->partial_attributes(),
+                      &shared_attributes_->deferred(), &policy_cache_result_);
     policy_cache_hit_ = policy_cache_result_.IsCacheHit();
   }
 
@@ -145,7 +147,8 @@ class CheckContext : public CheckResponseInfo {
   void setFinalStatus(const google::protobuf::util::Status& status,
                       bool add_report_attributes = true) {
     if (add_report_attributes) {
-      utils::AttributesBuilder builder(shared_attributes_->attributes());
+      utils::AttributesBuilder builder(
+          shared_attributes_->partial_attributes());
       builder.AddBool(utils::AttributeName::kCheckCacheHit, policy_cache_hit_);
       builder.AddBool(utils::AttributeName::kQuotaCacheHit, quota_cache_hit_);
     }
@@ -197,6 +200,10 @@ class CheckContext : public CheckResponseInfo {
     return policy_cache_result_.route_directive();
   }
 
+  SharedRouteDirectivePtr sharedRouteDirective() const override {
+    return policy_cache_result_.shared_route_directive();
+  }
+
  private:
   CheckContext(const CheckContext&) = delete;
   void operator=(const CheckContext&) = delete;
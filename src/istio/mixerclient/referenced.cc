@@ -60,6 +60,51 @@ bool Decode(int idx, const std::vector<std::string> &global_words,
   return true;
 }
 
+// Finds the deferred string map of an attribute, or returns nullptr.
+const utils::DeferredStringMap *FindDeferred(
+    const utils::DeferredStringMaps *deferred, const std::string &name) {
+  if (deferred != nullptr) {
+    for (const auto &it : *deferred) {
+      if (it.first == name) {
+        return it.second.get();
+      }
+    }
+  }
+  return nullptr;
+}
+
+// The entries of a string map attribute, which are in the attributes or in
+// a deferred string map. The former take precedence like when the deferred
+// map is built.
+class StringMapEntries {
+ public:
+  StringMapEntries(const Attributes_AttributeValue *value,
+                   const utils::DeferredStringMap *deferred)
+      : entries_(value != nullptr ? &value->string_map_value().entries()
+                                  : nullptr),
+        deferred_(deferred) {}
+
+  // Returns the entry of key, or nullptr if there is none. A deferred entry
+  // is copied to scratch.
+  const std::string *Find(const std::string &key,
+                          std::string *scratch) const {
+    if (entries_ != nullptr) {
+      const auto it = entries_->find(key);
+      if (it != entries_->end()) {
+        return &it->second;
+      }
+    }
+    if (deferred_ != nullptr && deferred_->Find(key, scratch)) {
+      return scratch;
+    }
+    return nullptr;
+  }
+
+ private:
+  const ::google::protobuf::Map<std::string, std::string> *entries_;
+  const utils::DeferredStringMap *deferred_;
+};
+
 }  // namespace
 
 // Updates hasher with keys
@@ -118,37 +163,52 @@ bool Referenced::Fill(const Attributes &attributes,
 bool Referenced::Signature(const Attributes &attributes,
                            const std::string &extra_key,
                            utils::HashType *signature) const {
-  if (!CheckAbsentKeys(attributes) || !CheckExactKeys(attributes)) {
+  return Signature(attributes, nullptr, extra_key, signature);
+}
+
+bool Referenced::Signature(const Attributes &attributes,
+                           const utils::DeferredStringMaps *deferred,
+                           const std::string &extra_key,
+                           utils::HashType *signature) const {
+  if (!CheckAbsentKeys(attributes, deferred) ||
+      !CheckExactKeys(attributes, deferred)) {
     return false;
   }
 
-  CalculateSignature(attributes, extra_key, signature);
+  CalculateSignature(attributes, deferred, extra_key, signature);
   return true;
 }
 
-bool Referenced::CheckAbsentKeys(const Attributes &attributes) const {
+bool Referenced::CheckAbsentKeys(
+    const Attributes &attributes,
+    const utils::DeferredStringMaps *deferred) const {
   const auto &attributes_map = attributes.attributes();
+  std::string scratch;
   for (std::size_t i = 0; i < absence_keys_.size(); ++i) {
     const auto &key = absence_keys_[i];
     const auto it = attributes_map.find(key.name);
-    if (it == attributes_map.end()) {
+    const utils::DeferredStringMap *deferred_map =
+        FindDeferred(deferred, key.name);
+    if (it == attributes_map.end() && deferred_map == nullptr) {
       continue;
     }
 
-    const Attributes_AttributeValue &value = it->second;
+    const Attributes_AttributeValue *value =
+        it == attributes_map.end() ? nullptr : &it->second;
     // If an "absence" key exists for a non StringMap attribute, return false
     // for mis-match.
-    if (value.value_case() != Attributes_AttributeValue::kStringMapValue) {
+    if (deferred_map == nullptr &&
+        value->value_case() != Attributes_AttributeValue::kStringMapValue) {
       return false;
     }
 
     std::string map_key = key.map_key;
-    const auto &smap = value.string_map_value().entries();
+    StringMapEntries smap(value, deferred_map);
     // Since absence_keys_ are sorted by key.name,
     // continue processing stringMaps until a new name is found.
     do {
       // if subkey is found, it is a violation of "absence" constrain.
-      if (smap.find(map_key) != smap.end()) {
+      if (smap.Find(map_key, &scratch) != nullptr) {
         return false;
       }
       // Break loop if at the end or at different key
@@ -163,26 +223,32 @@ bool Referenced::CheckAbsentKeys(const Attributes &attributes) const {
   return true;
 }
 
-bool Referenced::CheckExactKeys(const Attributes &attributes) const {
+bool Referenced::CheckExactKeys(
+    const Attributes &attributes,
+    const utils::DeferredStringMaps *deferred) const {
   const auto &attributes_map = attributes.attributes();
+  std::string scratch;
   for (std::size_t i = 0; i < exact_keys_.size(); ++i) {
     const auto &key = exact_keys_[i];
     const auto it = attributes_map.find(key.name);
+    const utils::DeferredStringMap *deferred_map =
+        FindDeferred(deferred, key.name);
     // If an "exact" attribute not present, return false for mismatch.
-    if (it == attributes_map.end()) {
+    if (it == attributes_map.end() && deferred_map == nullptr) {
       return false;
     }
 
-    const Attributes_AttributeValue &value = it->second;
-    if (value.value_case() == Attributes_AttributeValue::kStringMapValue) {
+    const Attributes_AttributeValue *value =
+        it == attributes_map.end() ? nullptr : &it->second;
+    if (deferred_map != nullptr ||
+        value->value_case() == Attributes_AttributeValue::kStringMapValue) {
       std::string map_key = key.map_key;
-      const auto &smap = value.string_map_value().entries();
+      StringMapEntries smap(value, deferred_map);
       // Since exact_keys_ are sorted by key.name,
       // continue processing stringMaps until a new name is found.
       do {
-        const auto sub_it = smap.find(map_key);
         // exact match of map_key is missing
-        if (sub_it == smap.end()) {
+        if (smap.Find(map_key, &scratch) == nullptr) {
           return false;
         }
 
@@ -200,74 +266,84 @@ bool Referenced::CheckExactKeys(const Attributes &attributes) const {
 }
 
 void Referenced::CalculateSignature(const Attributes &attributes,
+                                    const utils::DeferredStringMaps *deferred,
                                     const std::string &extra_key,
                                     utils::HashType *signature) const {
   const auto &attributes_map = attributes.attributes();
 
   utils::ConcatHash hasher(kMaxConcatHashSize);
+  std::string scratch;
   for (std::size_t i = 0; i < exact_keys_.size(); ++i) {
     const auto &key = exact_keys_[i];
     const auto it = attributes_map.find(key.name);
+    const utils::DeferredStringMap *deferred_map =
+        FindDeferred(deferred, key.name);
+    const Attributes_AttributeValue *value =
+        it == attributes_map.end() ? nullptr : &it->second;
 
-    hasher.Update(it->first);
+    hasher.Update(key.name);
     hasher.Update(kDelimiter, kDelimiterLength);
 
-    const Attributes_AttributeValue &value = it->second;
-    switch (value.value_case()) {
+    if (deferred_map != nullptr ||
+        value->value_case() == Attributes_AttributeValue::kStringMapValue) {
+      std::string map_key = key.map_key;
+      StringMapEntries smap(value, deferred_map);
+      // Since exact_keys_ are sorted by key.name,
+      // continue processing stringMaps until a new name is found.
+      do {
+        const std::string *entry = smap.Find(map_key, &scratch);
+
+        hasher.Update(map_key);
+        hasher.Update(kDelimiter, kDelimiterLength);
+        hasher.Update(*entry);
+        hasher.Update(kDelimiter, kDelimiterLength);
+
+        // break loop if at the end or keyname changes.
+        if (i + 1 == exact_keys_.size() ||
+            exact_keys_[i + 1].name != key.name) {
+          break;
+        }
+
+        map_key = exact_keys_[++i].map_key;
+      } while (true);
+      hasher.Update(kDelimiter, kDelimiterLength);
+      continue;
+    }
+
+    switch (value->value_case()) {
       case Attributes_AttributeValue::kStringValue:
-        hasher.Update(value.string_value());
+        hasher.Update(value->string_value());
         break;
       case Attributes_AttributeValue::kBytesValue:
-        hasher.Update(value.bytes_value());
+        hasher.Update(value->bytes_value());
         break;
       case Attributes_AttributeValue::kInt64Value: {
-        auto data = value.int64_value();
+        auto data = value->int64_value();
         hasher.Update(&data, sizeof(data));
       } break;
       case Attributes_AttributeValue::kDoubleValue: {
-        auto data = value.double_value();
+        auto data = value->double_value();
         hasher.Update(&data, sizeof(data));
       } break;
       case Attributes_AttributeValue::kBoolValue: {
-        auto data = value.bool_value();
+        auto data = value->bool_value();
         hasher.Update(&data, sizeof(data));
       } break;
       case Attributes_AttributeValue::kTimestampValue: {
-        auto seconds = value.timestamp_value().seconds();
-        auto nanos = value.timestamp_value().nanos();
+        auto seconds = value->timestamp_value().seconds();
+        auto nanos = value->timestamp_value().nanos();
         hasher.Update(&seconds, sizeof(seconds));
         hasher.Update(kDelimiter, kDelimiterLength);
         hasher.Update(&nanos, sizeof(nanos));
       } break;
       case Attributes_AttributeValue::kDurationValue: {
-        auto seconds = value.duration_value().seconds();
-        auto nanos = value.duration_value().nanos();
+        auto seconds = value->duration_value().seconds();
+        auto nanos = value->duration_value().nanos();
         hasher.Update(&seconds, sizeof(seconds));
         hasher.Update(kDelimiter, kDelimiterLength);
         hasher.Update(&nanos, sizeof(nanos));
       } break;
-      case Attributes_AttributeValue::kStringMapValue: {
-        std::string map_key = key.map_key;
-        const auto &smap = value.string_map_value().entries();
-        // Since exact_keys_ are sorted by key.name,
-        // continue processing stringMaps until a new name is found.
-        do {
-          const auto sub_it = smap.find(map_key);
-
-          hasher.Update(sub_it->first);
-          hasher.Update(kDelimiter, kDelimiterLength);
-          hasher.Update(sub_it->second);
-          hasher.Update(kDelimiter, kDelimiterLength);
-
-          // break loop if at the end or keyname changes.
-          if (i + 1 == exact_keys_.size() ||
-              exact_keys_[i + 1].name != key.name) {
-            break;
-          }
-
-          map_key = exact_keys_[++i].map_key;
-        } while (true);
-      } break;
+      case Attributes_AttributeValue::kStringMapValue:
       case Attributes_AttributeValue::VALUE_NOT_SET:
         break;
     }
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "include/istio/utils/concat_hash.h"
+#include "include/istio/utils/deferred_string_map.h"
 #include "mixer/v1/mixer.pb.h"
 
 namespace istio {
@@ -42,6 +43,13 @@ class Referenced {
                  const std::string &extra_key,
                  utils::HashType *signature) const;
 
+  // Same as above, for attributes whose deferred string maps are not built.
+  // The signature is the same as for the built attributes.
+  bool Signature(const ::istio::mixer::v1::Attributes &attributes,
+                 const utils::DeferredStringMaps *deferred,
+                 const std::string &extra_key,
+                 utils::HashType *signature) const;
+
   // A hash value to identify an instance.
   utils::HashType Hash() const;
 
@@ -50,13 +58,16 @@ class Referenced {
 
  private:
   // Return true if all absent keys are not in the attributes.
-  bool CheckAbsentKeys(const ::istio::mixer::v1::Attributes &attributes) const;
+  bool CheckAbsentKeys(const ::istio::mixer::v1::Attributes &attributes,
+                       const utils::DeferredStringMaps *deferred) const;
 
   // Return true if all exact keys are in the attributes.
-  bool CheckExactKeys(const ::istio::mixer::v1::Attributes &attributes) const;
+  bool CheckExactKeys(const ::istio::mixer::v1::Attributes &attributes,
+                      const utils::DeferredStringMaps *deferred) const;
 
   // Do the actual signature calculation.
   void CalculateSignature(const ::istio::mixer::v1::Attributes &attributes,
+                          const utils::DeferredStringMaps *deferred,
                           const std::string &extra_key,
                           utils::HashType *signature) const;
 
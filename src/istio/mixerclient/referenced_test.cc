@@ -22,6 +22,7 @@
 
 using ::google::protobuf::TextFormat;
 using ::istio::mixer::v1::Attributes;
+using ::istio::mixer::v1::Attributes_StringMap;
 
 namespace istio {
 namespace mixerclient {
@@ -292,6 +293,83 @@ TEST(ReferencedTest, StringMapReferencedTest) {
   EXPECT_FALSE(referenced.Signature(attr4, "extra", &signature));
 }
 
+// A deferred string map which counts how often it is built.
+class TestDeferredStringMap : public utils::DeferredStringMap {
+ public:
+  TestDeferredStringMap(const std::map<std::string, std::string> &entries,
+                        int *build_count)
+      : entries_(entries), build_count_(build_count) {}
+
+  bool Find(const std::string &key, std::string *value) const override {
+    const auto it = entries_.find(key);
+    if (it == entries_.end()) {
+      return false;
+    }
+    *value = it->second;
+    return true;
+  }
+
+  void Build(Attributes_StringMap *map) const override {
+    ++*build_count_;
+    map->mutable_entries()->insert(entries_.begin(), entries_.end());
+  }
+
+ private:
+  std::map<std::string, std::string> entries_;
+  int *build_count_;
+};
+
+TEST(ReferencedTest, DeferredStringMapReferencedTest) {
+  std::map<std::string, std::string> string_map_base = {
+      {"subkey3", "subvalue3"},
+      {"exact-subkey4", "subvalue4"},
+      {"exact-subkey5", "subvalue5"},
+  };
+  ::istio::mixer::v1::Attributes attrs;
+  utils::AttributesBuilder(&attrs).AddString("map-key1", "value1");
+  utils::AttributesBuilder(&attrs).AddStringMap("map-key2", string_map_base);
+
+  ::istio::mixer::v1::ReferencedAttributes pb;
+  ASSERT_TRUE(TextFormat::ParseFromString(kStringMapReferencedText, &pb));
+  Referenced referenced;
+  EXPECT_TRUE(referenced.Fill(attrs, pb));
+
+  utils::HashType signature;
+  EXPECT_TRUE(referenced.Signature(attrs, "extra", &signature));
+
+  // The same signature is calculated from the deferred map without building
+  // it.
+  int build_count = 0;
+  ::istio::mixer::v1::Attributes partial(attrs);
+  partial.mutable_attributes()->erase("map-key2");
+  utils::DeferredStringMaps deferred;
+  deferred.emplace_back("map-key2",
+                        utils::DeferredStringMapPtr(new TestDeferredStringMap(
+                            string_map_base, &build_count)));
+  utils::HashType deferred_signature;
+  EXPECT_TRUE(
+      referenced.Signature(partial, &deferred, "extra", &deferred_signature));
+  EXPECT_EQ(signature, deferred_signature);
+  EXPECT_EQ(build_count, 0);
+
+  // Negative tests: have a absent sub-key
+  std::map<std::string, std::string> string_map3(string_map_base);
+  string_map3["absence-subkey6"] = "subvalue6";
+  deferred[0].second.reset(new TestDeferredStringMap(string_map3,
+                                                     &build_count));
+  EXPECT_FALSE(
+      referenced.Signature(partial, &deferred, "extra", &deferred_signature));
+
+  // Negative tests: miss exact sub-key
+  std::map<std::string, std::string> string_map4(string_map_base);
+  string_map4.erase("exact-subkey4");
+  deferred[0].second.reset(new TestDeferredStringMap(string_map4,
+                                                     &build_count));
+  EXPECT_FALSE(
+      referenced.Signature(partial, &deferred, "extra", &deferred_signature));
+  EXPECT_EQ(build_count, 0);
+}
+
 }  // namespace
 }  // namespace mixerclient
 }  // namespace istio
@@ -16,6 +16,7 @@
 #pragma once
 
 #include "google/protobuf/arena.h"
+#include "include/istio/utils/deferred_string_map.h"
 #include "mixer/v1/attributes.pb.h"
 
 namespace istio {
@@ -31,16 +32,65 @@ class SharedAttributes {
       : attributes_(google::protobuf::Arena::CreateMessage<
                     ::istio::mixer::v1::Attributes>(&arena_)) {}
 
+  // The attributes, with the deferred string maps built.
   const ::istio::mixer::v1::Attributes* attributes() const {
+    BuildDeferred();
     return attributes_;
   }
-  ::istio::mixer::v1::Attributes* attributes() { return attributes_; }
+  ::istio::mixer::v1::Attributes* attributes() {
+    BuildDeferred();
+    return attributes_;
+  }
+
+  // The attributes without the deferred string maps. Use it to add other
+  // attributes, or to read the attributes along with deferred().
+  const ::istio::mixer::v1::Attributes* partial_attributes() const {
+    return attributes_;
+  }
+  ::istio::mixer::v1::Attributes* partial_attributes() { return attributes_; }
+
+  // Defers the string map attribute name until the attributes are read. It
+  // replaces the attribute if it is set already. Entries added to the
+  // attribute afterwards take precedence over the deferred ones.
+  void AddDeferredStringMap(const std::string& name,
+                            utils::DeferredStringMapPtr map) {
+    attributes_->mutable_attributes()->erase(name);
+    deferred_.emplace_back(name, std::move(map));
+  }
+
+  const utils::DeferredStringMaps& deferred() const { return deferred_; }
+
+  // Drops the deferred string maps which are not built yet, when what they
+  // read is about to go away.
+  void DropDeferred() { deferred_.clear(); }
 
   google::protobuf::Arena& arena() { return arena_; }
 
  private:
+  void BuildDeferred() const {
+    if (deferred_.empty()) {
+      return;
+    }
+    auto& attributes = *attributes_->mutable_attributes();
+    for (const auto& it : deferred_) {
+      auto* map = attributes[it.first].mutable_string_map_value();
+      auto* entries = map->mutable_entries();
+      google::protobuf::Map<std::string, std::string> added;
+      added.swap(*entries);
+      it.second->Build(map);
+      for (const auto& entry : added) {
+        (*entries)[entry.first] = entry.second;
+      }
+      if (entries->empty()) {
+        attributes.erase(it.first);
+      }
+    }
+    deferred_.clear();
+  }
+
   google::protobuf::Arena arena_;
   ::istio::mixer::v1::Attributes* attributes_;
+  mutable utils::DeferredStringMaps deferred_;
 };
 
 typedef std::shared_ptr<SharedAttributes> SharedAttributesSharedPtr;
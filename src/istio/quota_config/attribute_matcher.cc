@@ -0,0 +1,207 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "src/istio/quota_config/attribute_matcher.h"
+
+using ::istio::mixer::v1::Attributes;
+using ::istio::mixer::v1::Attributes_AttributeValue;
+using ::istio::mixer::v1::config::client::AttributeMatch;
+using ::istio::mixer::v1::config::client::StringMatch;
+
+namespace istio {
+namespace quota_config {
+
+AttributeMatcher::AttributeIndex::AttributeIndex() : trie(1) {}
+
+AttributeMatcher::AttributeMatcher() {}
+
+AttributeMatcher::~AttributeMatcher() {}
+
+int AttributeMatcher::Add(const AttributeMatch& match) {
+  int id = static_cast<int>(required_.size());
+  required_.push_back(match.clause_size());
+
+  for (const auto& map_it : match.clause()) {
+    // map is attribute_name to StringMatch.
+    AttributeIndex& index = attributes_[map_it.first];
+    const auto& string_match = map_it.second;
+    switch (string_match.match_type_case()) {
+      case StringMatch::kExact:
+        index.exact[string_match.exact()].push_back(id);
+        break;
+      case StringMatch::kPrefix:
+        AddPrefix(&index, string_match.prefix(), id);
+        break;
+      case StringMatch::kRegex:
+        AddRegex(&index, string_match.regex(), id);
+        break;
+      default:
+        // match_type not set case, an empty StringMatch, only requires
+        // the attribute to be present.
+        index.present.push_back(id);
+        break;
+    }
+  }
+  return id;
+}
+
+void AttributeMatcher::AddPrefix(AttributeIndex* index,
+                                 const std::string& prefix, int id) {
+  int node = 0;
+  for (char c : prefix) {
+    auto it = index->trie[node].children.find(c);
+    if (it != index->trie[node].children.end()) {
+      node = it->second;
+      continue;
+    }
+    int child = static_cast<int>(index->trie.size());
+    index->trie[node].children[c] = child;
+    index->trie.emplace_back();
+    node = child;
+  }
+  index->trie[node].ids.push_back(id);
+}
+
+void AttributeMatcher::AddRegex(AttributeIndex* index, const std::string& regex,
+                                int id) {
+  auto it = index->regex_index.find(regex);
+  if (it != index->regex_index.end()) {
+    index->regex_ids[it->second].push_back(id);
+    return;
+  }
+  it = index->std_regex_index.find(regex);
+  if (it != index->std_regex_index.end()) {
+    index->std_regexes[it->second].second.push_back(id);
+    return;
+  }
+
+  if (!index->regex_set) {
+    // std::regex_match semantics: the whole value has to match.
+    re2::RE2::Options options;
+    options.set_log_errors(false);
+    index->regex_set.reset(new re2::RE2::Set(options, re2::RE2::ANCHOR_BOTH));
+  }
+  int pattern = index->regex_set->Add(regex, nullptr);
+  if (pattern < 0) {
+    // ECMAScript regexes may use features RE2 doesn't have. Like before
+    // the regexes were compiled, std::regex throws for invalid ones.
+    index->std_regex_index[regex] = static_cast<int>(index->std_regexes.size());
+    index->std_regexes.emplace_back(std::regex(regex), std::vector<int>{id});
+    return;
+  }
+  GOOGLE_CHECK(pattern == static_cast<int>(index->regex_ids.size()));
+  index->regex_index[regex] = pattern;
+  index->regex_ids.push_back({id});
+}
+
+void AttributeMatcher::Compile() {
+  for (auto& it : attributes_) {
+    auto& index = it.second;
+    if (index.regex_set && !index.regex_set->Compile()) {
+      // Usually too many regexes for the memory budget of one set.
+      GOOGLE_LOG(WARNING) << "Matching the quota regexes of attribute "
+                          << it.first << " one by one";
+      index.regex_set.reset();
+      index.single_regexes.resize(index.regex_ids.size());
+      for (const auto& regex_it : index.regex_index) {
+        index.single_regexes[regex_it.second].reset(
+            new re2::RE2(regex_it.first, re2::RE2::Quiet));
+        if (!index.single_regexes[regex_it.second]->ok()) {
+          // Too large on its own, std::regex has no such limit.
+          GOOGLE_LOG(WARNING) << "Matching quota regex " << regex_it.first
+                              << " with std::regex";
+          index.single_regexes[regex_it.second].reset();
+          index.std_regexes.emplace_back(std::regex(regex_it.first),
+                                         index.regex_ids[regex_it.second]);
+        }
+      }
+    }
+  }
+}
+
+void AttributeMatcher::Match(const Attributes& attributes,
+                             std::vector<bool>* matched) const {
+  // Number of satisfied clauses for each match.
+  std::vector<int> hits(required_.size(), 0);
+  const auto add_hits = [&hits](const std::vector<int>& ids) {
+    for (int id : ids) {
+      ++hits[id];
+    }
+  };
+
+  std::vector<int> regex_matches;
+  const auto& attributes_map = attributes.attributes();
+  for (const auto& it : attributes_) {
+    // Check if required attribure exists with string type.
+    const auto& attr_it = attributes_map.find(it.first);
+    if (attr_it == attributes_map.end() ||
+        attr_it->second.value_case() !=
+            Attributes_AttributeValue::kStringValue) {
+      continue;
+    }
+    const std::string& value = attr_it->second.string_value();
+    const AttributeIndex& index = it.second;
+
+    add_hits(index.present);
+
+    if (!index.exact.empty()) {
+      const auto& exact_it = index.exact.find(value);
+      if (exact_it != index.exact.end()) {
+        add_hits(exact_it->second);
+      }
+    }
+
+    int node = 0;
+    add_hits(index.trie[node].ids);
+    for (char c : value) {
+      const auto& children = index.trie[node].children;
+      const auto& child_it = children.find(c);
+      if (child_it == children.end()) {
+        break;
+      }
+      node = child_it->second;
+      add_hits(index.trie[node].ids);
+    }
+
+    if (index.regex_set) {
+      regex_matches.clear();
+      if (index.regex_set->Match(value, &regex_matches)) {
+        for (int pattern : regex_matches) {
+          add_hits(index.regex_ids[pattern]);
+        }
+      }
+    }
+    for (size_t pattern = 0; pattern < index.single_regexes.size();
+         ++pattern) {
+      if (index.single_regexes[pattern] &&
+          re2::RE2::FullMatch(value, *index.single_regexes[pattern])) {
+        add_hits(index.regex_ids[pattern]);
+      }
+    }
+    for (const auto& std_regex : index.std_regexes) {
+      if (std::regex_match(value, std_regex.first)) {
+        add_hits(std_regex.second);
+      }
+    }
+  }
+
+  matched->assign(required_.size(), false);
+  for (size_t id = 0; id < required_.size(); ++id) {
+    (*matched)[id] = hits[id] == required_[id];
+  }
+}
+
+}  // namespace quota_config
+}  // namespace istio
@@ -0,0 +1,106 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ISTIO_QUOTA_CONFIG_ATTRIBUTE_MATCHER_H_
+#define ISTIO_QUOTA_CONFIG_ATTRIBUTE_MATCHER_H_
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mixer/v1/attributes.pb.h"
+#include "mixer/v1/config/client/quota.pb.h"
+#include "re2/re2.h"
+#include "re2/set.h"
+
+namespace istio {
+namespace quota_config {
+
+// A precompiled form of a list of AttributeMatch.
+//
+// Each AttributeMatch is assigned an integer id. All clauses are grouped by
+// attribute name so that every attribute value is inspected once per call:
+// exact matches are a hash lookup, prefix matches walk a trie and all regex
+// matches of an attribute are evaluated by a single RE2::Set. Regexes RE2
+// doesn't support, such as lookaheads or backreferences, are matched with
+// std::regex, and if the RE2::Set doesn't compile its regexes are matched
+// one by one.
+class AttributeMatcher {
+ public:
+  AttributeMatcher();
+  ~AttributeMatcher();
+
+  // Adds an AttributeMatch and returns its id. All matches must be added
+  // before Compile() is called.
+  int Add(const ::istio::mixer::v1::config::client::AttributeMatch& match);
+
+  // Compiles the added matches. Must be called once before Match().
+  void Compile();
+
+  // Evaluates all matches against the attributes. On return, (*matched)[id]
+  // is true if the AttributeMatch with that id matched.
+  void Match(const ::istio::mixer::v1::Attributes& attributes,
+             std::vector<bool>* matched) const;
+
+  // The number of added matches.
+  int size() const { return static_cast<int>(required_.size()); }
+
+ private:
+  // A prefix trie node, children are indices into AttributeIndex::trie.
+  struct TrieNode {
+    std::unordered_map<char, int> children;
+    // The match ids whose prefix ends at this node.
+    std::vector<int> ids;
+  };
+
+  // All the clauses referencing one attribute.
+  struct AttributeIndex {
+    AttributeIndex();
+
+    // Exact value to match ids.
+    std::unordered_map<std::string, std::vector<int>> exact;
+    // Prefix trie, trie[0] is the root.
+    std::vector<TrieNode> trie;
+    // Regex pattern to its index in regex_ids.
+    std::unordered_map<std::string, int> regex_index;
+    // Match ids for each regex added to regex_set.
+    std::vector<std::vector<int>> regex_ids;
+    std::unique_ptr<re2::RE2::Set> regex_set;
+    // The regexes of regex_set one by one, indexed like regex_ids, if the
+    // set failed to compile.
+    std::vector<std::unique_ptr<re2::RE2>> single_regexes;
+    // Regex pattern to its index in std_regexes, for regexes RE2 rejects.
+    std::unordered_map<std::string, int> std_regex_index;
+    // The regexes RE2 rejects and their match ids.
+    std::vector<std::pair<std::regex, std::vector<int>>> std_regexes;
+    // Match ids with an empty StringMatch, only require the attribute.
+    std::vector<int> present;
+  };
+
+  void AddPrefix(AttributeIndex* index, const std::string& prefix, int id);
+  void AddRegex(AttributeIndex* index, const std::string& regex, int id);
+
+  // Number of clauses each match requires to be satisfied.
+  std::vector<int> required_;
+  // Attribute name to its index.
+  std::unordered_map<std::string, AttributeIndex> attributes_;
+};
+
+}  // namespace quota_config
+}  // namespace istio
+
+#endif  // ISTIO_QUOTA_CONFIG_ATTRIBUTE_MATCHER_H_
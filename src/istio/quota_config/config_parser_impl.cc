@@ -16,91 +16,43 @@
 #include "src/istio/quota_config/config_parser_impl.h"
 
 using ::istio::mixer::v1::Attributes;
-using ::istio::mixer::v1::Attributes_AttributeValue;
-using ::istio::mixer::v1::config::client::AttributeMatch;
-using ::istio::mixer::v1::config::client::QuotaRule;
 using ::istio::mixer::v1::config::client::QuotaSpec;
-using ::istio::mixer::v1::config::client::StringMatch;
 
 namespace istio {
 namespace quota_config {
 
-ConfigParserImpl::ConfigParserImpl(const QuotaSpec& spec_pb)
-    : spec_pb_(spec_pb) {
-  // Build regex map
-  for (const auto& rule : spec_pb_.rules()) {
+ConfigParserImpl::ConfigParserImpl(const QuotaSpec& spec_pb) {
+  // Compile all rules into the matcher.
+  for (const auto& rule : spec_pb.rules()) {
+    rules_.emplace_back();
+    Rule& compiled = rules_.back();
     for (const auto& match : rule.match()) {
-      for (const auto& map_it : match.clause()) {
-        const auto& match = map_it.second;
-        if (match.match_type_case() == StringMatch::kRegex) {
-          regex_map_[match.regex()] = std::regex(match.regex());
-        }
-      }
+      compiled.match_ids.push_back(matcher_.Add(match));
+    }
+    for (const auto& quota : rule.quotas()) {
+      compiled.quotas.push_back({quota.quota(), quota.charge()});
     }
   }
+  matcher_.Compile();
 }
 
 void ConfigParserImpl::GetRequirements(
     const Attributes& attributes, std::vector<Requirement>* results) const {
-  for (const auto& rule : spec_pb_.rules()) {
-    bool matched = false;
-    for (const auto& match : rule.match()) {
-      if (MatchAttributes(match, attributes)) {
-        matched = true;
-        break;
-      }
-    }
+  std::vector<bool> matched;
+  matcher_.Match(attributes, &matched);
+  for (const auto& rule : rules_) {
     // If not match, applies to all requests.
-    if (matched || rule.match_size() == 0) {
-      for (const auto& quota : rule.quotas()) {
-        results->push_back({quota.quota(), quota.charge()});
+    bool applies = rule.match_ids.empty();
+    for (int id : rule.match_ids) {
+      if (matched[id]) {
+        applies = true;
+        break;
       }
     }
-  }
-}
-
-bool ConfigParserImpl::MatchAttributes(const AttributeMatch& match,
-                                       const Attributes& attributes) const {
-  const auto& attributes_map = attributes.attributes();
-  for (const auto& map_it : match.clause()) {
-    // map is attribute_name to StringMatch.
-    const std::string& name = map_it.first;
-    const auto& match = map_it.second;
-
-    // Check if required attribure exists with string type.
-    const auto& it = attributes_map.find(name);
-    if (it == attributes_map.end() ||
-        it->second.value_case() != Attributes_AttributeValue::kStringValue) {
-      return false;
-    }
-    const std::string& value = it->second.string_value();
-
-    switch (match.match_type_case()) {
-      case StringMatch::kExact:
-        if (value != match.exact()) {
-          return false;
-        }
-        break;
-      case StringMatch::kPrefix:
-        if (value.length() < match.prefix().length() ||
-            value.compare(0, match.prefix().length(), match.prefix()) != 0) {
-          return false;
-        }
-        break;
-      case StringMatch::kRegex: {
-        const auto& reg_it = regex_map_.find(match.regex());
-        // All regex should be pre-build.
-        GOOGLE_CHECK(reg_it != regex_map_.end());
-        if (!std::regex_match(value, reg_it->second)) {
-          return false;
-        }
-      } break;
-      default:
-        // match_type not set case, an empty StringMatch, ignore it.
-        break;
+    if (applies) {
+      results->insert(results->end(), rule.quotas.begin(), rule.quotas.end());
     }
   }
-  return true;
 }
 
 std::unique_ptr<ConfigParser> ConfigParser::Create(
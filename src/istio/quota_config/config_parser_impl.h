@@ -16,10 +16,10 @@
 #ifndef ISTIO_QUOTA_CONFIG_CONFIG_PARSER_IMPL_H_
 #define ISTIO_QUOTA_CONFIG_CONFIG_PARSER_IMPL_H_
 
-#include <regex>
-#include <unordered_map>
+#include <vector>
 
 #include "include/istio/quota_config/config_parser.h"
+#include "src/istio/quota_config/attribute_matcher.h"
 
 namespace istio {
 namespace quota_config {
@@ -35,15 +35,19 @@ class ConfigParserImpl : public ConfigParser {
                        std::vector<Requirement>* results) const override;
 
  private:
-  // Check one attribute match.
-  bool MatchAttributes(
-      const ::istio::mixer::v1::config::client::AttributeMatch& match,
-      const ::istio::mixer::v1::Attributes& attributes) const;
-  // the spec proto.
-  const ::istio::mixer::v1::config::client::QuotaSpec& spec_pb_;
-
-  // Stored regex objects.
-  std::unordered_map<std::string, std::regex> regex_map_;
+  // A compiled quota rule.
+  struct Rule {
+    // The AttributeMatch ids in matcher_, the rule applies if any matched.
+    std::vector<int> match_ids;
+    // The quotas to charge if the rule applies.
+    std::vector<Requirement> quotas;
+  };
+
+  // The compiled rules.
+  std::vector<Rule> rules_;
+
+  // The compiled matcher for all rules.
+  AttributeMatcher matcher_;
 };
 
 }  // namespace quota_config
@@ -0,0 +1,90 @@
+/* Copyright 2020 Istio Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "include/istio/quota_config/config_parser.h"
+#include "include/istio/utils/attributes_builder.h"
+
+using ::istio::mixer::v1::Attributes;
+using ::istio::mixer::v1::config::client::QuotaSpec;
+using ::istio::mixer::v1::config::client::StringMatch;
+using ::istio::utils::AttributesBuilder;
+
+namespace istio {
+namespace quota_config {
+namespace {
+
+// Builds a spec with num_rules rules, evenly split between exact, prefix
+// and regex matches on request.path plus an exact match on the method.
+QuotaSpec BuildQuotaSpec(int num_rules) {
+  QuotaSpec spec;
+  for (int i = 0; i < num_rules; ++i) {
+    auto* rule = spec.add_rules();
+    auto* clause = rule->add_match()->mutable_clause();
+    StringMatch& path = (*clause)["request.path"];
+    const std::string id = std::to_string(i);
+    switch (i % 3) {
+      case 0:
+        path.set_exact("/shelves/" + id + "/books");
+        break;
+      case 1:
+        path.set_prefix("/shelves/" + id + "/");
+        break;
+      default:
+        path.set_regex("/shelves/" + id + "/books/[0-9]+");
+        break;
+    }
+    (*clause)["request.http_method"].set_exact("GET");
+    auto* quota = rule->add_quotas();
+    quota->set_quota("quota-" + id);
+    quota->set_charge(1);
+  }
+  return spec;
+}
+
+static void BM_GetRequirements(benchmark::State& state) {
+  const int num_rules = state.range(0);
+  QuotaSpec spec = BuildQuotaSpec(num_rules);
+  auto parser = ConfigParser::Create(spec);
+
+  Attributes attributes;
+  AttributesBuilder builder(&attributes);
+  // Matches the last regex rule, so every rule has to be considered.
+  builder.AddString("request.path",
+                    "/shelves/" + std::to_string(num_rules - 1) + "/books/1");
+  builder.AddString("request.http_method", "GET");
+
+  std::vector<Requirement> requirements;
+  for (auto _ : state) {
+    requirements.clear();
+    parser->GetRequirements(attributes, &requirements);
+    benchmark::DoNotOptimize(requirements);
+  }
+}
+BENCHMARK(BM_GetRequirements)->RangeMultiplier(10)->Range(10, 1000);
+
+}  // namespace
+}  // namespace quota_config
+}  // namespace istio
+
+// Boilerplate main(), which discovers benchmarks in the same file and runs
+// them.
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+}
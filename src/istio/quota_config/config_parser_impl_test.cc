@@ -88,6 +88,102 @@ rules {
 }
 )";
 
+const char kQuotaMultipleRules[] = R"(
+rules {
+  match {
+    clause {
+      key: "request.path"
+      value {
+        prefix: "/books"
+      }
+    }
+  }
+  match {
+    clause {
+      key: "request.path"
+      value {
+        regex: "/shelves/[0-9]+"
+      }
+    }
+  }
+  quotas {
+    quota: "quota1"
+    charge: 1
+  }
+}
+rules {
+  match {
+    clause {
+      key: "request.path"
+      value {
+        prefix: "/books/fiction"
+      }
+    }
+    clause {
+      key: "request.http_method"
+      value {
+      }
+    }
+  }
+  quotas {
+    quota: "quota2"
+    charge: 2
+  }
+}
+rules {
+  match {
+    clause {
+      key: "request.path"
+      value {
+        regex: "/shelves/.*"
+      }
+    }
+    clause {
+      key: "request.http_method"
+      value {
+        exact: "GET"
+      }
+    }
+  }
+  quotas {
+    quota: "quota3"
+    charge: 3
+  }
+}
+)";
+
+// Regexes RE2 doesn't support, a lookahead and a backreference.
+const char kQuotaEcmaScriptRegex[] = R"(
+rules {
+  match {
+    clause {
+      key: "request.path"
+      value {
+        regex: "/shelves/(?!admin).*"
+      }
+    }
+  }
+  quotas {
+    quota: "quota1"
+    charge: 1
+  }
+}
+rules {
+  match {
+    clause {
+      key: "request.path"
+      value {
+        regex: "(/[a-z]+)\\1"
+      }
+    }
+  }
+  quotas {
+    quota: "quota2"
+    charge: 2
+  }
+}
+)";
+
 // Define similar data structure for quota requirement
 // But this one has operator== for comparison so that EXPECT_EQ
 // can directly use its vector.
@@ -170,6 +266,89 @@ TEST(ConfigParserTest, TestRegexMatch) {
   ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota-name", 1}}));
 }
 
+TEST(ConfigParserTest, TestRegexNotSupportedByRe2) {
+  QuotaSpec quota_spec;
+  ASSERT_TRUE(TextFormat::ParseFromString(kQuotaEcmaScriptRegex, &quota_spec));
+  auto parser = ConfigParser::Create(quota_spec);
+
+  Attributes attributes;
+  AttributesBuilder builder(&attributes);
+  builder.AddString("request.path", "/shelves/admin");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV());
+
+  builder.AddString("request.path", "/shelves/1");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota1", 1}}));
+
+  builder.AddString("request.path", "/books/books");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota2", 2}}));
+
+  builder.AddString("request.path", "/books/shelves");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV());
+}
+
+TEST(ConfigParserTest, TestRegexesOverSetBudget) {
+  // Each regex compiles, but too many of them for one RE2::Set.
+  QuotaSpec quota_spec;
+  for (int i = 0; i < 100; ++i) {
+    auto* rule = quota_spec.add_rules();
+    (*rule->add_match()->mutable_clause())["request.path"].set_regex(
+        "/v" + std::to_string(i) + "/(?:[a-z]{1,3}[0-9]){200}");
+    auto* quota = rule->add_quotas();
+    quota->set_quota("quota" + std::to_string(i));
+    quota->set_charge(i);
+  }
+  auto parser = ConfigParser::Create(quota_spec);
+
+  std::string suffix;
+  for (int i = 0; i < 200; ++i) {
+    suffix += "ab1";
+  }
+  Attributes attributes;
+  AttributesBuilder builder(&attributes);
+  builder.AddString("request.path", "/v5/" + suffix);
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota5", 5}}));
+
+  builder.AddString("request.path", "/v99/" + suffix);
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota99", 99}}));
+
+  builder.AddString("request.path", "/v99/" + suffix + "x");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV());
+}
+
+TEST(ConfigParserTest, TestMultipleRulesMatch) {
+  QuotaSpec quota_spec;
+  ASSERT_TRUE(TextFormat::ParseFromString(kQuotaMultipleRules, &quota_spec));
+  auto parser = ConfigParser::Create(quota_spec);
+
+  Attributes attributes;
+  AttributesBuilder builder(&attributes);
+  builder.AddString("request.path", "/book");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV());
+
+  builder.AddString("request.path", "/books/fiction/1");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota1", 1}}));
+
+  // An empty StringMatch only requires the attribute to be present.
+  builder.AddString("request.http_method", "POST");
+  ASSERT_EQ(GetRequirements(*parser, attributes),
+            QV({{"quota1", 1}, {"quota2", 2}}));
+
+  // Regex has to match the whole value.
+  builder.AddString("request.path", "/shelves/10/books");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV());
+
+  builder.AddString("request.path", "/shelves/10");
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota1", 1}}));
+
+  builder.AddString("request.http_method", "GET");
+  ASSERT_EQ(GetRequirements(*parser, attributes),
+            QV({{"quota1", 1}, {"quota3", 3}}));
+
+  // Non string attributes never match.
+  builder.AddInt64("request.http_method", 1);
+  ASSERT_EQ(GetRequirements(*parser, attributes), QV({{"quota1", 1}}));
+}
+
 }  // namespace
 }  // namespace quota_config
 }  // namespace istio